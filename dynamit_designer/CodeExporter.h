@@ -8,6 +8,8 @@
 #include <iomanip>
 #include <fstream>
 
+#include <expression_compiler.h>
+
 #include "ShapeManager.h"
 
 class CodeExporter
@@ -21,18 +23,20 @@ public:
     };
 
     // Generate C++ code from shape configuration
-    static std::wstring generateCppCode(const ShapeConfig& config, ExportMode mode = ExportMode::WithDynamitSetup, bool includeNormals = false)
+    // compiledFormula: emit the formula and its derivative as C++ functions handed to
+    // PolarBuilder, so the exported program does not parse the formula at startup
+    static std::wstring generateCppCode(const ShapeConfig& config, ExportMode mode = ExportMode::WithDynamitSetup, bool includeNormals = false, bool compiledFormula = false)
     {
         switch (mode)
         {
         case ExportMode::GeometryOnly:
-            return generateGeometryOnly(config);
+            return generateGeometryOnly(config, compiledFormula);
         case ExportMode::WithDynamitSetup:
-            return generateWithDynamitSetup(config, includeNormals);
+            return generateWithDynamitSetup(config, includeNormals, compiledFormula);
         case ExportMode::StandaloneApplication:
-            return generateStandaloneApp(config, includeNormals);
+            return generateStandaloneApp(config, includeNormals, compiledFormula);
         default:
-            return generateWithDynamitSetup(config, includeNormals);
+            return generateWithDynamitSetup(config, includeNormals, compiledFormula);
         }
     }
 
@@ -109,7 +113,7 @@ public:
 
 private:
     // Generate geometry building code only
-    static std::wstring generateGeometryOnly(const ShapeConfig& config)
+    static std::wstring generateGeometryOnly(const ShapeConfig& config, bool compiledFormula)
     {
         std::wostringstream code;
 
@@ -120,15 +124,19 @@ private:
         code << L"#include <cmath>\n";
         code << L"#include <vector>\n";
         code << L"#include <cstdint>\n";
+        if (compiledFormula)
+            code << L"#include <limits>\n";
         code << L"#include <builders.h>\n\n";
 
         code << L"using namespace dynamit::builders;\n\n";
 
         std::wstring funcName = sanitizeIdentifier(stringToWstring(config.name));
+        bool compiled = compiledFormula && generateFormulaFunctions(code, config, funcName);
+
         code << L"void build" << funcName << L"()\n";
         code << L"{\n";
 
-        generateBuilderCode(code, config);
+        generateBuilderCode(code, config, compiled ? funcName : L"");
 
         code << L"    std::vector<float> verts, norms, colors;\n";
         code << L"    std::vector<uint32_t> indices;\n\n";
@@ -144,7 +152,7 @@ private:
     }
 
     // Generate builder code + Dynamit setup
-    static std::wstring generateWithDynamitSetup(const ShapeConfig& config, bool includeNormals)
+    static std::wstring generateWithDynamitSetup(const ShapeConfig& config, bool includeNormals, bool compiledFormula)
     {
         std::wostringstream code;
 
@@ -158,16 +166,20 @@ private:
         code << L"#include <vector>\n";
         code << L"#include <cstdint>\n";
         code << L"#include <array>\n";
+        if (compiledFormula)
+            code << L"#include <limits>\n";
         code << L"#include <builders.h>\n";
         code << L"#include <Dynamit.h>\n\n";
 
         code << L"using namespace dynamit;\n";
         code << L"using namespace dynamit::builders;\n\n";
 
+        bool compiled = compiledFormula && generateFormulaFunctions(code, config, funcName);
+
         code << L"void build" << funcName << L"()\n";
         code << L"{\n";
 
-        generateBuilderCode(code, config);
+        generateBuilderCode(code, config, compiled ? funcName : L"");
 
         code << L"    std::vector<float> verts, norms, colors;\n";
         code << L"    std::vector<uint32_t> indices;\n\n";
@@ -213,7 +225,7 @@ private:
     }
 
     // Generate complete standalone application
-    static std::wstring generateStandaloneApp(const ShapeConfig& config, bool includeNormals)
+    static std::wstring generateStandaloneApp(const ShapeConfig& config, bool includeNormals, bool compiledFormula)
     {
         std::wostringstream code;
 
@@ -229,6 +241,8 @@ private:
         code << L"#include <vector>\n";
         code << L"#include <cstdint>\n";
         code << L"#include <array>\n";
+        if (compiledFormula)
+            code << L"#include <limits>\n";
         code << L"#include <memory>\n\n";
 
         code << L"#include <GL/glew.h>\n";
@@ -244,6 +258,9 @@ private:
         code << L"using namespace dynamit;\n";
         code << L"using namespace dynamit::builders;\n\n";
 
+        std::wstring funcName = sanitizeIdentifier(stringToWstring(config.name));
+        bool compiled = compiledFormula && generateFormulaFunctions(code, config, funcName);
+
         code << L"// Global state\n";
         code << L"Camera g_camera(glm::vec3(0.0f, 0.0f, 3.0f));\n";
         code << L"float g_lastX = 512.0f, g_lastY = 384.0f;\n";
@@ -330,7 +347,7 @@ private:
         code << L"    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);\n\n";
 
         code << L"    // Build shape geometry\n";
-        generateBuilderCode(code, config);
+        generateBuilderCode(code, config, compiled ? funcName : L"");
 
         code << L"    std::vector<float> verts, norms, colors;\n";
         code << L"    std::vector<uint32_t> indices;\n\n";
@@ -434,11 +451,51 @@ private:
         return code.str();
     }
 
+    // Formula (and its derivative for smooth shapes) as C++ functions named
+    // formula<Name> / formula<Name>Derivative. Returns false and leaves a note
+    // instead when the formula has no C++ form; the builder then keeps the string.
+    static bool generateFormulaFunctions(std::wostringstream& code, const ShapeConfig& config, const std::wstring& funcName)
+    {
+        namespace et = expresie_tokenizer;
+
+        std::string name = "formula" + wstringToUtf8(funcName);
+        std::string functions;
+        et::cpp::writer out;
+        try
+        {
+            et::basic_expression_token_compiler<double> compiler;
+            std::unique_ptr<et::basic_expression<double>> r = compiler.compile(config.formula);
+            if (!r)
+                throw std::runtime_error("Empty formula");
+            functions = et::cpp_function(*r, name, L"theta", out);
+            if (config.smooth)
+                functions += et::cpp_function(*et::simplify(r->derivative(L"theta")), name + "Derivative", L"theta", out);
+            for (const std::string& variable : out.variables())
+                if (variable != "theta")
+                    throw std::runtime_error("Unbound variable: " + variable);
+        }
+        catch (const std::exception& e)
+        {
+            code << L"// Formula left to the run-time parser: " << stringToWstring(e.what()) << L"\n\n";
+            return false;
+        }
+
+        code << L"// Formula: " << escapeWstring(config.formula) << L"\n";
+        code << stringToWstring(out.helpers() + functions) << L"\n";
+        return true;
+    }
+
     // Generate builder configuration code (shared by all modes)
-    static void generateBuilderCode(std::wostringstream& code, const ShapeConfig& config)
+    // compiledName: name passed to generateFormulaFunctions, empty for the formula string
+    static void generateBuilderCode(std::wostringstream& code, const ShapeConfig& config, const std::wstring& compiledName)
     {
         code << L"    PolarBuilder builder = Builder::polar();\n";
-        code << L"    builder.formula(L\"" << escapeWstring(config.formula) << L"\")\n";
+        if (compiledName.empty())
+            code << L"    builder.formula(L\"" << escapeWstring(config.formula) << L"\")\n";
+        else if (config.smooth)
+            code << L"    builder.formula(formula" << compiledName << L", formula" << compiledName << L"Derivative)\n";
+        else
+            code << L"    builder.formula(formula" << compiledName << L")\n";
         code << L"        .domain(" << formatFloat(config.domainStart) << L"f, " << formatFloat(config.domainEnd) << L"f)\n";
         code << L"        .sectors(" << config.sectors << L")\n";
         code << L"        .slices(" << config.slices << L")\n";
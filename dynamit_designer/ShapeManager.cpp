@@ -6,6 +6,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace dynamit::builders;
@@ -68,30 +69,50 @@ void ShapeManager::rebuildShape(int index)
     if (!shape)
         return;
 
+    // Do only what the edit needs: a shape without a renderer is built from scratch
+    ShapeChange change = shape->renderer ? classifyChange(shape->builtConfig, shape->config) : ShapeChange::Geometry;
+    if (change == ShapeChange::None)
+    {
+        shape->builtConfig = shape->config;
+        shape->dirty = false;
+        return;
+    }
+    if (change == ShapeChange::Colors)
+    {
+        // positions and normals are unchanged, so the normals highlighter keeps its lines
+        writeColors(shape->geometry, shape->config);
+        shape->renderer->updateInterleaved(shape->geometry, false);
+        shape->builtConfig = shape->config;
+        shape->dirty = false;
+        return;
+    }
+
     // Try to build - if formula is invalid, keep existing geometry
-    std::vector<float> newVerts, newNorms, newColors;
-    std::vector<uint32_t> newIndices;
+    InterleavedGeometry newGeometry;
+    newGeometry.layout = InterleavedLayout::of(true, false, true);
 
     try
     {
         // Build based on type
         if (shape->config.type == ShapeConfig::Type::Cone)
         {
-            buildConeData(shape->config, newVerts, newNorms, newColors, newIndices);
+            buildConeData(shape->config, newGeometry);
         }
         else
         {
-            buildCylinderData(shape->config, newVerts, newNorms, newColors, newIndices);
+            buildCylinderData(shape->config, newGeometry);
         }
 
-        // Success - update shape data
-        shape->verts = std::move(newVerts);
-        shape->norms = std::move(newNorms);
-        shape->colors = std::move(newColors);
-        shape->indices = std::move(newIndices);
+        // Success - update shape data; a formula or domain edit keeps the indices
+        bool sameIndices = shape->renderer && newGeometry.indices == shape->geometry.indices;
+        shape->geometry = std::move(newGeometry);
+        shape->builtConfig = shape->config;
 
-        // Setup Dynamit renderer with auto-generated shaders
-        setupDynamitRenderer(*shape);
+        // Setup Dynamit renderer with auto-generated shaders once, refill its buffers after
+        if (shape->renderer)
+            updateDynamitRenderer(*shape, !sameIndices);
+        else
+            setupDynamitRenderer(*shape);
 
         shape->lastError.clear();
     }
@@ -122,9 +143,7 @@ void ShapeManager::rebuildAllDirty()
     }
 }
 
-void ShapeManager::buildConeData(const ShapeConfig& cfg,
-    std::vector<float>& verts, std::vector<float>& norms,
-    std::vector<float>& colors, std::vector<uint32_t>& indices)
+void ShapeManager::buildConeData(const ShapeConfig& cfg, InterleavedGeometry& geometry)
 {
     PolarBuilder builder = Builder::polar();
 
@@ -136,17 +155,18 @@ void ShapeManager::buildConeData(const ShapeConfig& cfg,
         .turbo(cfg.turbo)
         .doubleCoated(cfg.doubleCoated)
         .reversed(cfg.reversed)
-        .color(cfg.outerColor, cfg.innerColor);
+        .color(cfg.outerColor, cfg.innerColor)
+        .threads(0);
 
-    builder.buildConeIndexedWithColor(verts, norms, colors, indices);
+    builder.buildConeInterleaved(geometry);
 
-    std::cout << "Built cone: " << verts.size() / 3 << " vertices, "
-              << indices.size() / 3 << " triangles" << std::endl;
+    FormulaCacheStats cache = PolarBuilder::formulaCacheStats();
+    std::cout << "Built cone: " << geometry.vertexCount() << " vertices, "
+              << geometry.indices.size() / 3 << " triangles (formula cache "
+              << cache.hits << " hits, " << cache.misses << " misses)" << std::endl;
 }
 
-void ShapeManager::buildCylinderData(const ShapeConfig& cfg,
-    std::vector<float>& verts, std::vector<float>& norms,
-    std::vector<float>& colors, std::vector<uint32_t>& indices)
+void ShapeManager::buildCylinderData(const ShapeConfig& cfg, InterleavedGeometry& geometry)
 {
     PolarBuilder builder = Builder::polar();
 
@@ -158,12 +178,15 @@ void ShapeManager::buildCylinderData(const ShapeConfig& cfg,
         .turbo(cfg.turbo)
         .doubleCoated(cfg.doubleCoated)
         .reversed(cfg.reversed)
-        .color(cfg.outerColor, cfg.innerColor);
+        .color(cfg.outerColor, cfg.innerColor)
+        .threads(0);
 
-    builder.buildCylinderIndexedWithColor(verts, norms, colors, indices);
+    builder.buildCylinderInterleaved(geometry);
 
-    std::cout << "Built cylinder: " << verts.size() / 3 << " vertices, "
-              << indices.size() / 3 << " triangles" << std::endl;
+    FormulaCacheStats cache = PolarBuilder::formulaCacheStats();
+    std::cout << "Built cylinder: " << geometry.vertexCount() << " vertices, "
+              << geometry.indices.size() / 3 << " triangles (formula cache "
+              << cache.hits << " hits, " << cache.misses << " misses)" << std::endl;
 }
 
 void ShapeManager::setupDynamitRenderer(ShapeInstance& shape)
@@ -172,22 +195,64 @@ void ShapeManager::setupDynamitRenderer(ShapeInstance& shape)
     shape.renderer = std::make_unique<Dynamit>();
 
     // Configure with our data - shaders are auto-generated based on what we provide
-    shape.renderer->withVertices3d(shape.verts)
-                  .withNormals3d(shape.norms)
-                  .withColors4d(shape.colors)
-                  .withIndices(shape.indices)
+    shape.renderer->withInterleaved(shape.geometry)
                   .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
                   .withTransformMatrix4f("transformMatrix");
 
     // Create NormalsHighlighter for visualizing normals
-    shape.normalsHighlighter = shape.renderer->createNormalsHighlighter(0.05f);
-    shape.normalsHighlighter->build(shape.verts, shape.norms);
+    shape.normalsHighlighter = std::make_unique<NormalsHighlighter>(0.05f);
+    buildNormalsHighlighter(shape);
 
     // Log auto-generated shaders (for debugging)
     std::cout << "Auto-generated shaders for " << shape.config.name << ":" << std::endl;
     shape.renderer->logShaders();
 }
 
+void ShapeManager::updateDynamitRenderer(ShapeInstance& shape, bool indices)
+{
+    // Same layout, so the VAO and the program stay; only the buffer contents change
+    shape.renderer->updateInterleaved(shape.geometry, indices);
+    buildNormalsHighlighter(shape);
+}
+
+void ShapeManager::buildNormalsHighlighter(ShapeInstance& shape)
+{
+    // From the interleaved stream, the highlighter refills its own buffers
+    const InterleavedLayout& layout = shape.geometry.layout;
+    shape.normalsHighlighter->build(shape.geometry.data.data(), shape.geometry.vertexCount(),
+                                    layout.stride, layout.vertex, layout.normal);
+}
+
+ShapeChange ShapeManager::classifyChange(const ShapeConfig& built, const ShapeConfig& edited)
+{
+    if (edited.type != built.type
+        || edited.formula != built.formula
+        || edited.domainStart != built.domainStart || edited.domainEnd != built.domainEnd
+        || edited.sectors != built.sectors || edited.slices != built.slices
+        || edited.smooth != built.smooth || edited.turbo != built.turbo
+        || edited.doubleCoated != built.doubleCoated || edited.reversed != built.reversed)
+        return ShapeChange::Geometry;
+
+    if (edited.outerColor != built.outerColor || edited.innerColor != built.innerColor)
+        return ShapeChange::Colors;
+
+    // Position, rotation and scale go into the model matrix at draw time
+    return ShapeChange::None;
+}
+
+void ShapeManager::writeColors(InterleavedGeometry& geometry, const ShapeConfig& cfg)
+{
+    // The builders write the outer coat first, then the inner coat of a double coated shape
+    const InterleavedLayout& layout = geometry.layout;
+    size_t count = geometry.vertexCount();
+    size_t outer = cfg.doubleCoated ? count / 2 : count;
+    for (size_t v = 0; v < count; v++)
+    {
+        const std::array<float, 4>& color = v < outer ? cfg.outerColor : cfg.innerColor;
+        std::copy(color.begin(), color.end(), geometry.data.begin() + v * layout.stride + layout.color);
+    }
+}
+
 std::array<float, 16> ShapeManager::getTransformMatrix(int index) const
 {
     const ShapeInstance* shape = getShape(index);
@@ -223,7 +288,7 @@ void ShapeManager::render(const std::array<float, 16>& viewProjection, bool show
     {
         ShapeInstance& shape = m_shapes[i];
 
-        if (!shape.visible || !shape.renderer || shape.indices.empty())
+        if (!shape.visible || !shape.renderer || shape.geometry.indices.empty())
             continue;
 
         // Compute MVP = viewProjection * model
@@ -14,6 +14,7 @@
 #include <memory>
 
 #include <Dynamit.h>  // Use dynamit for rendering! (includes NormalsHighlighter.h)
+#include <builders.h>
 
 // Shape configuration
 struct ShapeConfig
@@ -47,16 +48,23 @@ struct ShapeConfig
     std::string name = "Shape";
 };
 
+// What an edit of ShapeConfig invalidates, cheapest first
+enum class ShapeChange
+{
+    None,      // transform or name, read at draw time
+    Colors,    // colour fields of the vertex stream, rewritten in place
+    Geometry   // positions and normals rebuilt into the same renderer
+};
+
 // Shape instance using Dynamit for rendering
 struct ShapeInstance
 {
     ShapeConfig config;
 
-    // CPU buffers (for rebuild)
-    std::vector<float> verts;
-    std::vector<float> norms;
-    std::vector<float> colors;
-    std::vector<uint32_t> indices;
+    // CPU buffers (for rebuild): position, normal and color interleaved, one VBO
+    dynamit::builders::InterleavedGeometry geometry;
+    // The config geometry was built from, edits are diffed against it
+    ShapeConfig builtConfig;
 
     // Dynamit instance for rendering (auto-generates shaders!)
     std::unique_ptr<dynamit::Dynamit> renderer;
@@ -98,13 +106,13 @@ public:
     std::array<float, 16> getTransformMatrix(int index) const;
 
 private:
-    void buildConeData(const ShapeConfig& cfg,
-        std::vector<float>& verts, std::vector<float>& norms,
-        std::vector<float>& colors, std::vector<uint32_t>& indices);
-    void buildCylinderData(const ShapeConfig& cfg,
-        std::vector<float>& verts, std::vector<float>& norms,
-        std::vector<float>& colors, std::vector<uint32_t>& indices);
+    void buildConeData(const ShapeConfig& cfg, dynamit::builders::InterleavedGeometry& geometry);
+    void buildCylinderData(const ShapeConfig& cfg, dynamit::builders::InterleavedGeometry& geometry);
     void setupDynamitRenderer(ShapeInstance& shape);
+    void updateDynamitRenderer(ShapeInstance& shape, bool indices);
+    void buildNormalsHighlighter(ShapeInstance& shape);
+    static ShapeChange classifyChange(const ShapeConfig& built, const ShapeConfig& edited);
+    static void writeColors(dynamit::builders::InterleavedGeometry& geometry, const ShapeConfig& cfg);
 
     std::vector<ShapeInstance> m_shapes;
 };
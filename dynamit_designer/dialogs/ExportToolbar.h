@@ -14,6 +14,7 @@ class DesignerApp;
 #define ID_CHK_INCLUDE_NORMALS  2005
 #define ID_BTN_SAVE_PROJECT     2006
 #define ID_BTN_LOAD_PROJECT     2007
+#define ID_CHK_COMPILED_FORMULA 2008
 
 class ExportToolbar
 {
@@ -38,7 +39,7 @@ public:
             L"ExportToolbarClass",
             L"Export / Project",
             WS_POPUP | WS_CAPTION | WS_VISIBLE,
-            0, 0, 290, 195,
+            0, 0, 290, 217,
             parent, nullptr, GetModuleHandle(nullptr), this);
 
         if (m_hwnd)
@@ -78,38 +79,45 @@ private:
             GetModuleHandle(nullptr), nullptr);
         SendMessage(chkNormals, WM_SETFONT, (WPARAM)hFont, TRUE);
 
+        // Compiled Formula checkbox
+        HWND chkCompiled = CreateWindowW(L"BUTTON", L"Compile Formula to C++ (no parser)",
+            WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            10, 76, 265, 18, m_hwnd, (HMENU)ID_CHK_COMPILED_FORMULA,
+            GetModuleHandle(nullptr), nullptr);
+        SendMessage(chkCompiled, WM_SETFONT, (WPARAM)hFont, TRUE);
+
         // Copy Code button
         HWND btnExportClip = CreateWindowW(L"BUTTON", L"Copy Code",
             WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-            10, 82, 125, 26, m_hwnd, (HMENU)ID_BTN_EXPORT_CLIP,
+            10, 104, 125, 26, m_hwnd, (HMENU)ID_BTN_EXPORT_CLIP,
             GetModuleHandle(nullptr), nullptr);
         SendMessage(btnExportClip, WM_SETFONT, (WPARAM)hFont, TRUE);
 
         // Save Code button
         HWND btnExportFile = CreateWindowW(L"BUTTON", L"Save Code...",
             WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-            145, 82, 125, 26, m_hwnd, (HMENU)ID_BTN_EXPORT_FILE,
+            145, 104, 125, 26, m_hwnd, (HMENU)ID_BTN_EXPORT_FILE,
             GetModuleHandle(nullptr), nullptr);
         SendMessage(btnExportFile, WM_SETFONT, (WPARAM)hFont, TRUE);
 
         // Separator line (static text)
         HWND separator = CreateWindowW(L"STATIC", L"── Project ──",
             WS_CHILD | WS_VISIBLE | SS_CENTER,
-            10, 115, 265, 16, m_hwnd, nullptr,
+            10, 137, 265, 16, m_hwnd, nullptr,
             GetModuleHandle(nullptr), nullptr);
         SendMessage(separator, WM_SETFONT, (WPARAM)hFont, TRUE);
 
         // Save Project button
         HWND btnSaveProject = CreateWindowW(L"BUTTON", L"Save Project...",
             WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-            10, 135, 125, 26, m_hwnd, (HMENU)ID_BTN_SAVE_PROJECT,
+            10, 157, 125, 26, m_hwnd, (HMENU)ID_BTN_SAVE_PROJECT,
             GetModuleHandle(nullptr), nullptr);
         SendMessage(btnSaveProject, WM_SETFONT, (WPARAM)hFont, TRUE);
 
         // Save As button
         HWND btnLoadProject = CreateWindowW(L"BUTTON", L"Save As...",
             WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-            145, 135, 125, 26, m_hwnd, (HMENU)ID_BTN_LOAD_PROJECT,
+            145, 157, 125, 26, m_hwnd, (HMENU)ID_BTN_LOAD_PROJECT,
             GetModuleHandle(nullptr), nullptr);
         SendMessage(btnLoadProject, WM_SETFONT, (WPARAM)hFont, TRUE);
     }
@@ -166,6 +174,7 @@ inline LRESULT ExportToolbar::handleMessage(HWND hwnd, UINT msg, WPARAM wParam,
                     bool includeDynamit = (SendMessage(GetDlgItem(hwnd, ID_CHK_INCLUDE_DYNAMIT), BM_GETCHECK, 0, 0) == BST_CHECKED);
                     bool completeApp = (SendMessage(GetDlgItem(hwnd, ID_CHK_COMPLETE_APP), BM_GETCHECK, 0, 0) == BST_CHECKED);
                     bool includeNormals = (SendMessage(GetDlgItem(hwnd, ID_CHK_INCLUDE_NORMALS), BM_GETCHECK, 0, 0) == BST_CHECKED);
+                    bool compiledFormula = (SendMessage(GetDlgItem(hwnd, ID_CHK_COMPILED_FORMULA), BM_GETCHECK, 0, 0) == BST_CHECKED);
 
                     // Determine export mode
                     CodeExporter::ExportMode mode;
@@ -176,7 +185,7 @@ inline LRESULT ExportToolbar::handleMessage(HWND hwnd, UINT msg, WPARAM wParam,
                     else
                         mode = CodeExporter::ExportMode::GeometryOnly;
 
-                    std::wstring code = CodeExporter::generateCppCode(*config, mode, includeNormals);
+                    std::wstring code = CodeExporter::generateCppCode(*config, mode, includeNormals, compiledFormula);
                     if (CodeExporter::copyToClipboard(code))
                     {
                         MessageBoxW(hwnd, L"C++ code copied to clipboard!", L"Export", MB_OK | MB_ICONINFORMATION);
@@ -203,6 +212,7 @@ inline LRESULT ExportToolbar::handleMessage(HWND hwnd, UINT msg, WPARAM wParam,
                     bool includeDynamit = (SendMessage(GetDlgItem(hwnd, ID_CHK_INCLUDE_DYNAMIT), BM_GETCHECK, 0, 0) == BST_CHECKED);
                     bool completeApp = (SendMessage(GetDlgItem(hwnd, ID_CHK_COMPLETE_APP), BM_GETCHECK, 0, 0) == BST_CHECKED);
                     bool includeNormals = (SendMessage(GetDlgItem(hwnd, ID_CHK_INCLUDE_NORMALS), BM_GETCHECK, 0, 0) == BST_CHECKED);
+                    bool compiledFormula = (SendMessage(GetDlgItem(hwnd, ID_CHK_COMPILED_FORMULA), BM_GETCHECK, 0, 0) == BST_CHECKED);
 
                     // Determine export mode
                     CodeExporter::ExportMode mode;
@@ -213,7 +223,7 @@ inline LRESULT ExportToolbar::handleMessage(HWND hwnd, UINT msg, WPARAM wParam,
                     else
                         mode = CodeExporter::ExportMode::GeometryOnly;
 
-                    std::wstring code = CodeExporter::generateCppCode(*config, mode, includeNormals);
+                    std::wstring code = CodeExporter::generateCppCode(*config, mode, includeNormals, compiledFormula);
                     if (CodeExporter::saveToFile(hwnd, code))
                     {
                         MessageBoxW(hwnd, L"C++ code saved successfully!", L"Export", MB_OK | MB_ICONINFORMATION);
@@ -0,0 +1,282 @@
+#include "enabler.h"
+#ifdef __BENCHMARK_CPP__
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "expression_compiler.h"
+
+using namespace std;
+using namespace expresie_tokenizer;
+
+// Formulas shipped with the samples and the designer presets
+static const wchar_t* benchmark_formulas[] =
+{
+	L"theta / PI",
+	L"(2*PI - theta) / PI",
+	L"1",
+	L"cos(5 * theta)",
+	L"(1 + 0.5 * cos(5 * theta)) / 1.5",
+	L"(1 - cos(theta)) / (PI / 1.55)",
+	L"2 / sqrt(4 * sin(theta)**2 + cos(theta)**2) / 2",
+	L"sqrt(abs(cos(2 * theta)))",
+	L"1+0.5*cos(4*theta)*sin(3*theta)",
+};
+
+static const int benchmark_samples = 1000000;
+
+template <typename T, typename F>
+static double time_ns_per_eval(T& theta, F&& eval, T& checksum)
+{
+	const T step = static_cast<T>(6.283185307179586476925286766559005768L / benchmark_samples);
+	checksum = 0;
+	chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+	for (int i = 0; i < benchmark_samples; i++)
+	{
+		theta = step * static_cast<T>(i);
+		checksum += eval();
+	}
+	chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+	return chrono::duration<double, nano>(t1 - t0).count() / benchmark_samples;
+}
+
+// eval_batch over whole rings of `ring` samples, same theta sweep as time_ns_per_eval
+static double time_ns_per_batch_eval(basic_expression_program<double>& program, size_t ring, double& checksum)
+{
+	const double step = 6.283185307179586476925286766559005768 / benchmark_samples;
+	vector<double> thetas(ring), values(ring);
+	checksum = 0.0;
+	chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+	for (int i = 0; i < benchmark_samples; i += static_cast<int>(ring))
+	{
+		size_t n = min(ring, static_cast<size_t>(benchmark_samples - i));
+		for (size_t k = 0; k < n; k++) thetas[k] = step * (i + k);
+		program.eval_batch(span<const double>(thetas.data(), n), span<double>(values.data(), n));
+		for (size_t k = 0; k < n; k++) checksum += values[k];
+	}
+	chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+	return chrono::duration<double, nano>(t1 - t0).count() / benchmark_samples;
+}
+
+// eval_batch_dual over the same rings: r and dr/dtheta in one pass
+static double time_ns_per_dual_eval(basic_expression_program<double>& program, size_t ring, double& checksum)
+{
+	const double step = 6.283185307179586476925286766559005768 / benchmark_samples;
+	vector<double> thetas(ring), values(ring), derivatives(ring);
+	checksum = 0.0;
+	chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+	for (int i = 0; i < benchmark_samples; i += static_cast<int>(ring))
+	{
+		size_t n = min(ring, static_cast<size_t>(benchmark_samples - i));
+		for (size_t k = 0; k < n; k++) thetas[k] = step * (i + k);
+		program.eval_batch_dual(L"theta", span<const double>(thetas.data(), n),
+			span<double>(values.data(), n), span<double>(derivatives.data(), n));
+		for (size_t k = 0; k < n; k++) checksum += derivatives[k];
+	}
+	chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+	return chrono::duration<double, nano>(t1 - t0).count() / benchmark_samples;
+}
+
+// samples where the double precision batch differs from the long double tree walk
+static size_t count_batch_mismatches(long double& theta, expression& tree, basic_expression_program<double>& program)
+{
+	const size_t n = 4096;
+	vector<double> thetas(n), values(n);
+	for (size_t k = 0; k < n; k++) thetas[k] = 6.283185307179586476925286766559005768 * k / n;
+	program.eval_batch(thetas, values);
+	size_t off = 0;
+	for (size_t k = 0; k < n; k++)
+	{
+		theta = thetas[k];
+		long double expected = tree.eval();
+		if (fabsl(expected - values[k]) > 1e-9L * max(1.0L, fabsl(expected))) off++;
+	}
+	return off;
+}
+
+// largest deviation of a T bytecode program from the long double tree walk
+template <typename T>
+static long double max_abs_error(long double& theta, expression& tree, basic_expression_program<T>& program)
+{
+	const size_t n = 4096;
+	T narrow = 0;
+	program.bind(L"theta", &narrow);
+	long double worst = 0.0L;
+	for (size_t k = 0; k < n; k++)
+	{
+		theta = 6.283185307179586476925286766559005768L * k / n;
+		narrow = static_cast<T>(theta);
+		worst = max(worst, fabsl(tree.eval() - static_cast<long double>(program.eval())));
+	}
+	return worst;
+}
+
+// mean ns of `run` over `repeats` calls
+template <typename F>
+static double time_ns_per_call(int repeats, F&& run)
+{
+	chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+	for (int i = 0; i < repeats; i++) run();
+	chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+	return chrono::duration<double, nano>(t1 - t0).count() / repeats;
+}
+
+// the same formula lowered at T precision, theta bound to `theta`
+template <typename T>
+static unique_ptr<basic_expression_program<T>> compile_at(const wchar_t* formula, bool derivative, T& theta)
+{
+	basic_expression_token_compiler<T> compiler;
+	unique_ptr<basic_expression<T>> tree = compiler.compile(formula);
+	if (derivative) tree = simplify(tree->derivative(L"theta"));
+	unique_ptr<basic_expression_program<T>> program = compile_program(*tree);
+	program->bind(L"theta", &theta);
+	return program;
+}
+
+int main()
+{
+	expression_token_compiler compiler;
+	long double theta = 0.0L;
+	double theta_d = 0.0;
+	float theta_f = 0.0f;
+	const size_t ring = 256;  // sectors per ring in a high-sector designer shape
+
+	wcout << L"tree walk vs bytecode vs eval_batch (" << simd::width << L" lanes, rings of " << ring << L"), "
+		<< benchmark_samples << L" samples of theta in [0, 2*PI), ns per sample" << endl;
+	wcout << left << setw(52) << L"formula" << right
+		<< setw(6) << L"ops" << setw(10) << L"tree" << setw(10) << L"bytecode" << setw(10) << L"batch"
+		<< setw(8) << L"d ops" << setw(10) << L"d tree" << setw(10) << L"bytecode" << setw(10) << L"batch"
+		<< setw(10) << L"r+d dual" << setw(8) << L"d cse" << endl;
+
+	for (const wchar_t* formula : benchmark_formulas)
+	{
+		unique_ptr<expression> tree = compiler.compile(formula);
+		tree->bind(L"theta", &theta);
+		unique_ptr<expression> dtree = simplify(tree->derivative(L"theta"));
+
+		unique_ptr<expression_program> program = compile_program(*tree);
+		unique_ptr<expression_program> dprogram = compile_program(*dtree);
+		program->bind(L"theta", &theta);
+		dprogram->bind(L"theta", &theta);
+		// the builders batch at double precision
+		unique_ptr<basic_expression_program<double>> program_d = compile_at(formula, false, theta_d);
+		unique_ptr<basic_expression_program<double>> dprogram_d = compile_at(formula, true, theta_d);
+
+		long double sum_tree = 0, sum_program = 0, dsum_tree = 0, dsum_program = 0;
+		double sum_batch = 0, dsum_batch = 0;
+		double t_tree     = time_ns_per_eval(theta, [&]() { return tree->eval(); }, sum_tree);
+		double t_program  = time_ns_per_eval(theta, [&]() { return program->eval(); }, sum_program);
+		double t_batch    = time_ns_per_batch_eval(*program_d, ring, sum_batch);
+		double dt_tree    = time_ns_per_eval(theta, [&]() { return dtree->eval(); }, dsum_tree);
+		double dt_program = time_ns_per_eval(theta, [&]() { return dprogram->eval(); }, dsum_program);
+		double dt_batch   = time_ns_per_batch_eval(*dprogram_d, ring, dsum_batch);
+		double dsum_dual  = 0;
+		double t_dual     = time_ns_per_dual_eval(*program_d, ring, dsum_dual);
+
+		wcout << left << setw(52) << formula << right << fixed << setprecision(2)
+			<< setw(6) << program->size()
+			<< setw(10) << t_tree << setw(10) << t_program << setw(10) << t_batch
+			<< setw(8) << dprogram->size()
+			<< setw(10) << dt_tree << setw(10) << dt_program << setw(10) << dt_batch
+			<< setw(10) << t_dual << setw(8) << dprogram->shared_count()
+			<< endl;
+
+		if (sum_tree != sum_program || dsum_tree != dsum_program)
+			wcout << L"   !! bytecode checksum mismatch: " << sum_tree << L" / " << sum_program << endl;
+		// double lanes against the long double reference, sample by sample
+		size_t off = count_batch_mismatches(theta, *tree, *program_d) + count_batch_mismatches(theta, *dtree, *dprogram_d);
+		if (fabs(dsum_dual - dsum_batch) > 1e-9 * max(1.0, fabs(dsum_batch)))
+			wcout << L"   dual: derivative checksum " << dsum_dual << L" vs symbolic " << dsum_batch << endl;
+		if (off)
+			wcout << L"   batch: " << off << L" samples beyond 1e-9 relative (singular points of the formula)" << endl;
+	}
+
+	// The same bytecode instantiated per scalar type
+	wcout << endl << L"bytecode by scalar type, ns per sample / max abs error against the long double tree walk" << endl;
+	wcout << left << setw(52) << L"formula" << right
+		<< setw(12) << L"long double" << setw(10) << L"double" << setw(12) << L"error"
+		<< setw(10) << L"float" << setw(12) << L"error" << endl;
+
+	for (const wchar_t* formula : benchmark_formulas)
+	{
+		unique_ptr<expression> tree = compiler.compile(formula);
+		tree->bind(L"theta", &theta);
+		unique_ptr<expression_program> program = compile_at(formula, false, theta);
+		unique_ptr<basic_expression_program<double>> program_d = compile_at(formula, false, theta_d);
+		unique_ptr<basic_expression_program<float>> program_f = compile_at(formula, false, theta_f);
+
+		long double sum = 0;
+		double sum_d = 0;
+		float sum_f = 0;
+		double t_ld = time_ns_per_eval(theta, [&]() { return program->eval(); }, sum);
+		double t_d  = time_ns_per_eval(theta_d, [&]() { return program_d->eval(); }, sum_d);
+		double t_f  = time_ns_per_eval(theta_f, [&]() { return program_f->eval(); }, sum_f);
+
+		wcout << left << setw(52) << formula << right << fixed << setprecision(2)
+			<< setw(12) << t_ld
+			<< setw(10) << t_d << setw(12) << scientific << setprecision(1) << static_cast<double>(max_abs_error(theta, *tree, *program_d))
+			<< fixed << setprecision(2)
+			<< setw(10) << t_f << setw(12) << scientific << setprecision(1) << static_cast<double>(max_abs_error(theta, *tree, *program_f))
+			<< fixed << endl;
+	}
+
+	// Native code against the tree walk, both at double precision
+	wcout << endl << L"JIT (" << (jit_expression::available() ? L"x86-64" : L"unavailable, tree fallback")
+		<< L") vs tree walk, double, ns per sample" << endl;
+	wcout << left << setw(52) << L"formula" << right
+		<< setw(8) << L"bytes" << setw(10) << L"tree" << setw(10) << L"bytecode" << setw(10) << L"jit" << setw(10) << L"speedup" << endl;
+
+	basic_expression_token_compiler<double> compiler_d;
+	for (const wchar_t* formula : benchmark_formulas)
+	{
+		unique_ptr<basic_expression<double>> tree = compiler_d.compile(formula);
+		tree->bind(L"theta", &theta_d);
+		unique_ptr<basic_expression_program<double>> program_d = compile_at(formula, false, theta_d);
+		jit_expression jit(compiler_d.compile(formula));
+		jit.bind(L"theta", &theta_d);
+
+		double sum_tree = 0, sum_program = 0, sum_jit = 0;
+		double t_tree    = time_ns_per_eval(theta_d, [&]() { return tree->eval(); }, sum_tree);
+		double t_program = time_ns_per_eval(theta_d, [&]() { return program_d->eval(); }, sum_program);
+		double t_jit     = time_ns_per_eval(theta_d, [&]() { return jit.eval(); }, sum_jit);
+
+		wcout << left << setw(52) << formula << right << fixed << setprecision(2)
+			<< setw(8) << jit.code_size()
+			<< setw(10) << t_tree << setw(10) << t_program << setw(10) << t_jit
+			<< setw(9) << t_tree / t_jit << L"x" << endl;
+		if (sum_jit != sum_program)
+			wcout << L"   !! jit checksum mismatch: " << sum_jit << L" / " << sum_program << endl;
+	}
+
+	// Front end: token_map (one heap token per entry) against the flat token buffer
+	const int parse_repeats = 20000;
+	wcout << endl << L"tokenize and parse, " << parse_repeats << L" repeats, ns per formula" << endl;
+	wcout << left << setw(52) << L"formula" << right
+		<< setw(8) << L"tokens" << setw(12) << L"map tok" << setw(12) << L"flat tok"
+		<< setw(12) << L"map parse" << setw(12) << L"flat parse" << setw(10) << L"speedup" << endl;
+
+	expression_token_reader map_reader;
+	flat_token_reader flat_reader;
+	vector<flat_token> flat_tokens;
+	for (const wchar_t* formula : benchmark_formulas)
+	{
+		size_t length = wcslen(formula);
+		flat_reader.tokenize(formula, length, flat_tokens);
+		size_t count = flat_tokens.size();
+		double t_map_tok  = time_ns_per_call(parse_repeats, [&]() { map_reader.tokenize_main(formula); });
+		double t_flat_tok = time_ns_per_call(parse_repeats, [&]() { flat_reader.tokenize(formula, length, flat_tokens); });
+		double t_map      = time_ns_per_call(parse_repeats, [&]() { compiler_d.compile(map_reader.tokenize_main(formula)); });
+		double t_flat     = time_ns_per_call(parse_repeats, [&]() { compiler_d.compile(formula, length); });
+
+		wcout << left << setw(52) << formula << right << fixed << setprecision(0)
+			<< setw(8) << count << setw(12) << t_map_tok << setw(12) << t_flat_tok
+			<< setw(12) << t_map << setw(12) << t_flat
+			<< setw(9) << setprecision(2) << t_map / t_flat << L"x" << endl;
+	}
+	return 0;
+}
+
+#endif
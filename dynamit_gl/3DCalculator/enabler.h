@@ -1,2 +1,4 @@
 #pragma once
 #define __MAIN_CPP__
+//#define __BENCHMARK_CPP__
+//#define __SYNTAX_BENCHMARK_CPP__
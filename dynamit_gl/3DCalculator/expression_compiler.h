@@ -10,7 +10,23 @@
 #include <algorithm>
 #include <locale>
 #include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <cwctype>
 #include "expression_tokenizer.h"
+#include "expression_simd.h"
+#include "expression_interval.h"
+#include "expression_glsl.h"
+#include "expression_cpp.h"
+
+// JIT backend: x86-64 System V only, everything else evaluates the tree
+#if defined(__linux__) && defined(__x86_64__)
+#include <sys/mman.h>
+#include <cstring>
+#define __EXPRESSION_JIT__
+#endif
 
 namespace expresie_tokenizer
 {
@@ -57,6 +73,32 @@ inline bool is_right_associative(binary_operator op)
 	return op == power;
 }
 
+//========================================
+// span - non-owning view over contiguous values
+// Stand-in for std::span, the projects build as C++17
+//========================================
+template <typename T>
+class span
+{
+	T* data_ = nullptr;
+	size_t size_ = 0;
+	
+public:
+	span() = default;
+	span(T* data, size_t size) : data_(data), size_(size) {}
+	
+	// any contiguous container: std::vector, std::array, span<U>
+	template <typename C, typename = decltype(std::declval<C&>().data())>
+	span(C& c) : data_(c.data()), size_(c.size()) {}
+	
+	T* data() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	T& operator[](size_t i) const { return data_[i]; }
+	T* begin() const { return data_; }
+	T* end() const { return data_ + size_; }
+};
+
 //========================================
 // Constant registry - built-in math constants
 //========================================
@@ -122,9 +164,10 @@ public:
 //========================================
 // Expression Context - variable bindings owned by expression
 //========================================
-class expression_context
+template <typename T>
+class basic_expression_context
 {
-	std::unordered_map<std::wstring, long double*> bindings_;
+	std::unordered_map<std::wstring, T*> bindings_;
 	
 	static std::wstring to_lower(const std::wstring& name)
 	{
@@ -134,15 +177,15 @@ class expression_context
 	}
 	
 public:
-	expression_context() = default;
+	basic_expression_context() = default;
 	
 	// Copyable and movable
-	expression_context(const expression_context&) = default;
-	expression_context& operator=(const expression_context&) = default;
-	expression_context(expression_context&&) = default;
-	expression_context& operator=(expression_context&&) = default;
+	basic_expression_context(const basic_expression_context&) = default;
+	basic_expression_context& operator=(const basic_expression_context&) = default;
+	basic_expression_context(basic_expression_context&&) = default;
+	basic_expression_context& operator=(basic_expression_context&&) = default;
 	
-	void bind(const std::wstring& name, long double* ptr)
+	void bind(const std::wstring& name, T* ptr)
 	{
 		bindings_[to_lower(name)] = ptr;
 	}
@@ -157,9 +200,9 @@ public:
 		bindings_.clear();
 	}
 	
-	long double* get(const std::wstring& name) const
+	T* get(const std::wstring& name) const
 	{
-		std::unordered_map<std::wstring, long double*>::const_iterator it = bindings_.find(to_lower(name));
+		typename std::unordered_map<std::wstring, T*>::const_iterator it = bindings_.find(to_lower(name));
 		return (it != bindings_.end()) ? it->second : nullptr;
 	}
 	
@@ -175,145 +218,178 @@ public:
 };
 
 
-class binary_expression;
-class expression
+template <typename T> class basic_binary_expression;
+template <typename T> class basic_expression_program;
+template <typename T>
+class basic_expression
 {
 protected:
-	expression_context context_;  // Each expression owns its context
+	basic_expression_context<T> context_;  // Each expression owns its context
 	
 public:
 	// Context management
-	expression_context& context() { return context_; }
-	const expression_context& context() const { return context_; }
+	basic_expression_context<T>& context() { return context_; }
+	const basic_expression_context<T>& context() const { return context_; }
 	
-	void bind(const std::wstring& name, long double* ptr) { context_.bind(name, ptr); }
+	void bind(const std::wstring& name, T* ptr) { context_.bind(name, ptr); }
 	void unbind(const std::wstring& name) { context_.unbind(name); }
 	
-	virtual long double eval() = 0;
+	virtual T eval() = 0;
 	
 	// Cylindrical coordinate transformations
 	// Expression evaluates to r, theta is passed as argument
 	// cyl_x(theta) = r * cos(theta) where r = eval()
-	long double cyl_x(long double theta)
+	T cyl_x(T theta)
 	{
-		return eval() * std::cosl(theta);
+		return eval() * std::cos(theta);
 	}
 	
 	// cyl_y(theta) = r * sin(theta) where r = eval()
-	long double cyl_y(long double theta)
+	T cyl_y(T theta)
 	{
-		return eval() * std::sinl(theta);
+		return eval() * std::sin(theta);
 	}
 	
 	virtual bool is_unary() = 0;
 	virtual bool is_binary() = 0;
 	virtual bool is_subexpression() = 0;
 	virtual bool is_constant() = 0;
-	virtual expression*        get_left() = 0;
-	virtual expression*        get_right() = 0;
-	virtual binary_expression* get_binary() = 0;
-	virtual void               set_left(expression* exp) = 0;
-	virtual void               set_right(expression* exp) = 0;
+	virtual basic_expression<T>*        get_left() = 0;
+	virtual basic_expression<T>*        get_right() = 0;
+	virtual basic_binary_expression<T>* get_binary() = 0;
+	virtual void                        set_left(basic_expression<T>* exp) = 0;
+	virtual void                        set_right(basic_expression<T>* exp) = 0;
 	
 	// Symbolic differentiation - returns new expression tree
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt) = 0;
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt) = 0;
 	
 	// Clone expression tree
-	virtual std::unique_ptr<expression> clone() = 0;
+	virtual std::unique_ptr<basic_expression<T>> clone() = 0;
+	
+	// Lower into flat bytecode - returns the register holding this node's value
+	virtual unsigned int emit(basic_expression_program<T>& program) = 0;
+	
+	// Conservative range: eval() with `wrt` anywhere in `range` lands inside the result
+	// Other variables are read as points from their bindings
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range) = 0;
 	
-	virtual ~expression() = default;
+	// GLSL float expression for the shader; helpers and free variables are collected in `out`
+	virtual std::string glsl(glsl::writer& out) = 0;
+	
+	// C++ double expression for ahead-of-time export, same collection in `out`
+	virtual std::string cpp(cpp::writer& out) = 0;
+	
+	virtual ~basic_expression() = default;
 };
 
 // Forward declarations for helper functions
-std::unique_ptr<expression> make_constant(long double value);
-std::unique_ptr<expression> make_binary(binary_operator op, std::unique_ptr<expression> left, std::unique_ptr<expression> right);
-std::unique_ptr<expression> make_unary_func(long double (*func)(long double), std::unique_ptr<expression> arg);
-std::unique_ptr<expression> make_binary_func(long double (*func)(long double, long double), std::unique_ptr<expression> arg1, std::unique_ptr<expression> arg2);
+template <typename T>
+std::unique_ptr<basic_expression<T>> make_constant(T value);
+template <typename T>
+std::unique_ptr<basic_expression<T>> make_binary(binary_operator op, std::unique_ptr<basic_expression<T>> left, std::unique_ptr<basic_expression<T>> right);
+template <typename T>
+std::unique_ptr<basic_expression<T>> make_unary_func(T (*func)(T), std::unique_ptr<basic_expression<T>> arg);
+template <typename T>
+std::unique_ptr<basic_expression<T>> make_binary_func(T (*func)(T, T), std::unique_ptr<basic_expression<T>> arg1, std::unique_ptr<basic_expression<T>> arg2);
 
-class constant_expression : public expression
+template <typename T>
+class basic_constant_expression : public basic_expression<T>
 {
 public:
-	virtual binary_expression* get_binary() { return nullptr; }
+	virtual basic_binary_expression<T>* get_binary() { return nullptr; }
 	virtual bool is_constant() { return true; }
 	virtual bool is_subexpression() { return false; }
 };
 
-class sub_expression : public expression
+template <typename T>
+class basic_sub_expression : public basic_expression<T>
 {
 public:
-	std::unique_ptr<expression> inner_expression = nullptr;
-	sub_expression() {}
-	virtual long double eval() { return inner_expression->eval(); }
+	std::unique_ptr<basic_expression<T>> inner_expression = nullptr;
+	basic_sub_expression() {}
+	virtual T eval() { return inner_expression->eval(); }
 	virtual bool is_unary() { return true; }
 	virtual bool is_binary() { return false; }
 	virtual bool is_subexpression() { return true; }
 	virtual bool is_constant() { return inner_expression->is_constant(); }
 
-	virtual expression*        get_left() { return nullptr; }
-	virtual expression*        get_right() { return nullptr; }
-	virtual binary_expression* get_binary() { return nullptr; }
-	virtual void               set_left(expression* exp) {}
-	virtual void               set_right(expression* exp) {}
+	virtual basic_expression<T>*        get_left() { return nullptr; }
+	virtual basic_expression<T>*        get_right() { return nullptr; }
+	virtual basic_binary_expression<T>* get_binary() { return nullptr; }
+	virtual void                        set_left(basic_expression<T>* exp) {}
+	virtual void                        set_right(basic_expression<T>* exp) {}
 	
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
 		return inner_expression->derivative(wrt);
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<sub_expression> c = std::make_unique<sub_expression>();
+		std::unique_ptr<basic_sub_expression<T>> c = std::make_unique<basic_sub_expression<T>>();
 		c->inner_expression = inner_expression->clone();
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
-class number_constant_expression : public constant_expression
+template <typename T>
+class basic_number_constant_expression : public basic_constant_expression<T>
 {
 public:
-	long double number = 0.0L;
+	T number = 0;
 
-	virtual long double eval() { return number; }
+	virtual T eval() { return number; }
 	virtual bool is_unary() { return true; }
 	virtual bool is_binary() { return false; }
-	virtual expression* get_left() { return nullptr; }
-	virtual expression* get_right() { return nullptr; }
-	virtual void set_left(expression* exp) {}
-	virtual void set_right(expression* exp) {}
+	virtual basic_expression<T>* get_left() { return nullptr; }
+	virtual basic_expression<T>* get_right() { return nullptr; }
+	virtual void set_left(basic_expression<T>* exp) {}
+	virtual void set_right(basic_expression<T>* exp) {}
 	
 	// d/dx(c) = 0
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
-		return make_constant(0.0L);
+		return make_constant(T(0));
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<number_constant_expression> c = std::make_unique<number_constant_expression>();
+		std::unique_ptr<basic_number_constant_expression<T>> c = std::make_unique<basic_number_constant_expression<T>>();
 		c->number = number;
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
 //========================================
 // Variable Expression - looks up in root expression's context
 //========================================
-class variable_expression : public expression
+template <typename T>
+class basic_variable_expression : public basic_expression<T>
 {
 public:
 	std::wstring name;
-	expression* root = nullptr;  // pointer to root expression that owns the context
-	long double* cached_ptr = nullptr;  // cached for performance
+	basic_expression<T>* root = nullptr;  // pointer to root expression that owns the context
+	T* cached_ptr = nullptr;  // cached for performance
 	
-	variable_expression(const std::wstring& var_name) : name(var_name) {}
+	basic_variable_expression(const std::wstring& var_name) : name(var_name) {}
 	
-	void set_root(expression* r) 
+	void set_root(basic_expression<T>* r) 
 	{ 
 		root = r; 
 		cached_ptr = nullptr;  // invalidate cache
 	}
 	
-	long double eval() override
+	T eval() override
 	{
 		// Try cached pointer first
 		if (cached_ptr)
@@ -337,14 +413,14 @@ public:
 	virtual bool is_binary() { return false; }
 	virtual bool is_subexpression() { return false; }
 	virtual bool is_constant() { return false; }
-	virtual expression* get_left() { return nullptr; }
-	virtual expression* get_right() { return nullptr; }
-	virtual binary_expression* get_binary() { return nullptr; }
-	virtual void set_left(expression* exp) {}
-	virtual void set_right(expression* exp) {}
+	virtual basic_expression<T>* get_left() { return nullptr; }
+	virtual basic_expression<T>* get_right() { return nullptr; }
+	virtual basic_binary_expression<T>* get_binary() { return nullptr; }
+	virtual void set_left(basic_expression<T>* exp) {}
+	virtual void set_right(basic_expression<T>* exp) {}
 	
 	// d/dx(x) = 1, d/dx(y) = 0
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
 		std::wstring lname = name;
 		std::transform(lname.begin(), lname.end(), lname.begin(), towlower);
@@ -352,33 +428,39 @@ public:
 		std::transform(lwrt.begin(), lwrt.end(), lwrt.begin(), towlower);
 		
 		if (lname == lwrt)
-			return make_constant(1.0L);
+			return make_constant(T(1));
 		else
-			return make_constant(0.0L);
+			return make_constant(T(0));
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<variable_expression> c = std::make_unique<variable_expression>(name);
+		std::unique_ptr<basic_variable_expression<T>> c = std::make_unique<basic_variable_expression<T>>(name);
 		c->root = root;
 		c->cached_ptr = nullptr;
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
 //========================================
 // Unary Expression (prefix operators: +, -)
 //========================================
-class unary_expression : public expression
+template <typename T>
+class basic_unary_expression : public basic_expression<T>
 {
 public:
-	std::unique_ptr<expression> operand = nullptr;
+	std::unique_ptr<basic_expression<T>> operand = nullptr;
 	unary_operator op = unary_unknown;
 
 	// Function pointer for evaluation
-	long double (*eval_func)(long double) = nullptr;
+	T (*eval_func)(T) = nullptr;
 
-	long double eval() override
+	T eval() override
 	{
 		return eval_func(operand->eval());
 	}
@@ -388,22 +470,22 @@ public:
 	virtual bool is_constant() { return operand->is_constant(); }
 	virtual bool is_subexpression() { return false; }
 
-	virtual expression* get_left() { return nullptr; }
-	virtual expression* get_right() { return nullptr; }
-	virtual binary_expression* get_binary() { return nullptr; }
-	virtual void set_left(expression* exp) {}
-	virtual void set_right(expression* exp) {}
+	virtual basic_expression<T>* get_left() { return nullptr; }
+	virtual basic_expression<T>* get_right() { return nullptr; }
+	virtual basic_binary_expression<T>* get_binary() { return nullptr; }
+	virtual void set_left(basic_expression<T>* exp) {}
+	virtual void set_right(basic_expression<T>* exp) {}
 	
 	// d/dx(-u) = -du/dx
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
-		std::unique_ptr<expression> du = operand->derivative(wrt);
+		std::unique_ptr<basic_expression<T>> du = operand->derivative(wrt);
 		
 		if (op == unary_minus)
 		{
-			std::unique_ptr<unary_expression> result = std::make_unique<unary_expression>();
+			std::unique_ptr<basic_unary_expression<T>> result = std::make_unique<basic_unary_expression<T>>();
 			result->op = unary_minus;
-			result->eval_func = [](long double a) { return -a; };
+			result->eval_func = [](T a) { return -a; };
 			result->operand = std::move(du);
 			return result;
 		}
@@ -411,26 +493,32 @@ public:
 		return du;
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<unary_expression> c = std::make_unique<unary_expression>();
+		std::unique_ptr<basic_unary_expression<T>> c = std::make_unique<basic_unary_expression<T>>();
 		c->op = op;
 		c->eval_func = eval_func;
 		c->operand = operand->clone();
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
-class binary_expression : public expression
+template <typename T>
+class basic_binary_expression : public basic_expression<T>
 {
 public:
-	std::unique_ptr<expression> left = nullptr, right = nullptr;
+	std::unique_ptr<basic_expression<T>> left = nullptr, right = nullptr;
 	binary_operator op = expresie_tokenizer::unknown;
 
 	// Function pointer for direct evaluation - no switch/case overhead
-	long double (*eval_func_discrete)(long double, long double) = nullptr;
+	T (*eval_func_discrete)(T, T) = nullptr;
 
-	long double eval()
+	T eval()
 	{
 		return eval_func_discrete(left->eval(), right->eval());
 	}
@@ -440,16 +528,16 @@ public:
 	virtual bool is_constant()      { return left->is_constant() && right->is_constant(); }
 	virtual bool is_subexpression() { return false; }
 
-	virtual expression* get_left() { return left.release(); }
-	virtual expression* get_right() { return right.release(); }
-	virtual binary_expression* get_binary() { return this; }
-	virtual void set_left(expression* exp) { left.reset(exp); }
-	virtual void set_right(expression* exp) { return right.reset(exp); }
+	virtual basic_expression<T>* get_left() { return left.release(); }
+	virtual basic_expression<T>* get_right() { return right.release(); }
+	virtual basic_binary_expression<T>* get_binary() { return this; }
+	virtual void set_left(basic_expression<T>* exp) { left.reset(exp); }
+	virtual void set_right(basic_expression<T>* exp) { return right.reset(exp); }
 	
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
-		std::unique_ptr<expression> dl = left->derivative(wrt);
-		std::unique_ptr<expression> dr = right->derivative(wrt);
+		std::unique_ptr<basic_expression<T>> dl = left->derivative(wrt);
+		std::unique_ptr<basic_expression<T>> dr = right->derivative(wrt);
 		
 		switch (op)
 		{
@@ -480,12 +568,12 @@ public:
 			// For variable exponent: a^b * (db*ln(a) + b*da/a) - not implemented yet
 			if (right->is_constant())
 			{
-				long double exp_val = right->eval();
+				T exp_val = right->eval();
 				// b * a^(b-1) * da
 				return make_binary(multiply,
 					make_binary(multiply,
 						make_constant(exp_val),
-						make_binary(power, left->clone(), make_constant(exp_val - 1.0L))),
+						make_binary(power, left->clone(), make_constant(exp_val - T(1)))),
 					std::move(dl));
 			}
 			else
@@ -498,28 +586,34 @@ public:
 		}
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<binary_expression> c = std::make_unique<binary_expression>();
+		std::unique_ptr<basic_binary_expression<T>> c = std::make_unique<basic_binary_expression<T>>();
 		c->op = op;
 		c->eval_func_discrete = eval_func_discrete;
 		c->left = left->clone();
 		c->right = right->clone();
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
 //========================================
 // Unary function expression - single argument, direct function pointer
 //========================================
-class unary_function_expression : public expression
+template <typename T>
+class basic_unary_function_expression : public basic_expression<T>
 {
 public:
-	std::unique_ptr<expression> arg;
-	long double (*func)(long double) = nullptr;
-	long double (*deriv_func)(long double) = nullptr;  // derivative of the function itself
+	std::unique_ptr<basic_expression<T>> arg;
+	T (*func)(T) = nullptr;
+	T (*deriv_func)(T) = nullptr;  // derivative of the function itself
 	
-	long double eval() override
+	T eval() override
 	{
 		return func(arg->eval());
 	}
@@ -528,19 +622,19 @@ public:
 	virtual bool is_binary() { return false; }
 	virtual bool is_subexpression() { return false; }
 	virtual bool is_constant() { return arg->is_constant(); }
-	virtual expression* get_left() { return nullptr; }
-	virtual expression* get_right() { return nullptr; }
-	virtual binary_expression* get_binary() { return nullptr; }
-	virtual void set_left(expression* exp) {}
-	virtual void set_right(expression* exp) {}
+	virtual basic_expression<T>* get_left() { return nullptr; }
+	virtual basic_expression<T>* get_right() { return nullptr; }
+	virtual basic_binary_expression<T>* get_binary() { return nullptr; }
+	virtual void set_left(basic_expression<T>* exp) {}
+	virtual void set_right(basic_expression<T>* exp) {}
 	
 	// d/dx(f(u)) = f'(u) * du/dx  (chain rule)
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
 		if (!deriv_func)
 			throw std::runtime_error("No derivative defined for this function");
 		
-		std::unique_ptr<expression> du = arg->derivative(wrt);
+		std::unique_ptr<basic_expression<T>> du = arg->derivative(wrt);
 		
 		// f'(u) * du
 		return make_binary(multiply,
@@ -548,30 +642,36 @@ public:
 			std::move(du));
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<unary_function_expression> c = std::make_unique<unary_function_expression>();
+		std::unique_ptr<basic_unary_function_expression<T>> c = std::make_unique<basic_unary_function_expression<T>>();
 		c->func = func;
 		c->deriv_func = deriv_func;
 		c->arg = arg->clone();
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
 //========================================
 // Binary function expression - two arguments, direct function pointer
 //========================================
-class binary_function_expression : public expression
+template <typename T>
+class basic_binary_function_expression : public basic_expression<T>
 {
 public:
-	std::unique_ptr<expression> arg1;
-	std::unique_ptr<expression> arg2;
-	long double (*func)(long double, long double) = nullptr;
+	std::unique_ptr<basic_expression<T>> arg1;
+	std::unique_ptr<basic_expression<T>> arg2;
+	T (*func)(T, T) = nullptr;
 	// Partial derivatives
-	long double (*deriv_func_arg1)(long double, long double) = nullptr;  // ∂f/∂arg1
-	long double (*deriv_func_arg2)(long double, long double) = nullptr;  // ∂f/∂arg2
+	T (*deriv_func_arg1)(T, T) = nullptr;  // ∂f/∂arg1
+	T (*deriv_func_arg2)(T, T) = nullptr;  // ∂f/∂arg2
 	
-	long double eval() override
+	T eval() override
 	{
 		return func(arg1->eval(), arg2->eval());
 	}
@@ -580,20 +680,20 @@ public:
 	virtual bool is_binary() { return true; }
 	virtual bool is_subexpression() { return false; }
 	virtual bool is_constant() { return arg1->is_constant() && arg2->is_constant(); }
-	virtual expression* get_left() { return nullptr; }
-	virtual expression* get_right() { return nullptr; }
-	virtual binary_expression* get_binary() { return nullptr; }
-	virtual void set_left(expression* exp) {}
-	virtual void set_right(expression* exp) {}
+	virtual basic_expression<T>* get_left() { return nullptr; }
+	virtual basic_expression<T>* get_right() { return nullptr; }
+	virtual basic_binary_expression<T>* get_binary() { return nullptr; }
+	virtual void set_left(basic_expression<T>* exp) {}
+	virtual void set_right(basic_expression<T>* exp) {}
 	
 	// d/dx(f(u,v)) = ∂f/∂u * du/dx + ∂f/∂v * dv/dx
-	virtual std::unique_ptr<expression> derivative(const std::wstring& wrt)
+	virtual std::unique_ptr<basic_expression<T>> derivative(const std::wstring& wrt)
 	{
 		if (!deriv_func_arg1 || !deriv_func_arg2)
 			throw std::runtime_error("No partial derivatives defined for this function");
 		
-		std::unique_ptr<expression> du = arg1->derivative(wrt);
-		std::unique_ptr<expression> dv = arg2->derivative(wrt);
+		std::unique_ptr<basic_expression<T>> du = arg1->derivative(wrt);
+		std::unique_ptr<basic_expression<T>> dv = arg2->derivative(wrt);
 		
 		// ∂f/∂u * du + ∂f/∂v * dv
 		return make_binary(plus,
@@ -605,9 +705,9 @@ public:
 				std::move(dv)));
 	}
 	
-	virtual std::unique_ptr<expression> clone()
+	virtual std::unique_ptr<basic_expression<T>> clone()
 	{
-		std::unique_ptr<binary_function_expression> c = std::make_unique<binary_function_expression>();
+		std::unique_ptr<basic_binary_function_expression<T>> c = std::make_unique<basic_binary_function_expression<T>>();
 		c->func = func;
 		c->deriv_func_arg1 = deriv_func_arg1;
 		c->deriv_func_arg2 = deriv_func_arg2;
@@ -615,21 +715,28 @@ public:
 		c->arg2 = arg2->clone();
 		return c;
 	}
+	
+	virtual unsigned int emit(basic_expression_program<T>& program);
+	virtual basic_interval<T> eval_interval(const std::wstring& wrt, const basic_interval<T>& range);
+	virtual std::string glsl(glsl::writer& out);
+	virtual std::string cpp(cpp::writer& out);
 };
 
 //========================================
 // Helper functions for building expressions
 //========================================
-inline std::unique_ptr<expression> make_constant(long double value)
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> make_constant(T value)
 {
-	std::unique_ptr<number_constant_expression> c = std::make_unique<number_constant_expression>();
+	std::unique_ptr<basic_number_constant_expression<T>> c = std::make_unique<basic_number_constant_expression<T>>();
 	c->number = value;
 	return c;
 }
 
-inline std::unique_ptr<expression> make_binary(binary_operator op, std::unique_ptr<expression> left, std::unique_ptr<expression> right)
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> make_binary(binary_operator op, std::unique_ptr<basic_expression<T>> left, std::unique_ptr<basic_expression<T>> right)
 {
-	std::unique_ptr<binary_expression> b = std::make_unique<binary_expression>();
+	std::unique_ptr<basic_binary_expression<T>> b = std::make_unique<basic_binary_expression<T>>();
 	b->op = op;
 	b->left = std::move(left);
 	b->right = std::move(right);
@@ -637,19 +744,19 @@ inline std::unique_ptr<expression> make_binary(binary_operator op, std::unique_p
 	switch (op)
 	{
 	case plus:
-		b->eval_func_discrete = [](long double a, long double b) { return a + b; };
+		b->eval_func_discrete = [](T a, T b) { return a + b; };
 		break;
 	case minus:
-		b->eval_func_discrete = [](long double a, long double b) { return a - b; };
+		b->eval_func_discrete = [](T a, T b) { return a - b; };
 		break;
 	case multiply:
-		b->eval_func_discrete = [](long double a, long double b) { return a * b; };
+		b->eval_func_discrete = [](T a, T b) { return a * b; };
 		break;
 	case divide:
-		b->eval_func_discrete = [](long double a, long double b) { return a / b; };
+		b->eval_func_discrete = [](T a, T b) { return a / b; };
 		break;
 	case power:
-		b->eval_func_discrete = [](long double a, long double b) { return std::powl(a, b); };
+		b->eval_func_discrete = [](T a, T b) { return std::pow(a, b); };
 		break;
 	default:
 		break;
@@ -657,18 +764,20 @@ inline std::unique_ptr<expression> make_binary(binary_operator op, std::unique_p
 	return b;
 }
 
-inline std::unique_ptr<expression> make_unary_func(long double (*func)(long double), std::unique_ptr<expression> arg)
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> make_unary_func(T (*func)(T), std::unique_ptr<basic_expression<T>> arg)
 {
-	std::unique_ptr<unary_function_expression> f = std::make_unique<unary_function_expression>();
+	std::unique_ptr<basic_unary_function_expression<T>> f = std::make_unique<basic_unary_function_expression<T>>();
 	f->func = func;
 	f->arg = std::move(arg);
 	// deriv_func not set - caller must set if needed
 	return f;
 }
 
-inline std::unique_ptr<expression> make_binary_func(long double (*func)(long double, long double), std::unique_ptr<expression> arg1, std::unique_ptr<expression> arg2)
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> make_binary_func(T (*func)(T, T), std::unique_ptr<basic_expression<T>> arg1, std::unique_ptr<basic_expression<T>> arg2)
 {
-	std::unique_ptr<binary_function_expression> f = std::make_unique<binary_function_expression>();
+	std::unique_ptr<basic_binary_function_expression<T>> f = std::make_unique<basic_binary_function_expression<T>>();
 	f->func = func;
 	f->arg1 = std::move(arg1);
 	f->arg2 = std::move(arg2);
@@ -679,11 +788,16 @@ inline std::unique_ptr<expression> make_binary_func(long double (*func)(long dou
 //========================================
 // Function registry - stores both unary and binary function pointers
 //========================================
-class function_registry
+template <typename T>
+class basic_function_registry
 {
 public:
-	using unary_fn_t = long double (*)(long double);
-	using binary_fn_t = long double (*)(long double, long double);
+	using unary_fn_t = T (*)(T);
+	using binary_fn_t = T (*)(T, T);
+	using batch_fn_t = simd::batch_fn_t;
+	using dual_batch_fn_t = simd::dual_batch_fn_t;
+	using unary_interval_fn_t = basic_interval<T> (*)(basic_interval<T>);
+	using binary_interval_fn_t = basic_interval<T> (*)(basic_interval<T>, basic_interval<T>);
 	
 	struct function_entry
 	{
@@ -697,6 +811,14 @@ public:
 	
 private:
 	std::unordered_map<std::wstring, function_entry> map_;
+	std::unordered_map<unary_fn_t, batch_fn_t> batch_map_;  // scalar function -> vectorized kernel
+	std::unordered_map<unary_fn_t, dual_batch_fn_t> dual_map_;  // scalar function -> value + derivative kernel
+	std::unordered_map<unary_fn_t, unary_interval_fn_t> interval_map_;  // scalar function -> interval version
+	std::unordered_map<binary_fn_t, binary_interval_fn_t> binary_interval_map_;
+	std::unordered_map<unary_fn_t, const glsl::function*> glsl_map_;  // scalar function -> GLSL spelling
+	std::unordered_map<binary_fn_t, const glsl::function*> binary_glsl_map_;
+	std::unordered_map<unary_fn_t, const cpp::function*> cpp_map_;  // scalar function -> C++ spelling
+	std::unordered_map<binary_fn_t, const cpp::function*> binary_cpp_map_;
 	
 	static std::wstring to_lower(const std::wstring& name)
 	{
@@ -705,42 +827,121 @@ private:
 		return lname;
 	}
 	
-	function_registry()
+	basic_function_registry()
 	{
 		// Register unary functions with their derivatives
-		register_unary(L"sin", std::sinl, std::cosl);
-		register_unary(L"cos", std::cosl, [](long double x) { return -std::sinl(x); });
-		register_unary(L"tan", std::tanl, [](long double x) { long double c = std::cosl(x); return 1.0L / (c * c); });
-		register_unary(L"sqrt", std::sqrtl, [](long double x) { return 0.5L / std::sqrtl(x); });
-		register_unary(L"exp", std::expl, std::expl);
-		register_unary(L"log", std::logl, [](long double x) { return 1.0L / x; });
-		register_unary(L"abs", std::fabsl, [](long double x) { return x >= 0 ? 1.0L : -1.0L; });
-		register_unary(L"asin", std::asinl, [](long double x) { return 1.0L / std::sqrtl(1.0L - x * x); });
-		register_unary(L"acos", std::acosl, [](long double x) { return -1.0L / std::sqrtl(1.0L - x * x); });
-		register_unary(L"atan", std::atanl, [](long double x) { return 1.0L / (1.0L + x * x); });
-		register_unary(L"sinh", std::sinhl, std::coshl);
-		register_unary(L"cosh", std::coshl, std::sinhl);
-		register_unary(L"tanh", std::tanhl, [](long double x) { long double t = std::tanhl(x); return 1.0L - t * t; });
-		register_unary(L"floor", std::floorl, nullptr);
-		register_unary(L"ceil", std::ceill, nullptr);
-		register_unary(L"round", std::roundl, nullptr);
+		// Lambdas pick the std overload for T, so float/double/long double share one table
+		register_unary(L"sin", [](T x) { return std::sin(x); }, [](T x) { return std::cos(x); });
+		register_unary(L"cos", [](T x) { return std::cos(x); }, [](T x) { return -std::sin(x); });
+		register_unary(L"tan", [](T x) { return std::tan(x); }, [](T x) { T c = std::cos(x); return T(1) / (c * c); });
+		register_unary(L"sqrt", [](T x) { return std::sqrt(x); }, [](T x) { return T(0.5) / std::sqrt(x); });
+		register_unary(L"exp", [](T x) { return std::exp(x); }, [](T x) { return std::exp(x); });
+		register_unary(L"log", [](T x) { return std::log(x); }, [](T x) { return T(1) / x; });
+		register_unary(L"abs", [](T x) { return std::fabs(x); }, [](T x) { return x >= 0 ? T(1) : T(-1); });
+		register_unary(L"asin", [](T x) { return std::asin(x); }, [](T x) { return T(1) / std::sqrt(T(1) - x * x); });
+		register_unary(L"acos", [](T x) { return std::acos(x); }, [](T x) { return T(-1) / std::sqrt(T(1) - x * x); });
+		register_unary(L"atan", [](T x) { return std::atan(x); }, [](T x) { return T(1) / (T(1) + x * x); });
+		register_unary(L"sinh", [](T x) { return std::sinh(x); }, [](T x) { return std::cosh(x); });
+		register_unary(L"cosh", [](T x) { return std::cosh(x); }, [](T x) { return std::sinh(x); });
+		register_unary(L"tanh", [](T x) { return std::tanh(x); }, [](T x) { T t = std::tanh(x); return T(1) - t * t; });
+		register_unary(L"floor", [](T x) { return std::floor(x); }, nullptr);
+		register_unary(L"ceil", [](T x) { return std::ceil(x); }, nullptr);
+		register_unary(L"round", [](T x) { return std::round(x); }, nullptr);
+		
+		// Vectorized kernels for eval_batch: the function, its derivative, both fused
+		register_batch(L"sin", simd::sin_batch, simd::cos_batch, simd::sin_dual_batch);
+		register_batch(L"cos", simd::cos_batch, simd::neg_sin_batch, simd::cos_dual_batch);
+		register_batch(L"tan", simd::tan_batch, simd::sec2_batch, simd::tan_dual_batch);
+		register_batch(L"sqrt", simd::sqrt_batch, simd::half_rsqrt_batch, simd::sqrt_dual_batch);
+		register_batch(L"exp", simd::exp_batch, simd::exp_batch, simd::exp_dual_batch);
+		register_batch(L"log", simd::log_batch, simd::reciprocal_batch, simd::log_dual_batch);
+		register_batch(L"abs", simd::abs_batch, simd::sign_batch, simd::abs_dual_batch);
 		
 		// Register binary functions with partial derivatives
-		register_binary(L"pow", std::powl,
-			[](long double a, long double b) { return b * std::powl(a, b - 1.0L); },
-			[](long double a, long double b) { return std::powl(a, b) * std::logl(a); });
-		register_binary(L"atan2", std::atan2l,
-			[](long double y, long double x) { return x / (x * x + y * y); },
-			[](long double y, long double x) { return -y / (x * x + y * y); });
-		register_binary(L"fmod", std::fmodl, nullptr, nullptr);
-		register_binary(L"min", [](long double a, long double b) { return a < b ? a : b; }, nullptr, nullptr);
-		register_binary(L"max", [](long double a, long double b) { return a > b ? a : b; }, nullptr, nullptr);
+		register_binary(L"pow", [](T a, T b) { return std::pow(a, b); },
+			[](T a, T b) { return b * std::pow(a, b - T(1)); },
+			[](T a, T b) { return std::pow(a, b) * std::log(a); });
+		register_binary(L"atan2", [](T y, T x) { return std::atan2(y, x); },
+			[](T y, T x) { return x / (x * x + y * y); },
+			[](T y, T x) { return -y / (x * x + y * y); });
+		register_binary(L"fmod", [](T a, T b) { return std::fmod(a, b); }, nullptr, nullptr);
+		register_binary(L"min", [](T a, T b) { return a < b ? a : b; }, nullptr, nullptr);
+		register_binary(L"max", [](T a, T b) { return a > b ? a : b; }, nullptr, nullptr);
+		
+		// Interval versions for eval_interval, each encloses every value of the function on its argument range
+		register_interval(L"sin", intervals::sin<T>);
+		register_interval(L"cos", intervals::cos<T>);
+		register_interval(L"tan", intervals::tan<T>);
+		register_interval(L"sqrt", intervals::sqrt<T>);
+		register_interval(L"exp", intervals::exp<T>);
+		register_interval(L"log", intervals::log<T>);
+		register_interval(L"abs", intervals::abs<T>);
+		register_interval(L"asin", intervals::asin<T>);
+		register_interval(L"acos", intervals::acos<T>);
+		register_interval(L"atan", intervals::atan<T>);
+		register_interval(L"sinh", intervals::sinh<T>);
+		register_interval(L"cosh", intervals::cosh<T>);
+		register_interval(L"tanh", intervals::tanh<T>);
+		register_interval(L"floor", intervals::floor<T>);
+		register_interval(L"ceil", intervals::ceil<T>);
+		register_interval(L"round", intervals::round<T>);
+		register_interval(L"pow", intervals::pow<T>);
+		register_interval(L"atan2", intervals::atan2<T>);
+		register_interval(L"fmod", intervals::fmod<T>);
+		register_interval(L"min", intervals::min<T>);
+		register_interval(L"max", intervals::max<T>);
+		
+		// GLSL spellings for glsl(): the function, then its derivative or partial derivatives
+		register_glsl(L"sin", "sin", "cos");
+		register_glsl(L"cos", "cos", "dyn_d_cos");
+		register_glsl(L"tan", "tan", "dyn_d_tan");
+		register_glsl(L"sqrt", "sqrt", "dyn_d_sqrt");
+		register_glsl(L"exp", "exp", "exp");
+		register_glsl(L"log", "log", "dyn_d_log");
+		register_glsl(L"abs", "abs", "dyn_d_abs");
+		register_glsl(L"asin", "asin", "dyn_d_asin");
+		register_glsl(L"acos", "acos", "dyn_d_acos");
+		register_glsl(L"atan", "atan", "dyn_d_atan");
+		register_glsl(L"sinh", "sinh", "cosh");
+		register_glsl(L"cosh", "cosh", "sinh");
+		register_glsl(L"tanh", "tanh", "dyn_d_tanh");
+		register_glsl(L"floor", "floor", nullptr);
+		register_glsl(L"ceil", "ceil", nullptr);
+		register_glsl(L"round", "dyn_round", nullptr);
+		register_glsl(L"pow", "dyn_pow", "dyn_d_pow_a", "dyn_d_pow_b");
+		register_glsl(L"atan2", "atan", "dyn_d_atan2_y", "dyn_d_atan2_x");
+		register_glsl(L"fmod", "dyn_fmod", nullptr, nullptr);
+		register_glsl(L"min", "min", nullptr, nullptr);
+		register_glsl(L"max", "max", nullptr, nullptr);
+		
+		// C++ spellings for cpp(), same layout as the GLSL ones
+		register_cpp(L"sin", "std::sin", "std::cos");
+		register_cpp(L"cos", "std::cos", "dyn_d_cos");
+		register_cpp(L"tan", "std::tan", "dyn_d_tan");
+		register_cpp(L"sqrt", "std::sqrt", "dyn_d_sqrt");
+		register_cpp(L"exp", "std::exp", "std::exp");
+		register_cpp(L"log", "std::log", "dyn_d_log");
+		register_cpp(L"abs", "std::fabs", "dyn_d_abs");
+		register_cpp(L"asin", "std::asin", "dyn_d_asin");
+		register_cpp(L"acos", "std::acos", "dyn_d_acos");
+		register_cpp(L"atan", "std::atan", "dyn_d_atan");
+		register_cpp(L"sinh", "std::sinh", "std::cosh");
+		register_cpp(L"cosh", "std::cosh", "std::sinh");
+		register_cpp(L"tanh", "std::tanh", "dyn_d_tanh");
+		register_cpp(L"floor", "std::floor", nullptr);
+		register_cpp(L"ceil", "std::ceil", nullptr);
+		register_cpp(L"round", "std::round", nullptr);
+		register_cpp(L"pow", "std::pow", "dyn_d_pow_a", "dyn_d_pow_b");
+		register_cpp(L"atan2", "std::atan2", "dyn_d_atan2_y", "dyn_d_atan2_x");
+		register_cpp(L"fmod", "std::fmod", nullptr, nullptr);
+		register_cpp(L"min", "dyn_min", nullptr, nullptr);
+		register_cpp(L"max", "dyn_max", nullptr, nullptr);
 	}
 	
 public:
-	static function_registry& instance()
+	static basic_function_registry<T>& instance()
 	{
-		static function_registry inst;
+		static basic_function_registry<T> inst;
 		return inst;
 	}
 	
@@ -763,6 +964,65 @@ public:
 		map_[to_lower(name)] = entry;
 	}
 	
+	// Attach vectorized kernels to an already registered unary function
+	void register_batch(const std::wstring& name, batch_fn_t f, batch_fn_t deriv, dual_batch_fn_t dual = nullptr)
+	{
+		const function_entry* entry = get(name);
+		if (!entry || entry->arity != 1) return;
+		if (entry->unary_func && f) batch_map_[entry->unary_func] = f;
+		if (entry->unary_deriv && deriv) batch_map_[entry->unary_deriv] = deriv;
+		if (entry->unary_func && dual) dual_map_[entry->unary_func] = dual;
+	}
+	
+	// Attach the interval version to an already registered function
+	void register_interval(const std::wstring& name, unary_interval_fn_t f)
+	{
+		const function_entry* entry = get(name);
+		if (entry && entry->arity == 1 && entry->unary_func) interval_map_[entry->unary_func] = f;
+	}
+	
+	void register_interval(const std::wstring& name, binary_interval_fn_t f)
+	{
+		const function_entry* entry = get(name);
+		if (entry && entry->arity == 2 && entry->binary_func) binary_interval_map_[entry->binary_func] = f;
+	}
+	
+	// Attach GLSL spellings (glsl::find names) to an already registered function
+	void register_glsl(const std::wstring& name, const char* f, const char* deriv)
+	{
+		const function_entry* entry = get(name);
+		if (!entry || entry->arity != 1) return;
+		if (entry->unary_func && f) glsl_map_[entry->unary_func] = glsl::find(f);
+		if (entry->unary_deriv && deriv) glsl_map_[entry->unary_deriv] = glsl::find(deriv);
+	}
+	
+	void register_glsl(const std::wstring& name, const char* f, const char* deriv_arg1, const char* deriv_arg2)
+	{
+		const function_entry* entry = get(name);
+		if (!entry || entry->arity != 2) return;
+		if (entry->binary_func && f) binary_glsl_map_[entry->binary_func] = glsl::find(f);
+		if (entry->binary_deriv_arg1 && deriv_arg1) binary_glsl_map_[entry->binary_deriv_arg1] = glsl::find(deriv_arg1);
+		if (entry->binary_deriv_arg2 && deriv_arg2) binary_glsl_map_[entry->binary_deriv_arg2] = glsl::find(deriv_arg2);
+	}
+	
+	// Attach C++ spellings (cpp::find names) to an already registered function
+	void register_cpp(const std::wstring& name, const char* f, const char* deriv)
+	{
+		const function_entry* entry = get(name);
+		if (!entry || entry->arity != 1) return;
+		if (entry->unary_func && f) cpp_map_[entry->unary_func] = cpp::find(f);
+		if (entry->unary_deriv && deriv) cpp_map_[entry->unary_deriv] = cpp::find(deriv);
+	}
+	
+	void register_cpp(const std::wstring& name, const char* f, const char* deriv_arg1, const char* deriv_arg2)
+	{
+		const function_entry* entry = get(name);
+		if (!entry || entry->arity != 2) return;
+		if (entry->binary_func && f) binary_cpp_map_[entry->binary_func] = cpp::find(f);
+		if (entry->binary_deriv_arg1 && deriv_arg1) binary_cpp_map_[entry->binary_deriv_arg1] = cpp::find(deriv_arg1);
+		if (entry->binary_deriv_arg2 && deriv_arg2) binary_cpp_map_[entry->binary_deriv_arg2] = cpp::find(deriv_arg2);
+	}
+	
 	bool has(const std::wstring& name) const
 	{
 		return map_.find(to_lower(name)) != map_.end();
@@ -770,234 +1030,1515 @@ public:
 	
 	const function_entry* get(const std::wstring& name) const
 	{
-		std::unordered_map<std::wstring, function_entry>::const_iterator it = map_.find(to_lower(name));
+		typename std::unordered_map<std::wstring, function_entry>::const_iterator it = map_.find(to_lower(name));
 		if (it == map_.end()) return nullptr;
 		return &it->second;
 	}
+	
+	// Vectorized kernel for a scalar function pointer, nullptr if none
+	batch_fn_t get_batch(unary_fn_t f) const
+	{
+		typename std::unordered_map<unary_fn_t, batch_fn_t>::const_iterator it = batch_map_.find(f);
+		return (it != batch_map_.end()) ? it->second : nullptr;
+	}
+	
+	// Fused value + derivative kernel for a scalar function pointer, nullptr if none
+	dual_batch_fn_t get_dual(unary_fn_t f) const
+	{
+		typename std::unordered_map<unary_fn_t, dual_batch_fn_t>::const_iterator it = dual_map_.find(f);
+		return (it != dual_map_.end()) ? it->second : nullptr;
+	}
+	
+	// Interval version of a scalar function pointer, nullptr if none
+	unary_interval_fn_t get_interval(unary_fn_t f) const
+	{
+		typename std::unordered_map<unary_fn_t, unary_interval_fn_t>::const_iterator it = interval_map_.find(f);
+		return (it != interval_map_.end()) ? it->second : nullptr;
+	}
+	
+	binary_interval_fn_t get_interval(binary_fn_t f) const
+	{
+		typename std::unordered_map<binary_fn_t, binary_interval_fn_t>::const_iterator it = binary_interval_map_.find(f);
+		return (it != binary_interval_map_.end()) ? it->second : nullptr;
+	}
+	
+	// GLSL spelling of a scalar function pointer, nullptr if none
+	const glsl::function* get_glsl(unary_fn_t f) const
+	{
+		typename std::unordered_map<unary_fn_t, const glsl::function*>::const_iterator it = glsl_map_.find(f);
+		return (it != glsl_map_.end()) ? it->second : nullptr;
+	}
+	
+	const glsl::function* get_glsl(binary_fn_t f) const
+	{
+		typename std::unordered_map<binary_fn_t, const glsl::function*>::const_iterator it = binary_glsl_map_.find(f);
+		return (it != binary_glsl_map_.end()) ? it->second : nullptr;
+	}
+	
+	// C++ spelling of a scalar function pointer, nullptr if none
+	const cpp::function* get_cpp(unary_fn_t f) const
+	{
+		typename std::unordered_map<unary_fn_t, const cpp::function*>::const_iterator it = cpp_map_.find(f);
+		return (it != cpp_map_.end()) ? it->second : nullptr;
+	}
+	
+	const cpp::function* get_cpp(binary_fn_t f) const
+	{
+		typename std::unordered_map<binary_fn_t, const cpp::function*>::const_iterator it = binary_cpp_map_.find(f);
+		return (it != binary_cpp_map_.end()) ? it->second : nullptr;
+	}
 };
 
 //========================================
-// Constant folding - simplify expression if constant
+// Algebraic simplification - bottom-up rewrite pass
+// Constant subtrees fold wherever they appear, identities drop out
+// (x*1, x+0, x-0, x/1, 0*x, x^1, x^0, --x, +x), constant divisors become
+// reciprocal multiplies, small integer powers become multiply chains and
+// constants meeting across a + or * chain fold together. Derivative trees
+// are full of *1 and +0 nodes, each one a virtual call per vertex.
 //========================================
-inline std::unique_ptr<expression> simplify(std::unique_ptr<expression> expr)
+template <typename T>
+inline bool is_number(basic_expression<T>* expr, T& value)
+{
+	basic_number_constant_expression<T>* c = dynamic_cast<basic_number_constant_expression<T>*>(expr);
+	if (!c) return false;
+	value = c->number;
+	return true;
+}
+
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> make_negate(std::unique_ptr<basic_expression<T>> operand)
+{
+	std::unique_ptr<basic_unary_expression<T>> n = std::make_unique<basic_unary_expression<T>>();
+	n->op = unary_minus;
+	n->eval_func = [](T a) { return -a; };
+	n->operand = std::move(operand);
+	return n;
+}
+
+// x^n by repeated squaring: x^2 = x*x, x^3 = x*(x*x), x^-n = 1/x^n
+// the repeated base is cloned; compile_program shares it again
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> make_power_chain(std::unique_ptr<basic_expression<T>> base, int n)
+{
+	if (n < 0)
+		return make_binary(divide, make_constant(T(1)), make_power_chain(std::move(base), -n));
+	std::unique_ptr<basic_expression<T>> result = nullptr;
+	std::unique_ptr<basic_expression<T>> square = std::move(base);
+	for (;;)
+	{
+		if (n & 1)
+			result = result ? make_binary(multiply, std::move(result), square->clone()) : square->clone();
+		n >>= 1;
+		if (!n) break;
+		std::unique_ptr<basic_expression<T>> copy = square->clone();
+		square = make_binary(multiply, std::move(copy), std::move(square));
+	}
+	return result;
+}
+
+// integer exponents up to this magnitude are rewritten as multiply chains
+const int simplify_max_power_chain = 16;
+
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> simplify_node(std::unique_ptr<basic_expression<T>> expr);
+
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> simplify_binary(std::unique_ptr<basic_expression<T>> expr, basic_binary_expression<T>* b)
+{
+	T lv = 0, rv = 0;
+	bool lc = is_number(b->left.get(), lv);
+	bool rc = is_number(b->right.get(), rv);
+
+	switch (b->op)
+	{
+	case plus:
+		if (lc && lv == T(0)) return std::move(b->right);
+		if (rc && rv == T(0)) return std::move(b->left);
+		break;
+	case minus:
+		if (rc && rv == T(0)) return std::move(b->left);
+		if (lc && lv == T(0)) return make_negate(std::move(b->right));
+		break;
+	case multiply:
+		if ((lc && lv == T(0)) || (rc && rv == T(0))) return make_constant(T(0));
+		if (lc && lv == T(1)) return std::move(b->right);
+		if (rc && rv == T(1)) return std::move(b->left);
+		if (lc && lv == T(-1)) return make_negate(std::move(b->right));
+		if (rc && rv == T(-1)) return make_negate(std::move(b->left));
+		break;
+	case divide:
+		if (rc && rv == T(1)) return std::move(b->left);
+		// x / c = x * (1/c), folds further if x is itself a constant product
+		if (rc && rv != T(0))
+			return simplify_node(make_binary(multiply, std::move(b->left), make_constant(T(1) / rv)));
+		break;
+	case power:
+		if (rc && rv == T(0)) return make_constant(T(1));
+		if (rc && rv == T(1)) return std::move(b->left);
+		if (lc && lv == T(1)) return make_constant(T(1));
+		if (rc && rv == std::floor(rv) && std::fabs(rv) <= T(simplify_max_power_chain))
+			return make_power_chain(std::move(b->left), static_cast<int>(rv));
+		return expr;
+	default:
+		return expr;
+	}
+
+	// c1 + (c2 + x) = (c1 + c2) + x, same for *, on either side
+	if ((b->op == plus || b->op == multiply) && (lc != rc))
+	{
+		T c = lc ? lv : rv;
+		std::unique_ptr<basic_expression<T>>& other = lc ? b->right : b->left;
+		basic_binary_expression<T>* inner = other->get_binary();
+		T ic = 0;
+		if (inner && inner->op == b->op)
+		{
+			std::unique_ptr<basic_expression<T>>* rest = nullptr;
+			if (is_number(inner->left.get(), ic)) rest = &inner->right;
+			else if (is_number(inner->right.get(), ic)) rest = &inner->left;
+			if (rest)
+			{
+				T folded = (b->op == plus) ? c + ic : c * ic;
+				return simplify_node(make_binary(b->op, make_constant(folded), std::move(*rest)));
+			}
+		}
+	}
+	return expr;
+}
+
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> simplify_node(std::unique_ptr<basic_expression<T>> expr)
 {
 	if (expr->is_constant())
+		return make_constant(expr->eval());
+
+	if (basic_sub_expression<T>* s = dynamic_cast<basic_sub_expression<T>*>(expr.get()))
+		return simplify_node(std::move(s->inner_expression));
+
+	if (basic_unary_expression<T>* u = dynamic_cast<basic_unary_expression<T>*>(expr.get()))
+	{
+		u->operand = simplify_node(std::move(u->operand));
+		if (u->op == unary_plus) return std::move(u->operand);
+		basic_unary_expression<T>* inner = dynamic_cast<basic_unary_expression<T>*>(u->operand.get());
+		if (u->op == unary_minus && inner && inner->op == unary_minus)
+			return std::move(inner->operand);
+		return expr;
+	}
+
+	if (basic_unary_function_expression<T>* f = dynamic_cast<basic_unary_function_expression<T>*>(expr.get()))
 	{
-		long double value = expr->eval();
-		return make_constant(value);
+		f->arg = simplify_node(std::move(f->arg));
+		return expr;
+	}
+
+	if (basic_binary_function_expression<T>* f = dynamic_cast<basic_binary_function_expression<T>*>(expr.get()))
+	{
+		f->arg1 = simplify_node(std::move(f->arg1));
+		f->arg2 = simplify_node(std::move(f->arg2));
+		// pow(x, c) is x ** c; a variable exponent keeps pow() for its partial derivatives
+		const typename basic_function_registry<T>::function_entry* pow_entry = basic_function_registry<T>::instance().get(L"pow");
+		T exponent = 0;
+		if (pow_entry && f->func == pow_entry->binary_func && is_number(f->arg2.get(), exponent))
+			return simplify_node(make_binary(power, std::move(f->arg1), std::move(f->arg2)));
+		return expr;
+	}
+
+	if (basic_binary_expression<T>* b = expr->get_binary())
+	{
+		b->left = simplify_node(std::move(b->left));
+		b->right = simplify_node(std::move(b->right));
+		return simplify_binary(std::move(expr), b);
 	}
 	return expr;
 }
 
+// variables linked to a replaced root follow the context to the new one
+template <typename T>
+inline void relink_variables(basic_expression<T>* expr, basic_expression<T>* from, basic_expression<T>* to)
+{
+	if (basic_variable_expression<T>* v = dynamic_cast<basic_variable_expression<T>*>(expr))
+	{
+		if (v->root == from) v->set_root(to);
+	}
+	else if (basic_sub_expression<T>* s = dynamic_cast<basic_sub_expression<T>*>(expr))
+		relink_variables(s->inner_expression.get(), from, to);
+	else if (basic_unary_expression<T>* u = dynamic_cast<basic_unary_expression<T>*>(expr))
+		relink_variables(u->operand.get(), from, to);
+	else if (basic_unary_function_expression<T>* f = dynamic_cast<basic_unary_function_expression<T>*>(expr))
+		relink_variables(f->arg.get(), from, to);
+	else if (basic_binary_function_expression<T>* f = dynamic_cast<basic_binary_function_expression<T>*>(expr))
+	{
+		relink_variables(f->arg1.get(), from, to);
+		relink_variables(f->arg2.get(), from, to);
+	}
+	else if (basic_binary_expression<T>* b = expr->get_binary())
+	{
+		relink_variables(b->left.get(), from, to);
+		relink_variables(b->right.get(), from, to);
+	}
+}
+
+template <typename T>
+inline std::unique_ptr<basic_expression<T>> simplify(std::unique_ptr<basic_expression<T>> expr)
+{
+	basic_expression<T>* old_root = expr.get();
+	basic_expression_context<T> context = expr->context();
+	std::unique_ptr<basic_expression<T>> result = simplify_node(std::move(expr));
+	// old_root may be gone by now, only its address is compared
+	result->context() = context;
+	relink_variables(result.get(), old_root, result.get());
+	return result;
+}
+
 //========================================
-// Compiler - recursive descent using token map
-// Compiler only builds expression tree, does not deal with bindings
+// Expression program - flat register bytecode lowered from an expression tree
+// Constants and variable slots are preassigned registers, so the interpreter
+// loop only reads and writes one contiguous register file: no virtual calls,
+// no pointer chasing, no context lookups per evaluation.
+// Lowering hash-conses: structurally identical operations (same opcode,
+// function and operand registers) share one register, so the program is a
+// DAG and subterms repeated by the source or by derivative() run once
 //========================================
+enum class program_opcode : unsigned char
+{
+	neg,    // dst = -a
+	add,    // dst = a + b
+	sub,    // dst = a - b
+	mul,    // dst = a * b
+	div,    // dst = a / b
+	pow,    // dst = a ** b
+	call1,  // dst = fn.unary(a)
+	call2   // dst = fn.binary(a, b)
+};
 
-// Type alias for readability
-using token_map = std::map<size_t, std::unique_ptr<token>>;
-using token_map_iterator = token_map::const_iterator;
+template <typename T>
+struct basic_program_instruction
+{
+	program_opcode op;
+	unsigned int dst = 0;
+	unsigned int a = 0;
+	unsigned int b = 0;
+	union
+	{
+		T (*unary)(T);
+		T (*binary)(T, T);
+	} fn = { nullptr };
+	// derivatives for dual evaluation: f' of call1, df/da and df/db of call2
+	union
+	{
+		T (*unary)(T);
+		T (*binary)(T, T);
+	} deriv_a = { nullptr }, deriv_b = { nullptr };
+	simd::batch_fn_t batch = nullptr;            // vectorized call1, when the registry has one
+	simd::dual_batch_fn_t dual_batch = nullptr;  // vectorized call1 value + f'
+};
 
-class expression_token_compiler
+// value and derivative from one dual evaluation
+template <typename T>
+struct dual
 {
-private:
-	std::vector<variable_expression*> variables_;  // track variables for root assignment
+	T value;
+	T derivative;
+};
+
+//========================================
+// Program state - everything one evaluation writes
+// A lowered program is read-only and can be shared between threads; each
+// thread (or call) owns a state holding the slot values and the register
+// file. Slots are resolved to indices once with program.find_slot(name).
+//========================================
+template <typename T>
+class basic_program_state
+{
+	friend class basic_expression_program<T>;
+	
+	const basic_expression_program<T>* program_ = nullptr;
+	std::vector<T> slots_;                         // variable values, one per program slot
+	std::vector<T> registers_;                     // copy of the program's register file
+	std::vector<T> tangents_;                      // eval_dual derivative per register
+	std::vector<double> batch_registers_;          // eval_batch scratch, batch_block lanes per register
+	std::vector<double> batch_tangents_;           // eval_batch_dual derivatives, same layout
+	std::vector<double> batch_scratch_;            // f' lanes of a dual call1
 	
 public:
-	expression_token_compiler() = default;
+	basic_program_state() = default;
+	explicit basic_program_state(const basic_expression_program<T>& program) { attach(program); }
 	
-	// compile entry - returns root expression with all variables linked to it
-	expression_token_reader tokenizer;
+	// size the state for `program`, slots start at 0
+	void attach(const basic_expression_program<T>& program);
+	
+	const basic_expression_program<T>* program() const { return program_; }
+	size_t slot_count() const { return slots_.size(); }
+	
+	T& operator[](size_t slot) { return slots_[slot]; }
+	T operator[](size_t slot) const { return slots_[slot]; }
+	void set(size_t slot, T value) { slots_[slot] = value; }
+};
 
-	std::unique_ptr<expression> compile(const wchar_t* formula)
+template <typename T>
+class basic_expression_program
+{
+public:
+	using unary_fn_t = T (*)(T);
+	using binary_fn_t = T (*)(T, T);
+	using instruction = basic_program_instruction<T>;
+	
+private:
+	std::vector<instruction> code_;
+	std::vector<T> registers_;                    // constants, variable slots and temporaries
+	std::vector<std::wstring> slot_names_;        // lowercase variable names, one per slot
+	std::vector<unsigned int> slot_registers_;    // register loaded from each slot
+	unsigned int result_ = 0;
+	
+	// bind()/eval() convenience path: pointer bindings feeding a private state
+	std::vector<T*> slot_bindings_;               // bound storage, one per slot
+	basic_program_state<T> state_;
+	
+	// Hash-consing tables, used while lowering
+	struct value_key
+	{
+		program_opcode op;
+		unsigned int a, b;
+		std::uintptr_t fn;
+		bool operator==(const value_key& o) const { return op == o.op && a == o.a && b == o.b && fn == o.fn; }
+	};
+	struct value_key_hash
+	{
+		size_t operator()(const value_key& k) const
+		{
+			size_t h = std::hash<std::uintptr_t>()(k.fn);
+			h = h * 31 + static_cast<size_t>(k.op);
+			h = h * 31 + k.a;
+			return h * 31 + k.b;
+		}
+	};
+	std::unordered_map<value_key, unsigned int, value_key_hash> values_;  // operation -> register
+	std::unordered_map<T, unsigned int> constants_;                         // constant -> register
+	size_t shared_ = 0;                                                     // lookups answered by an existing register
+	
+	static std::wstring to_lower(const std::wstring& name)
 	{
-		std::map<size_t, std::unique_ptr<token>> lang = tokenizer.tokenize_main(formula);
-		return this->compile(lang);
+		std::wstring lname = name;
+		std::transform(lname.begin(), lname.end(), lname.begin(), towlower);
+		return lname;
 	}
-	std::unique_ptr<expression> compile(const std::wstring& formula)
+	
+	unsigned int new_register(T value)
 	{
-		std::map<size_t, std::unique_ptr<token>> lang = tokenizer.tokenize_main(formula);
-		return this->compile(lang);
+		registers_.push_back(value);
+		return static_cast<unsigned int>(registers_.size() - 1);
 	}
-	std::unique_ptr<expression> compile(const token_map& tokenz)
+	
+	unsigned int push(instruction in, std::uintptr_t fn = 0)
 	{
-		if (tokenz.empty()) return nullptr;
-		variables_.clear();
-		size_t advance = tokenz.begin()->first;
-		std::unique_ptr<expression> ret = compile_additive(tokenz, advance, advance);
-		
-		// Link all variables to root expression
-		if (ret)
+		// add and mul are commutative in IEEE arithmetic, one operand order is enough
+		if ((in.op == program_opcode::add || in.op == program_opcode::mul) && in.b < in.a)
+			std::swap(in.a, in.b);
+		value_key key = { in.op, in.a, in.b, fn };
+		typename std::unordered_map<value_key, unsigned int, value_key_hash>::const_iterator it = values_.find(key);
+		if (it != values_.end())
 		{
-			for (variable_expression* var : variables_)
-			{
-				var->set_root(ret.get());
-			}
+			++shared_;
+			return it->second;
 		}
-		
-		return ret;
+		in.dst = new_register(T(0));
+		values_[key] = in.dst;
+		code_.push_back(in);
+		return in.dst;
 	}
-
-private:
-	// helper: get iterator for a position (exact or lower_bound)
-	static token_map_iterator it_at(const token_map& tokenz, size_t pos)
+	
+	// copy bound values into the private state, except the slot fed by a batch
+	basic_program_state<T>& load_bindings(size_t skip)
 	{
-		token_map_iterator it = tokenz.find(pos);
-		if (it != tokenz.end()) return it;
-		it = tokenz.lower_bound(pos);
-		return it;
+		if (state_.program_ != this) state_.attach(*this);  // fresh, copied or moved program
+		for (size_t i = 0; i < slot_bindings_.size(); ++i)
+		{
+			if (i == skip) continue;
+			if (!slot_bindings_[i])
+				throw std::runtime_error("Unbound variable: " + std::string(slot_names_[i].begin(), slot_names_[i].end()));
+			state_.slots_[i] = *slot_bindings_[i];
+		}
+		return state_;
 	}
-	// helper: next token position (or same if end)
-	static size_t next_pos(const token_map& tokenz, size_t pos)
+	
+	// a state sized for this program, slot values copied into its registers except `skip`
+	T* load_slots(basic_program_state<T>& state, size_t skip) const
 	{
-		token_map_iterator it = it_at(tokenz, pos);
-		if (it == tokenz.end()) return pos;
-		token_map_iterator itn = std::next(it);
-		if (itn == tokenz.end()) return it->first;
-		return itn->first;
+		if (state.program_ != this)
+			throw std::runtime_error("Program state is attached to another program");
+		T* r = state.registers_.data();
+		for (size_t i = 0; i < slot_registers_.size(); ++i)
+			if (i != skip) r[slot_registers_[i]] = state.slots_[i];
+		return r;
 	}
-	// helper skip spaces: returns iterator to first non-space token at or after pos
-	static token_map_iterator skip_spaces_it(const token_map& tokenz, token_map_iterator it)
+	
+	template <typename F>
+	static F require_derivative(F f)
 	{
-		while (it != tokenz.end() && it->second->type() == token_type::space) ++it;
-		return it;
+		if (!f) throw std::runtime_error("No derivative defined for this function");
+		return f;
 	}
-
+	
+	// d(a^b) = b a^(b-1) da + a^b ln(a) db, each term only when its tangent is nonzero
+	// so negative bases with a constant exponent stay finite
+	template <typename U>
+	static U pow_tangent(U a, U b, U p, U ta, U tb)
+	{
+		U t = (ta != U(0)) ? b * std::pow(a, b - U(1)) * ta : U(0);
+		if (tb != U(0)) t += p * std::log(a) * tb;
+		return t;
+	}
+	
 public:
-	// parse number literal
-	std::unique_ptr<number_constant_expression> compile_constant_number(const token_map& tokenz, size_t start_pos, size_t& advance)
+	basic_expression_program() = default;
+	
+	//----------------------------------------
+	// Lowering interface (used by expression::emit)
+	//----------------------------------------
+	// equal constants share a register; -0 and NaN keep their own
+	unsigned int add_constant(T value)
 	{
-		token_map_iterator it = it_at(tokenz, start_pos);
-		it = skip_spaces_it(tokenz, it);
-		if (it == tokenz.end()) return nullptr;
-		if (it->second->type() == token_type::number)
+		if (value != value || (value == T(0) && std::signbit(value)))
+			return new_register(value);
+		typename std::unordered_map<T, unsigned int>::const_iterator it = constants_.find(value);
+		if (it != constants_.end())
 		{
-			std::unique_ptr<number_constant_expression> num = std::make_unique<number_constant_expression>();
-			num->number = std::wcstold(it->second->value.c_str(), nullptr);
-			token_map_iterator itn = std::next(it);
-			if (itn == tokenz.end()) advance = it->first;
-			else advance = itn->first;
-			return num;
+			++shared_;
+			return it->second;
 		}
-		return nullptr;
+		return constants_[value] = new_register(value);
 	}
-
-	// parse parenthesized subexpression
-	std::unique_ptr<expression> compile_subexpression(const token_map& tokenz, size_t start_pos, size_t& advance)
+	
+	// one slot per distinct variable name, shared by every use
+	unsigned int add_variable(const std::wstring& name)
 	{
-		token_map_iterator it = it_at(tokenz, start_pos);
-		it = skip_spaces_it(tokenz, it);
-		if (it == tokenz.end()) return nullptr;
-		if (it->second->type() != token_type::expression_bound) return nullptr;
-		if (it->second->value != L"(") return nullptr;
-		// move to token after '('
-		token_map_iterator it_after = std::next(it);
-		it_after = skip_spaces_it(tokenz, it_after);
-		size_t inner_start = (it_after == tokenz.end()) ? it->first : it_after->first;
-		size_t inner_advance = inner_start;
-		std::unique_ptr<expression> inner_expr = compile_additive(tokenz, inner_start, inner_advance);
-		if (!inner_expr) return nullptr;
-		// now inner_advance should point to token right after expression; expect ')'
-		token_map_iterator it_after_inner = it_at(tokenz, inner_advance);
-		it_after_inner = skip_spaces_it(tokenz, it_after_inner);
-		if (it_after_inner == tokenz.end()) return nullptr;
-		if (it_after_inner->second->type() != token_type::expression_bound) return nullptr;
-		if (it_after_inner->second->value != L")") return nullptr;
-		// set advance to token after ')'
-		token_map_iterator it_after_paren = std::next(it_after_inner);
-		if (it_after_paren == tokenz.end()) advance = it_after_inner->first;
-		else advance = it_after_paren->first;
-		std::unique_ptr<sub_expression> node = std::make_unique<sub_expression>();
-		node->inner_expression = std::move(inner_expr);
-		return node;
+		std::wstring lname = to_lower(name);
+		for (size_t i = 0; i < slot_names_.size(); ++i)
+			if (slot_names_[i] == lname) return slot_registers_[i];
+		slot_names_.push_back(lname);
+		slot_registers_.push_back(new_register(T(0)));
+		slot_bindings_.push_back(nullptr);
+		return slot_registers_.back();
 	}
-
-	// parse variable
-	std::unique_ptr<variable_expression> compile_variable(const token_map& tokenz, size_t start_pos, size_t& advance)
+	
+	unsigned int emit_op(program_opcode op, unsigned int a, unsigned int b = 0)
 	{
-		token_map_iterator it = it_at(tokenz, start_pos);
-		it = skip_spaces_it(tokenz, it);
-		if (it == tokenz.end()) return nullptr;
-		if (it->second->type() != token_type::identifier) return nullptr;
-		
-		std::wstring name = it->second->value;
+		instruction in;
+		in.op = op;
+		in.a = a;
+		in.b = b;
+		return push(in);
+	}
+	
+	// deriv may be nullptr, eval_dual then only accepts a constant argument
+	unsigned int emit_call(unary_fn_t f, unary_fn_t deriv, unsigned int a)
+	{
+		instruction in;
+		in.op = program_opcode::call1;
+		in.a = a;
+		in.fn.unary = f;
+		in.deriv_a.unary = deriv;
+		in.batch = basic_function_registry<T>::instance().get_batch(f);
+		in.dual_batch = basic_function_registry<T>::instance().get_dual(f);
+		return push(in, reinterpret_cast<std::uintptr_t>(f));
+	}
+	
+	unsigned int emit_call(binary_fn_t f, binary_fn_t deriv_a, binary_fn_t deriv_b, unsigned int a, unsigned int b)
+	{
+		instruction in;
+		in.op = program_opcode::call2;
+		in.a = a;
+		in.b = b;
+		in.fn.binary = f;
+		in.deriv_a.binary = deriv_a;
+		in.deriv_b.binary = deriv_b;
+		return push(in, reinterpret_cast<std::uintptr_t>(f));
+	}
+	
+	void set_result(unsigned int reg) { result_ = reg; }
+	
+	// slot of a variable name, slot_count() if the program does not use it
+	size_t find_slot(const std::wstring& name) const
+	{
+		std::wstring lname = to_lower(name);
+		size_t slot = 0;
+		while (slot < slot_names_.size() && slot_names_[slot] != lname) ++slot;
+		return slot;
+	}
+	
+	//----------------------------------------
+	// Bindings - same contract as expression::bind
+	// Names the program does not use are ignored. Bound evaluation goes
+	// through a state owned by the program: one thread at a time; threads
+	// sharing a program pass their own basic_program_state instead
+	//----------------------------------------
+	void bind(const std::wstring& name, T* ptr)
+	{
+		std::wstring lname = to_lower(name);
+		for (size_t i = 0; i < slot_names_.size(); ++i)
+			if (slot_names_[i] == lname) slot_bindings_[i] = ptr;
+	}
+	
+	void unbind(const std::wstring& name) { bind(name, nullptr); }
+	
+	//----------------------------------------
+	// Evaluation
+	//----------------------------------------
+	T eval() { return eval(load_bindings(slot_names_.size())); }
+	
+	T eval(basic_program_state<T>& state) const
+	{
+		T* r = load_slots(state, slot_names_.size());
 		
-		// Check it's not a known function (functions are handled separately with parentheses)
-		// Variables are identifiers NOT followed by '('
-		token_map_iterator it_next = std::next(it);
-		it_next = skip_spaces_it(tokenz, it_next);
-		if (it_next != tokenz.end() && 
-		    it_next->second->type() == token_type::expression_bound && 
-		    it_next->second->value == L"(")
+		const instruction* in = code_.data();
+		const instruction* end = in + code_.size();
+		for (; in != end; ++in)
 		{
-			// This is a function call, not a variable
-			return nullptr;
+			switch (in->op)
+			{
+			case program_opcode::neg:   r[in->dst] = -r[in->a]; break;
+			case program_opcode::add:   r[in->dst] = r[in->a] + r[in->b]; break;
+			case program_opcode::sub:   r[in->dst] = r[in->a] - r[in->b]; break;
+			case program_opcode::mul:   r[in->dst] = r[in->a] * r[in->b]; break;
+			case program_opcode::div:   r[in->dst] = r[in->a] / r[in->b]; break;
+			case program_opcode::pow:   r[in->dst] = std::pow(r[in->a], r[in->b]); break;
+			case program_opcode::call1: r[in->dst] = in->fn.unary(r[in->a]); break;
+			case program_opcode::call2: r[in->dst] = in->fn.binary(r[in->a], r[in->b]); break;
+			}
 		}
-		
-		std::unique_ptr<variable_expression> var = std::make_unique<variable_expression>(name);
-		variables_.push_back(var.get());  // track for root assignment
-		
-		if (it_next == tokenz.end()) advance = it->first;
-		else advance = it_next->first;
-		return var;
+		return r[result_];
 	}
-
-	// primary: number | (expr) | function-call | constant | variable
-	std::unique_ptr<expression> compile_primary(const token_map& tokenz, size_t start_pos, size_t& advance)
+	
+	// Cylindrical coordinate transformations, see expression::cyl_x
+	T cyl_x(T theta) { return eval() * std::cos(theta); }
+	T cyl_y(T theta) { return eval() * std::sin(theta); }
+	
+	//----------------------------------------
+	// Dual evaluation - value and d/d(wrt) in one pass (forward mode)
+	// Every register carries a tangent next to its value, seeded 1 on wrt and
+	// 0 elsewhere, so no second symbolic derivative program is needed
+	//----------------------------------------
+	dual<T> eval_dual(const std::wstring& wrt)
 	{
-		token_map_iterator it = it_at(tokenz, start_pos);
-		it = skip_spaces_it(tokenz, it);
-		if (it == tokenz.end()) return nullptr;
-
-		// identifier -- possible function call, constant, or variable
-		if (it->second->type() == token_type::identifier)
+		return eval_dual(load_bindings(slot_names_.size()), find_slot(wrt));
+	}
+	
+	// derivative with respect to slot `wrt`, 0 if wrt >= slot_count()
+	dual<T> eval_dual(basic_program_state<T>& state, size_t wrt) const
+	{
+		T* r = load_slots(state, slot_names_.size());
+		state.tangents_.assign(registers_.size(), T(0));
+		if (wrt < slot_registers_.size()) state.tangents_[slot_registers_[wrt]] = T(1);
+		
+		T* t = state.tangents_.data();
+		for (const instruction& in : code_)
 		{
-			std::wstring name = it->second->value;
-			token_map_iterator it_next = std::next(it);
-			it_next = skip_spaces_it(tokenz, it_next);
-			if (it_next != tokenz.end() && it_next->second->type() == token_type::expression_bound && it_next->second->value == L"(")
+			T a = r[in.a], b = r[in.b], ta = t[in.a], tb = t[in.b];
+			T& d = r[in.dst];
+			T& td = t[in.dst];
+			switch (in.op)
 			{
-				// function call - resolve function at compile time
-				const function_registry::function_entry* func_entry = function_registry::instance().get(name);
-				if (!func_entry)
-				{
-					throw std::runtime_error("Unknown function: " + std::string(name.begin(), name.end()));
-				}
-				
-				// Parse arguments
-				std::vector<std::unique_ptr<expression>> args;
-				
-				// position after '('
-				token_map_iterator it_after_lparen = std::next(it_next);
-				it_after_lparen = skip_spaces_it(tokenz, it_after_lparen);
-				
-				// empty arg list?
-				if (!(it_after_lparen != tokenz.end() && it_after_lparen->second->type() == token_type::expression_bound && it_after_lparen->second->value == L")"))
-				{
-					// parse comma-separated arguments
-					token_map_iterator cur_it = it_after_lparen;
-					while (cur_it != tokenz.end())
-					{
-						size_t arg_start = cur_it->first;
-						size_t arg_end = arg_start;
-						std::unique_ptr<expression> arg_expr = compile_additive(tokenz, arg_start, arg_end);
-						if (!arg_expr) return nullptr;
+			case program_opcode::neg: d = -a;    td = -ta; break;
+			case program_opcode::add: d = a + b; td = ta + tb; break;
+			case program_opcode::sub: d = a - b; td = ta - tb; break;
+			case program_opcode::mul: d = a * b; td = ta * b + a * tb; break;
+			case program_opcode::div: d = a / b; td = (ta - d * tb) / b; break;
+			case program_opcode::pow: d = std::pow(a, b); td = pow_tangent(a, b, d, ta, tb); break;
+			case program_opcode::call1:
+				d = in.fn.unary(a);
+				td = (ta != T(0)) ? require_derivative(in.deriv_a.unary)(a) * ta : T(0);
+				break;
+			case program_opcode::call2:
+				d = in.fn.binary(a, b);
+				td = T(0);
+				if (ta != T(0)) td += require_derivative(in.deriv_a.binary)(a, b) * ta;
+				if (tb != T(0)) td += require_derivative(in.deriv_b.binary)(a, b) * tb;
+				break;
+			}
+		}
+		return { r[result_], t[result_] };
+	}
+	
+	//----------------------------------------
+	// Batched evaluation - out[i] = f(in[i])
+	// `in` feeds one variable (the first one by default, theta in the builders),
+	// every other variable keeps its bound scalar value. The SIMD lanes are
+	// double whatever T is, batch_block samples at a time, each instruction
+	// over all lanes; samples are converted from and to T at the block edges
+	//----------------------------------------
+	static constexpr size_t batch_block = 64;
+	
+	void eval_batch(span<const T> in, span<T> out)
+	{
+		eval_batch_slot(load_bindings(0), 0, in, out, nullptr);
+	}
+	
+	void eval_batch(const std::wstring& name, span<const T> in, span<T> out)
+	{
+		size_t slot = find_slot(name);
+		eval_batch_slot(load_bindings(slot), slot, in, out, nullptr);
+	}
+	
+	// out[i] = f(in[i]) and derivative[i] = df/d(name) at in[i], see eval_dual
+	void eval_batch_dual(const std::wstring& name, span<const T> in, span<T> out, span<T> derivative)
+	{
+		size_t slot = find_slot(name);
+		eval_batch_dual(load_bindings(slot), slot, in, out, derivative);
+	}
+	
+	// `in` feeds slot `slot`, the other slots come from the state
+	void eval_batch(basic_program_state<T>& state, size_t slot, span<const T> in, span<T> out) const
+	{
+		eval_batch_slot(state, slot, in, out, nullptr);
+	}
+	
+	void eval_batch_dual(basic_program_state<T>& state, size_t slot, span<const T> in, span<T> out, span<T> derivative) const
+	{
+		if (derivative.size() < in.size())
+			throw std::runtime_error("eval_batch_dual: derivative is shorter than input");
+		eval_batch_slot(state, slot, in, out, derivative.data());
+	}
+	
+private:
+	void eval_batch_slot(basic_program_state<T>& state, size_t slot, span<const T> in, span<T> out, T* derivative) const
+	{
+		if (out.size() < in.size())
+			throw std::runtime_error("eval_batch: output is shorter than input");
+		
+		// scalar slots and constants are broadcast once, the batch slot is refilled per block
+		const T* registers = load_slots(state, slot);
+		state.batch_registers_.resize(registers_.size() * batch_block);
+		double* rows = state.batch_registers_.data();
+		for (size_t r = 0; r < registers_.size(); ++r)
+			std::fill(rows + r * batch_block, rows + (r + 1) * batch_block, static_cast<double>(registers[r]));
+		
+		double* var = (slot < slot_registers_.size()) ? rows + slot_registers_[slot] * batch_block : nullptr;
+		const double* res = rows + result_ * batch_block;
+		
+		// dual mode: tangent rows are 0 except 1 on the batch slot
+		double* tangents = nullptr;
+		if (derivative)
+		{
+			state.batch_tangents_.assign(registers_.size() * batch_block, 0.0);
+			state.batch_scratch_.resize(batch_block);
+			tangents = state.batch_tangents_.data();
+			if (var) std::fill(tangents + slot_registers_[slot] * batch_block, tangents + (slot_registers_[slot] + 1) * batch_block, 1.0);
+		}
+		const double* tres = tangents ? tangents + result_ * batch_block : nullptr;
+		
+		for (size_t base = 0; base < in.size(); base += batch_block)
+		{
+			size_t m = std::min(batch_block, in.size() - base);
+			size_t padded = (m + simd::width - 1) / simd::width * simd::width;
+			if (var)
+			{
+				for (size_t i = 0; i < m; ++i) var[i] = static_cast<double>(in[base + i]);
+				std::fill(var + m, var + padded, var[m - 1]);  // keep padding lanes finite
+			}
+			if (tangents)
+			{
+				run_batch_dual(rows, tangents, state.batch_scratch_.data(), padded);
+				for (size_t i = 0; i < m; ++i) derivative[base + i] = static_cast<T>(tres[i]);
+			}
+			else
+				run_batch(rows, padded);
+			for (size_t i = 0; i < m; ++i) out[base + i] = static_cast<T>(res[i]);
+		}
+	}
+	
+	void run_batch(double* rows, size_t n) const
+	{
+		for (const instruction& in : code_)
+		{
+			double* d = rows + in.dst * batch_block;
+			const double* a = rows + in.a * batch_block;
+			const double* b = rows + in.b * batch_block;
+			switch (in.op)
+			{
+			case program_opcode::neg:
+				for (size_t i = 0; i < n; i += simd::width) simd::store(d + i, simd::mul(simd::load(a + i), simd::set1(-1.0)));
+				break;
+			case program_opcode::add:
+				for (size_t i = 0; i < n; i += simd::width) simd::store(d + i, simd::add(simd::load(a + i), simd::load(b + i)));
+				break;
+			case program_opcode::sub:
+				for (size_t i = 0; i < n; i += simd::width) simd::store(d + i, simd::sub(simd::load(a + i), simd::load(b + i)));
+				break;
+			case program_opcode::mul:
+				for (size_t i = 0; i < n; i += simd::width) simd::store(d + i, simd::mul(simd::load(a + i), simd::load(b + i)));
+				break;
+			case program_opcode::div:
+				for (size_t i = 0; i < n; i += simd::width) simd::store(d + i, simd::div(simd::load(a + i), simd::load(b + i)));
+				break;
+			case program_opcode::pow:
+				for (size_t i = 0; i < n; ++i) d[i] = std::pow(a[i], b[i]);
+				break;
+			case program_opcode::call1:
+				if (in.batch)
+					in.batch(a, d, n);
+				else
+					for (size_t i = 0; i < n; ++i) d[i] = static_cast<double>(in.fn.unary(static_cast<T>(a[i])));
+				break;
+			case program_opcode::call2:
+				for (size_t i = 0; i < n; ++i) d[i] = static_cast<double>(in.fn.binary(static_cast<T>(a[i]), static_cast<T>(b[i])));
+				break;
+			}
+		}
+	}
+	
+	// run_batch carrying a tangent row per register, see eval_dual
+	void run_batch_dual(double* rows, double* tangents, double* scratch, size_t n) const
+	{
+		for (const instruction& in : code_)
+		{
+			double* d = rows + in.dst * batch_block;
+			const double* a = rows + in.a * batch_block;
+			const double* b = rows + in.b * batch_block;
+			double* td = tangents + in.dst * batch_block;
+			const double* ta = tangents + in.a * batch_block;
+			const double* tb = tangents + in.b * batch_block;
+			switch (in.op)
+			{
+			case program_opcode::neg:
+				for (size_t i = 0; i < n; i += simd::width)
+				{
+					simd::store(d + i, simd::mul(simd::load(a + i), simd::set1(-1.0)));
+					simd::store(td + i, simd::mul(simd::load(ta + i), simd::set1(-1.0)));
+				}
+				break;
+			case program_opcode::add:
+				for (size_t i = 0; i < n; i += simd::width)
+				{
+					simd::store(d + i, simd::add(simd::load(a + i), simd::load(b + i)));
+					simd::store(td + i, simd::add(simd::load(ta + i), simd::load(tb + i)));
+				}
+				break;
+			case program_opcode::sub:
+				for (size_t i = 0; i < n; i += simd::width)
+				{
+					simd::store(d + i, simd::sub(simd::load(a + i), simd::load(b + i)));
+					simd::store(td + i, simd::sub(simd::load(ta + i), simd::load(tb + i)));
+				}
+				break;
+			case program_opcode::mul:
+				for (size_t i = 0; i < n; i += simd::width)
+				{
+					simd::lanes va = simd::load(a + i), vb = simd::load(b + i);
+					simd::store(d + i, simd::mul(va, vb));
+					simd::store(td + i, simd::add(simd::mul(simd::load(ta + i), vb), simd::mul(va, simd::load(tb + i))));
+				}
+				break;
+			case program_opcode::div:
+				for (size_t i = 0; i < n; i += simd::width)
+				{
+					simd::lanes vb = simd::load(b + i), q = simd::div(simd::load(a + i), vb);
+					simd::store(d + i, q);
+					simd::store(td + i, simd::div(simd::sub(simd::load(ta + i), simd::mul(q, simd::load(tb + i))), vb));
+				}
+				break;
+			case program_opcode::pow:
+				for (size_t i = 0; i < n; ++i)
+				{
+					d[i] = std::pow(a[i], b[i]);
+					td[i] = pow_tangent(a[i], b[i], d[i], ta[i], tb[i]);
+				}
+				break;
+			case program_opcode::call1:
+				if (in.dual_batch)
+				{
+					in.dual_batch(a, d, scratch, n);
+					for (size_t i = 0; i < n; i += simd::width) simd::store(td + i, simd::mul(simd::load(scratch + i), simd::load(ta + i)));
+				}
+				else
+				{
+					for (size_t i = 0; i < n; ++i)
+					{
+						d[i] = static_cast<double>(in.fn.unary(static_cast<T>(a[i])));
+						td[i] = (ta[i] != 0.0) ? static_cast<double>(require_derivative(in.deriv_a.unary)(static_cast<T>(a[i]))) * ta[i] : 0.0;
+					}
+				}
+				break;
+			case program_opcode::call2:
+				for (size_t i = 0; i < n; ++i)
+				{
+					T va = static_cast<T>(a[i]), vb = static_cast<T>(b[i]);
+					d[i] = static_cast<double>(in.fn.binary(va, vb));
+					td[i] = 0.0;
+					if (ta[i] != 0.0) td[i] += static_cast<double>(require_derivative(in.deriv_a.binary)(va, vb)) * ta[i];
+					if (tb[i] != 0.0) td[i] += static_cast<double>(require_derivative(in.deriv_b.binary)(va, vb)) * tb[i];
+				}
+				break;
+			}
+		}
+	}
+	
+public:
+	
+	size_t size() const { return code_.size(); }
+	size_t shared_count() const { return shared_; }
+	size_t register_count() const { return registers_.size(); }
+	size_t slot_count() const { return slot_names_.size(); }
+	const std::wstring& slot_name(size_t slot) const { return slot_names_[slot]; }
+	
+	// Read-only layout, for backends that translate the program (jit_expression)
+	const std::vector<instruction>& code() const { return code_; }
+	const std::vector<T>& registers() const { return registers_; }
+	unsigned int slot_register(size_t slot) const { return slot_registers_[slot]; }
+	unsigned int result_register() const { return result_; }
+};
+
+template <typename T>
+inline void basic_program_state<T>::attach(const basic_expression_program<T>& program)
+{
+	program_ = &program;
+	slots_.assign(program.slot_count(), T(0));
+	registers_ = program.registers();
+	tangents_.clear();
+}
+
+//========================================
+// Lowering - each node writes its value into a fresh register
+//========================================
+template <typename T>
+inline unsigned int basic_sub_expression<T>::emit(basic_expression_program<T>& program)
+{
+	return inner_expression->emit(program);
+}
+
+template <typename T>
+inline unsigned int basic_number_constant_expression<T>::emit(basic_expression_program<T>& program)
+{
+	return program.add_constant(number);
+}
+
+template <typename T>
+inline unsigned int basic_variable_expression<T>::emit(basic_expression_program<T>& program)
+{
+	return program.add_variable(name);
+}
+
+template <typename T>
+inline unsigned int basic_unary_expression<T>::emit(basic_expression_program<T>& program)
+{
+	unsigned int a = operand->emit(program);
+	if (op == unary_minus) return program.emit_op(program_opcode::neg, a);
+	if (op == unary_plus) return a;
+	return program.emit_call(eval_func, nullptr, a);
+}
+
+template <typename T>
+inline unsigned int basic_binary_expression<T>::emit(basic_expression_program<T>& program)
+{
+	unsigned int a = left->emit(program);
+	unsigned int b = right->emit(program);
+	switch (op)
+	{
+	case plus:     return program.emit_op(program_opcode::add, a, b);
+	case minus:    return program.emit_op(program_opcode::sub, a, b);
+	case multiply: return program.emit_op(program_opcode::mul, a, b);
+	case divide:   return program.emit_op(program_opcode::div, a, b);
+	case power:    return program.emit_op(program_opcode::pow, a, b);
+	default:       return program.emit_call(eval_func_discrete, nullptr, nullptr, a, b);
+	}
+}
+
+template <typename T>
+inline unsigned int basic_unary_function_expression<T>::emit(basic_expression_program<T>& program)
+{
+	unsigned int a = arg->emit(program);
+	return program.emit_call(func, deriv_func, a);
+}
+
+template <typename T>
+inline unsigned int basic_binary_function_expression<T>::emit(basic_expression_program<T>& program)
+{
+	unsigned int a = arg1->emit(program);
+	unsigned int b = arg2->emit(program);
+	return program.emit_call(func, deriv_func_arg1, deriv_func_arg2, a, b);
+}
+
+//========================================
+// Interval evaluation - same walk as eval(), on ranges instead of values
+// Nodes without an interval rule answer the whole real line
+//========================================
+template <typename T>
+inline basic_interval<T> basic_sub_expression<T>::eval_interval(const std::wstring& wrt, const basic_interval<T>& range)
+{
+	return inner_expression->eval_interval(wrt, range);
+}
+
+template <typename T>
+inline basic_interval<T> basic_number_constant_expression<T>::eval_interval(const std::wstring&, const basic_interval<T>&)
+{
+	return basic_interval<T>(number);
+}
+
+template <typename T>
+inline basic_interval<T> basic_variable_expression<T>::eval_interval(const std::wstring& wrt, const basic_interval<T>& range)
+{
+	std::wstring lname = name;
+	std::transform(lname.begin(), lname.end(), lname.begin(), towlower);
+	std::wstring lwrt = wrt;
+	std::transform(lwrt.begin(), lwrt.end(), lwrt.begin(), towlower);
+	
+	if (lname == lwrt)
+		return range;
+	return basic_interval<T>(eval());
+}
+
+template <typename T>
+inline basic_interval<T> basic_unary_expression<T>::eval_interval(const std::wstring& wrt, const basic_interval<T>& range)
+{
+	basic_interval<T> a = operand->eval_interval(wrt, range);
+	if (op == unary_minus) return intervals::neg(a);
+	if (op == unary_plus) return a;
+	return basic_interval<T>::whole();
+}
+
+template <typename T>
+inline basic_interval<T> basic_binary_expression<T>::eval_interval(const std::wstring& wrt, const basic_interval<T>& range)
+{
+	basic_interval<T> a = left->eval_interval(wrt, range);
+	basic_interval<T> b = right->eval_interval(wrt, range);
+	switch (op)
+	{
+	case plus:     return intervals::add(a, b);
+	case minus:    return intervals::sub(a, b);
+	case multiply: return intervals::mul(a, b);
+	case divide:   return intervals::div(a, b);
+	case power:    return intervals::pow(a, b);
+	default:       return basic_interval<T>::whole();
+	}
+}
+
+template <typename T>
+inline basic_interval<T> basic_unary_function_expression<T>::eval_interval(const std::wstring& wrt, const basic_interval<T>& range)
+{
+	typename basic_function_registry<T>::unary_interval_fn_t f = basic_function_registry<T>::instance().get_interval(func);
+	if (!f) return basic_interval<T>::whole();
+	return f(arg->eval_interval(wrt, range));
+}
+
+template <typename T>
+inline basic_interval<T> basic_binary_function_expression<T>::eval_interval(const std::wstring& wrt, const basic_interval<T>& range)
+{
+	typename basic_function_registry<T>::binary_interval_fn_t f = basic_function_registry<T>::instance().get_interval(func);
+	if (!f) return basic_interval<T>::whole();
+	return f(arg1->eval_interval(wrt, range), arg2->eval_interval(wrt, range));
+}
+
+//========================================
+// GLSL - the tree as one float expression, fully parenthesized
+// Evaluates in float on the GPU, so results match eval() to float precision
+//========================================
+template <typename T>
+inline std::string basic_sub_expression<T>::glsl(glsl::writer& out)
+{
+	return inner_expression->glsl(out);
+}
+
+template <typename T>
+inline std::string basic_number_constant_expression<T>::glsl(glsl::writer& out)
+{
+	return out.number(number);
+}
+
+template <typename T>
+inline std::string basic_variable_expression<T>::glsl(glsl::writer& out)
+{
+	return out.variable(name);
+}
+
+template <typename T>
+inline std::string basic_unary_expression<T>::glsl(glsl::writer& out)
+{
+	std::string a = operand->glsl(out);
+	if (op == unary_minus) return "(-" + a + ")";
+	if (op == unary_plus) return a;
+	throw std::runtime_error("Unknown unary operator for GLSL");
+}
+
+template <typename T>
+inline std::string basic_binary_expression<T>::glsl(glsl::writer& out)
+{
+	std::string a = left->glsl(out);
+	std::string b = right->glsl(out);
+	switch (op)
+	{
+	case plus:     return "(" + a + " + " + b + ")";
+	case minus:    return "(" + a + " - " + b + ")";
+	case multiply: return "(" + a + " * " + b + ")";
+	case divide:   return "(" + a + " / " + b + ")";
+	case power:    return out.call(glsl::find("dyn_pow"), a, b);
+	default:       throw std::runtime_error("Unknown binary operator for GLSL");
+	}
+}
+
+template <typename T>
+inline std::string basic_unary_function_expression<T>::glsl(glsl::writer& out)
+{
+	const glsl::function* f = basic_function_registry<T>::instance().get_glsl(func);
+	if (!f) throw std::runtime_error("No GLSL spelling for function");
+	return out.call(f, arg->glsl(out));
+}
+
+template <typename T>
+inline std::string basic_binary_function_expression<T>::glsl(glsl::writer& out)
+{
+	const glsl::function* f = basic_function_registry<T>::instance().get_glsl(func);
+	if (!f) throw std::runtime_error("No GLSL spelling for function");
+	std::string a = arg1->glsl(out);
+	return out.call(f, a, arg2->glsl(out));
+}
+
+// float name(float param) returning the expression; the other variables it reads
+// stay free names (out.variables() lists them) for the shader to declare
+template <typename T>
+inline std::string glsl_function(basic_expression<T>& expr, const std::string& name, const std::wstring& param, glsl::writer& out)
+{
+	std::string p = out.variable(param);
+	return "float " + name + "(float " + p + ")\n{\n    return " + expr.glsl(out) + ";\n}\n";
+}
+
+//========================================
+// C++ - the tree as one double expression, fully parenthesized
+// The same operations eval() performs in double, ready for the C++ compiler
+//========================================
+template <typename T>
+inline std::string basic_sub_expression<T>::cpp(cpp::writer& out)
+{
+	return inner_expression->cpp(out);
+}
+
+template <typename T>
+inline std::string basic_number_constant_expression<T>::cpp(cpp::writer& out)
+{
+	return out.number(number);
+}
+
+template <typename T>
+inline std::string basic_variable_expression<T>::cpp(cpp::writer& out)
+{
+	return out.variable(name);
+}
+
+template <typename T>
+inline std::string basic_unary_expression<T>::cpp(cpp::writer& out)
+{
+	std::string a = operand->cpp(out);
+	if (op == unary_minus) return "(-" + a + ")";
+	if (op == unary_plus) return a;
+	throw std::runtime_error("Unknown unary operator for C++");
+}
+
+template <typename T>
+inline std::string basic_binary_expression<T>::cpp(cpp::writer& out)
+{
+	std::string a = left->cpp(out);
+	std::string b = right->cpp(out);
+	switch (op)
+	{
+	case plus:     return "(" + a + " + " + b + ")";
+	case minus:    return "(" + a + " - " + b + ")";
+	case multiply: return "(" + a + " * " + b + ")";
+	case divide:   return "(" + a + " / " + b + ")";
+	case power:    return out.call(cpp::find("std::pow"), a, b);
+	default:       throw std::runtime_error("Unknown binary operator for C++");
+	}
+}
+
+template <typename T>
+inline std::string basic_unary_function_expression<T>::cpp(cpp::writer& out)
+{
+	const cpp::function* f = basic_function_registry<T>::instance().get_cpp(func);
+	if (!f) throw std::runtime_error("No C++ spelling for function");
+	return out.call(f, arg->cpp(out));
+}
+
+template <typename T>
+inline std::string basic_binary_function_expression<T>::cpp(cpp::writer& out)
+{
+	const cpp::function* f = basic_function_registry<T>::instance().get_cpp(func);
+	if (!f) throw std::runtime_error("No C++ spelling for function");
+	std::string a = arg1->cpp(out);
+	return out.call(f, a, arg2->cpp(out));
+}
+
+// double name(double param) returning the expression, constexpr when everything it
+// calls is; the other variables it reads stay free names (out.variables() lists them)
+template <typename T>
+inline std::string cpp_function(basic_expression<T>& expr, const std::string& name, const std::wstring& param, cpp::writer& out)
+{
+	std::string p = out.variable(param);
+	out.begin_function();
+	std::string body = expr.cpp(out);
+	return std::string(out.is_constexpr() ? "constexpr" : "inline") + " double " + name + "(double " + p + ")\n{\n    return " + body + ";\n}\n";
+}
+
+// Lower a whole tree; variables already bound on the tree's context stay bound
+template <typename T>
+inline std::unique_ptr<basic_expression_program<T>> compile_program(basic_expression<T>& expr)
+{
+	std::unique_ptr<basic_expression_program<T>> program = std::make_unique<basic_expression_program<T>>();
+	program->set_result(expr.emit(*program));
+	for (size_t i = 0; i < program->slot_count(); ++i)
+		program->bind(program->slot_name(i), expr.context().get(program->slot_name(i)));
+	return program;
+}
+
+//========================================
+// JIT - double formulas as native x86-64 code (Linux)
+// The lowered program becomes straight-line SSE2 code in an mmap'd page:
+// operands are read from the register file (rbx), registry functions and
+// pow are direct calls. Where no code can be generated (other OS or CPU,
+// mmap refused) eval() walks the tree, so callers keep a single path
+//========================================
+class jit_expression
+{
+	using entry_fn = double (*)(double* registers);
+	using instruction = basic_program_instruction<double>;
+	
+	std::unique_ptr<basic_expression<double>> tree_;
+	std::unique_ptr<basic_expression_program<double>> program_;
+	std::vector<double> registers_;           // program registers plus the sign mask
+	std::vector<double*> slot_bindings_;
+	void* code_ = nullptr;
+	size_t code_size_ = 0;
+	
+	static double pow_call(double a, double b) { return std::pow(a, b); }
+	
+	void refresh_bindings()
+	{
+		slot_bindings_.resize(program_->slot_count());
+		for (size_t i = 0; i < slot_bindings_.size(); ++i)
+			slot_bindings_[i] = tree_->context().get(program_->slot_name(i));
+	}
+	
+#ifdef __EXPRESSION_JIT__
+	// SSE2 scalar double encodings against [rbx + disp32]
+	enum sse_op : unsigned char { movsd_load = 0x10, movsd_store = 0x11, addsd = 0x58, mulsd = 0x59, subsd = 0x5C, divsd = 0x5E };
+	
+	static void emit_u32(std::vector<unsigned char>& out, unsigned int v)
+	{
+		for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+	}
+	
+	static void emit_sse(std::vector<unsigned char>& out, sse_op op, int xmm, unsigned int reg)
+	{
+		out.insert(out.end(), { 0xF2, 0x0F, static_cast<unsigned char>(op), static_cast<unsigned char>(0x83 | (xmm << 3)) });
+		emit_u32(out, reg * 8);
+	}
+	
+	static void emit_call(std::vector<unsigned char>& out, const void* target)
+	{
+		unsigned long long address = reinterpret_cast<unsigned long long>(target);
+		out.insert(out.end(), { 0x48, 0xB8 });  // mov rax, imm64
+		for (int i = 0; i < 8; ++i) out.push_back(static_cast<unsigned char>(address >> (8 * i)));
+		out.insert(out.end(), { 0xFF, 0xD0 });  // call rax
+	}
+	
+	// xmm0 still holds the last result, so a chain only reloads the other operand
+	std::vector<unsigned char> generate(unsigned int sign_mask) const
+	{
+		std::vector<unsigned char> out = { 0x53, 0x48, 0x89, 0xFB };  // push rbx (aligns rsp for calls); mov rbx, rdi
+		const unsigned int none = ~0u;
+		unsigned int in_xmm0 = none;
+		for (const instruction& in : program_->code())
+		{
+			if (in.op == program_opcode::call2 || in.op == program_opcode::pow)
+				emit_sse(out, movsd_load, 1, in.b);
+			if (in.a != in_xmm0)
+				emit_sse(out, movsd_load, 0, in.a);
+			switch (in.op)
+			{
+			case program_opcode::neg:
+				emit_sse(out, movsd_load, 1, sign_mask);
+				out.insert(out.end(), { 0x66, 0x0F, 0x57, 0xC1 });  // xorpd xmm0, xmm1
+				break;
+			case program_opcode::add: emit_sse(out, addsd, 0, in.b); break;
+			case program_opcode::sub: emit_sse(out, subsd, 0, in.b); break;
+			case program_opcode::mul: emit_sse(out, mulsd, 0, in.b); break;
+			case program_opcode::div: emit_sse(out, divsd, 0, in.b); break;
+			case program_opcode::pow: emit_call(out, reinterpret_cast<const void*>(&pow_call)); break;
+			case program_opcode::call1: emit_call(out, reinterpret_cast<const void*>(in.fn.unary)); break;
+			case program_opcode::call2: emit_call(out, reinterpret_cast<const void*>(in.fn.binary)); break;
+			}
+			emit_sse(out, movsd_store, 0, in.dst);
+			in_xmm0 = in.dst;
+		}
+		if (program_->result_register() != in_xmm0)
+			emit_sse(out, movsd_load, 0, program_->result_register());
+		out.insert(out.end(), { 0x5B, 0xC3 });  // pop rbx; ret
+		return out;
+	}
+	
+	void install(const std::vector<unsigned char>& bytes)
+	{
+		void* page = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (page == MAP_FAILED) return;
+		std::memcpy(page, bytes.data(), bytes.size());
+		if (mprotect(page, bytes.size(), PROT_READ | PROT_EXEC) != 0)
+		{
+			munmap(page, bytes.size());
+			return;
+		}
+		code_ = page;
+		code_size_ = bytes.size();
+	}
+#endif
+	
+public:
+	explicit jit_expression(std::unique_ptr<basic_expression<double>> tree) : tree_(std::move(tree))
+	{
+		if (!tree_) throw std::runtime_error("jit_expression: no expression");
+		program_ = compile_program(*tree_);
+		refresh_bindings();
+		registers_ = program_->registers();
+		registers_.push_back(-0.0);
+#ifdef __EXPRESSION_JIT__
+		install(generate(static_cast<unsigned int>(registers_.size() - 1)));
+#endif
+	}
+	
+	~jit_expression()
+	{
+#ifdef __EXPRESSION_JIT__
+		if (code_) munmap(code_, code_size_);
+#endif
+	}
+	
+	jit_expression(const jit_expression&) = delete;
+	jit_expression& operator=(const jit_expression&) = delete;
+	
+	// true when this platform can run generated code at all
+	static bool available()
+	{
+#ifdef __EXPRESSION_JIT__
+		return true;
+#else
+		return false;
+#endif
+	}
+	
+	// true when eval() runs native code, false when it walks the tree
+	bool is_native() const { return code_ != nullptr; }
+	size_t code_size() const { return code_size_; }
+	basic_expression<double>& tree() { return *tree_; }
+	
+	// bindings live in the tree's context, the native slots mirror them
+	void bind(const std::wstring& name, double* ptr)
+	{
+		tree_->bind(name, ptr);
+		refresh_bindings();
+	}
+	
+	void unbind(const std::wstring& name)
+	{
+		tree_->unbind(name);
+		refresh_bindings();
+	}
+	
+	double eval()
+	{
+		if (!code_) return tree_->eval();
+		for (size_t i = 0; i < slot_bindings_.size(); ++i)
+		{
+			if (!slot_bindings_[i])
+				throw std::runtime_error("Unbound variable: " + std::string(program_->slot_name(i).begin(), program_->slot_name(i).end()));
+			registers_[program_->slot_register(i)] = *slot_bindings_[i];
+		}
+		return reinterpret_cast<entry_fn>(code_)(registers_.data());
+	}
+};
+
+//========================================
+// Compiler - recursive descent using token map
+// Compiler only builds expression tree, does not deal with bindings
+//========================================
+
+// Type alias for readability
+using token_map = std::map<size_t, std::unique_ptr<token>>;
+using token_map_iterator = token_map::const_iterator;
+
+template <typename T>
+class basic_expression_token_compiler
+{
+private:
+	std::vector<basic_variable_expression<T>*> variables_;  // track variables for root assignment
+	std::vector<flat_token> tokens_;                          // token buffer, reused by every compile
+	const wchar_t* source_ = nullptr;                         // text the tokens point into
+	
+public:
+	basic_expression_token_compiler() = default;
+	
+	// compile entry - returns root expression with all variables linked to it
+	expression_token_reader tokenizer;
+	flat_token_reader flat_tokenizer;
+
+	std::unique_ptr<basic_expression<T>> compile(const wchar_t* formula)
+	{
+		return compile(formula, wcslen(formula));
+	}
+	std::unique_ptr<basic_expression<T>> compile(const std::wstring& formula)
+	{
+		return compile(formula.c_str(), formula.length());
+	}
+	std::unique_ptr<basic_expression<T>> compile(const wchar_t* formula, size_t length)
+	{
+		flat_tokenizer.tokenize(formula, length, tokens_);
+		return compile_tokens(formula);
+	}
+	// compile straight to bytecode
+	std::unique_ptr<basic_expression_program<T>> compile_program(const std::wstring& formula)
+	{
+		std::unique_ptr<basic_expression<T>> tree = compile(formula);
+		if (!tree) return nullptr;
+		return expresie_tokenizer::compile_program(*simplify(std::move(tree)));
+	}
+	// tokens from expression_token_reader::tokenize_main; their values are laid
+	// back at their positions so the flat parser reads them like a source string
+	std::unique_ptr<basic_expression<T>> compile(const token_map& tokenz)
+	{
+		if (tokenz.empty()) return nullptr;
+		std::wstring source;
+		tokens_.clear();
+		for (token_map_iterator it = tokenz.begin(); it != tokenz.end(); ++it)
+		{
+			token_type type = it->second->type();
+			if (type == token_type::space) continue;
+			const std::wstring& value = it->second->value;
+			if (source.length() < it->first + value.length())
+				source.resize(it->first + value.length(), L' ');
+			source.replace(it->first, value.length(), value);
+			flat_token tk = { type, static_cast<unsigned int>(it->first), static_cast<unsigned int>(value.length()) };
+			tokens_.push_back(tk);
+			if (type == token_type::end || type == token_type::unknown) break;
+		}
+		if (tokens_.empty() || !in(tokens_.back().type, token_type::end, token_type::unknown))
+		{
+			flat_token tk = { token_type::end, static_cast<unsigned int>(source.length()), 0 };
+			tokens_.push_back(tk);
+		}
+		return compile_tokens(source.c_str());
+	}
+
+private:
+	std::unique_ptr<basic_expression<T>> compile_tokens(const wchar_t* source)
+	{
+		source_ = source;
+		variables_.clear();
+		size_t advance = 0;
+		std::unique_ptr<basic_expression<T>> ret = compile_additive(0, advance);
+		source_ = nullptr;
+		
+		// Link all variables to root expression
+		if (ret)
+		{
+			for (basic_variable_expression<T>* var : variables_)
+			{
+				var->set_root(ret.get());
+			}
+		}
+		
+		return ret;
+	}
+
+	// helpers over the flat token buffer; it always ends with an end or unknown
+	// token, which is its own successor, so indices never run past the buffer
+	size_t next(size_t i) const { return (i + 1 < tokens_.size()) ? i + 1 : i; }
+	bool is(size_t i, token_type type) const { return tokens_[i].type == type; }
+	bool is(size_t i, token_type type, const wchar_t* value) const
+	{
+		const flat_token& tk = tokens_[i];
+		return tk.type == type && tk.length == wcslen(value) && wmemcmp(source_ + tk.offset, value, tk.length) == 0;
+	}
+	std::wstring text(size_t i) const { return std::wstring(source_ + tokens_[i].offset, tokens_[i].length); }
+	
+	// number literal, converted from a bounded copy so wcstold stops at the token end
+	long double number_value(size_t i) const
+	{
+		const flat_token& tk = tokens_[i];
+		wchar_t buffer[64];
+		if (tk.length >= sizeof(buffer) / sizeof(buffer[0]))
+			return std::wcstold(text(i).c_str(), nullptr);
+		wmemcpy(buffer, source_ + tk.offset, tk.length);
+		buffer[tk.length] = 0;
+		return std::wcstold(buffer, nullptr);
+	}
+
+	// parse number literal
+	std::unique_ptr<basic_number_constant_expression<T>> compile_constant_number(size_t start, size_t& advance)
+	{
+		if (!is(start, token_type::number)) return nullptr;
+		std::unique_ptr<basic_number_constant_expression<T>> num = std::make_unique<basic_number_constant_expression<T>>();
+		num->number = static_cast<T>(number_value(start));
+		advance = next(start);
+		return num;
+	}
+
+	// parse parenthesized subexpression
+	std::unique_ptr<basic_expression<T>> compile_subexpression(size_t start, size_t& advance)
+	{
+		if (!is(start, token_type::expression_bound, L"(")) return nullptr;
+		// move to token after '('
+		size_t inner_start = next(start);
+		size_t inner_advance = inner_start;
+		std::unique_ptr<basic_expression<T>> inner_expr = compile_additive(inner_start, inner_advance);
+		if (!inner_expr) return nullptr;
+		// now inner_advance should point to token right after expression; expect ')'
+		if (!is(inner_advance, token_type::expression_bound, L")")) return nullptr;
+		// set advance to token after ')'
+		advance = next(inner_advance);
+		std::unique_ptr<basic_sub_expression<T>> node = std::make_unique<basic_sub_expression<T>>();
+		node->inner_expression = std::move(inner_expr);
+		return node;
+	}
+
+	// primary: number | (expr) | function-call | constant | variable
+	std::unique_ptr<basic_expression<T>> compile_primary(size_t start, size_t& advance)
+	{
+		// identifier -- possible function call, constant, or variable
+		if (is(start, token_type::identifier))
+		{
+			std::wstring name = text(start);
+			size_t after_name = next(start);
+			if (is(after_name, token_type::expression_bound, L"("))
+			{
+				// function call - resolve function at compile time
+				const typename basic_function_registry<T>::function_entry* func_entry = basic_function_registry<T>::instance().get(name);
+				if (!func_entry)
+				{
+					throw std::runtime_error("Unknown function: " + std::string(name.begin(), name.end()));
+				}
+				
+				// Parse arguments
+				std::vector<std::unique_ptr<basic_expression<T>>> args;
+				
+				// position after '(', the closing ')' once found
+				size_t close = next(after_name);
+				
+				// empty arg list?
+				if (!is(close, token_type::expression_bound, L")"))
+				{
+					// parse comma-separated arguments
+					size_t cur = close;
+					while (true)
+					{
+						size_t arg_end = cur;
+						std::unique_ptr<basic_expression<T>> arg_expr = compile_additive(cur, arg_end);
+						if (!arg_expr) return nullptr;
 						args.push_back(std::move(arg_expr));
-						// move to token at arg_end
-						cur_it = it_at(tokenz, arg_end);
-						cur_it = skip_spaces_it(tokenz, cur_it);
-						if (cur_it == tokenz.end()) return nullptr;
+						cur = arg_end;
 						// if comma, consume and continue
-						if (cur_it->second->type() == token_type::comma)
+						if (is(cur, token_type::comma))
 						{
-							cur_it = std::next(cur_it);
-							cur_it = skip_spaces_it(tokenz, cur_it);
+							cur = next(cur);
 							continue;
 						}
 						// if closing ')', done
-						if (cur_it->second->type() == token_type::expression_bound && cur_it->second->value == L")")
+						if (is(cur, token_type::expression_bound, L")"))
 						{
-							it_after_lparen = cur_it;
+							close = cur;
 							break;
 						}
 						// otherwise parse error
@@ -1012,14 +2553,11 @@ public:
 					{
 						throw std::runtime_error("Function " + std::string(name.begin(), name.end()) + " expects 1 argument, got " + std::to_string(args.size()));
 					}
-					std::unique_ptr<unary_function_expression> uf = std::make_unique<unary_function_expression>();
+					std::unique_ptr<basic_unary_function_expression<T>> uf = std::make_unique<basic_unary_function_expression<T>>();
 					uf->func = func_entry->unary_func;
 					uf->deriv_func = func_entry->unary_deriv;
 					uf->arg = std::move(args[0]);
-					
-					token_map_iterator it_after = std::next(it_after_lparen);
-					if (it_after == tokenz.end()) advance = it_after_lparen->first;
-					else advance = it_after->first;
+					advance = next(close);
 					return uf;
 				}
 				else if (func_entry->arity == 2)
@@ -1028,16 +2566,13 @@ public:
 					{
 						throw std::runtime_error("Function " + std::string(name.begin(), name.end()) + " expects 2 arguments, got " + std::to_string(args.size()));
 					}
-					std::unique_ptr<binary_function_expression> bf = std::make_unique<binary_function_expression>();
+					std::unique_ptr<basic_binary_function_expression<T>> bf = std::make_unique<basic_binary_function_expression<T>>();
 					bf->func = func_entry->binary_func;
 					bf->deriv_func_arg1 = func_entry->binary_deriv_arg1;
 					bf->deriv_func_arg2 = func_entry->binary_deriv_arg2;
 					bf->arg1 = std::move(args[0]);
 					bf->arg2 = std::move(args[1]);
-					
-					token_map_iterator it_after = std::next(it_after_lparen);
-					if (it_after == tokenz.end()) advance = it_after_lparen->first;
-					else advance = it_after->first;
+					advance = next(close);
 					return bf;
 				}
 				else
@@ -1049,59 +2584,47 @@ public:
 			// Not a function call - check if it's a built-in constant
 			if (constant_registry::instance().has(name))
 			{
-				std::unique_ptr<number_constant_expression> c = std::make_unique<number_constant_expression>();
+				std::unique_ptr<basic_number_constant_expression<T>> c = std::make_unique<basic_number_constant_expression<T>>();
 				c->number = constant_registry::instance().get(name);
-				if (it_next == tokenz.end()) advance = it->first;
-				else advance = it_next->first;
+				advance = after_name;
 				return c;
 			}
 			
 			// Not a constant - it's a variable
-			std::unique_ptr<variable_expression> var = std::make_unique<variable_expression>(name);
+			std::unique_ptr<basic_variable_expression<T>> var = std::make_unique<basic_variable_expression<T>>(name);
 			variables_.push_back(var.get());  // track for root assignment
-			
-			if (it_next == tokenz.end()) advance = it->first;
-			else advance = it_next->first;
+			advance = after_name;
 			return var;
 		}
 
 		// parenthesis
-		std::unique_ptr<expression> sub = compile_subexpression(tokenz, it->first, advance);
+		std::unique_ptr<basic_expression<T>> sub = compile_subexpression(start, advance);
 		if (sub) return sub;
 
 		// number
-		std::unique_ptr<number_constant_expression> num = compile_constant_number(tokenz, it->first, advance);
+		std::unique_ptr<basic_number_constant_expression<T>> num = compile_constant_number(start, advance);
 		if (num) return num;
 
 		return nullptr;
 	}
 
 	// power: primary (** power)*  (right-associative)
-	std::unique_ptr<expression> compile_power(const token_map& tokenz, size_t start_pos, size_t& advance)
+	std::unique_ptr<basic_expression<T>> compile_power(size_t start, size_t& advance)
 	{
-		size_t cur = start_pos;
-		std::unique_ptr<expression> left = compile_primary(tokenz, cur, cur);
-		if (!left) { advance = start_pos; return nullptr; }
+		size_t cur = start;
+		std::unique_ptr<basic_expression<T>> left = compile_primary(cur, cur);
+		if (!left) { advance = start; return nullptr; }
 
-		while (true)
+		while (is(cur, token_type::binary_operator, L"**"))
 		{
-			token_map_iterator it = it_at(tokenz, cur);
-			it = skip_spaces_it(tokenz, it);
-			if (it == tokenz.end()) break;
-			if (it->second->type() != token_type::binary_operator) break;
-			if (it->second->value != L"**") break;
-			// consume '**'
-			token_map_iterator it_after = std::next(it);
-			it_after = skip_spaces_it(tokenz, it_after);
-			if (it_after == tokenz.end()) return nullptr;
 			// right-associative: parse right as power
-			size_t right_start = it_after->first;
+			size_t right_start = next(cur);
 			size_t right_end = right_start;
-			std::unique_ptr<expression> right = compile_power(tokenz, right_start, right_end);
+			std::unique_ptr<basic_expression<T>> right = compile_power(right_start, right_end);
 			if (!right) return nullptr;
-			std::unique_ptr<binary_expression> p = std::make_unique<binary_expression>();
+			std::unique_ptr<basic_binary_expression<T>> p = std::make_unique<basic_binary_expression<T>>();
 			p->op = expresie_tokenizer::power;
-			p->eval_func_discrete = [](long double a, long double b) { return std::powl(a, b); };
+			p->eval_func_discrete = [](T a, T b) { return std::pow(a, b); };
 			p->left = std::move(left);
 			p->right = std::move(right);
 			left = std::move(p);
@@ -1112,81 +2635,55 @@ public:
 	}
 
 	// unary: [+|-] power  (unary binds looser than power, so we parse power first for operand)
-	std::unique_ptr<expression> compile_unary(const token_map& tokenz, size_t start_pos, size_t& advance)
+	std::unique_ptr<basic_expression<T>> compile_unary(size_t start, size_t& advance)
 	{
-		token_map_iterator it = it_at(tokenz, start_pos);
-		it = skip_spaces_it(tokenz, it);
-		if (it == tokenz.end()) { advance = start_pos; return nullptr; }
-
-		if (it->second->type() == token_type::unary_operator)
+		if (is(start, token_type::unary_operator))
 		{
-			std::wstring opv = it->second->value;
-			// consume unary op
-			token_map_iterator it_after = std::next(it);
-			it_after = skip_spaces_it(tokenz, it_after);
-			if (it_after == tokenz.end()) { advance = start_pos; return nullptr; }
-			size_t operand_start = it_after->first;
+			bool minus = is(start, token_type::unary_operator, L"-");
+			// consume unary op, parse next as power (so power binds tighter)
+			size_t operand_start = next(start);
 			size_t operand_end = operand_start;
-			// parse next as power (so power binds tighter)
-			std::unique_ptr<expression> operand = compile_power(tokenz, operand_start, operand_end);
+			std::unique_ptr<basic_expression<T>> operand = compile_power(operand_start, operand_end);
 			if (!operand) return nullptr;
-			if (opv == L"+")
-			{
-				advance = operand_end;
+			advance = operand_end;
+			if (!minus)
 				return operand; // unary plus no-op
-			}
-			else if (opv == L"-")
-			{
-				std::unique_ptr<unary_expression> ue = std::make_unique<unary_expression>();
-				ue->operand = std::move(operand);
-				ue->op = unary_minus;
-				ue->eval_func = [](long double a) { return -a; };
-				advance = operand_end;
-				return ue;
-			}
-			else
-			{
-				advance = start_pos;
-				return nullptr;
-			}
+			std::unique_ptr<basic_unary_expression<T>> ue = std::make_unique<basic_unary_expression<T>>();
+			ue->operand = std::move(operand);
+			ue->op = unary_minus;
+			ue->eval_func = [](T a) { return -a; };
+			return ue;
 		}
 		// no unary operator -> parse power directly
-		return compile_power(tokenz, it->first, advance);
+		return compile_power(start, advance);
 	}
 
 	// multiplicative: unary ((*|/) unary)*
-	std::unique_ptr<expression> compile_multiplicative(const token_map& tokenz, size_t start_pos, size_t& advance)
+	std::unique_ptr<basic_expression<T>> compile_multiplicative(size_t start, size_t& advance)
 	{
-		size_t cur = start_pos;
-		std::unique_ptr<expression> left = compile_unary(tokenz, cur, cur);
-		if (!left) { advance = start_pos; return nullptr; }
+		size_t cur = start;
+		std::unique_ptr<basic_expression<T>> left = compile_unary(cur, cur);
+		if (!left) { advance = start; return nullptr; }
 
 		while (true)
 		{
-			token_map_iterator it = it_at(tokenz, cur);
-			it = skip_spaces_it(tokenz, it);
-			if (it == tokenz.end()) break;
-			if (it->second->type() != token_type::binary_operator) break;
-			std::wstring opv = it->second->value;
-			if (opv != L"*" && opv != L"/") break;
+			bool mul = is(cur, token_type::binary_operator, L"*");
+			if (!mul && !is(cur, token_type::binary_operator, L"/")) break;
 			// consume op
-			token_map_iterator it_after = std::next(it);
-			it_after = skip_spaces_it(tokenz, it_after);
-			if (it_after == tokenz.end()) return nullptr;
-			size_t right_start = it_after->first;
+			size_t right_start = next(cur);
 			size_t right_end = right_start;
-			std::unique_ptr<expression> right = compile_unary(tokenz, right_start, right_end);
+			std::unique_ptr<basic_expression<T>> right = compile_unary(right_start, right_end);
 			if (!right) return nullptr;
-			std::unique_ptr<binary_expression> b = std::make_unique<binary_expression>();
-			if (opv == L"*")
+			std::unique_ptr<basic_binary_expression<T>> b = std::make_unique<basic_binary_expression<T>>();
+			if (mul)
 			{
 				b->op = expresie_tokenizer::multiply;
-				b->eval_func_discrete = [](long double a, long double b) { return a * b; };
+				b->eval_func_discrete = [](T a, T b) { return a * b; };
 			}
 			else
 			{
 				b->op = expresie_tokenizer::divide;
-				b->eval_func_discrete = [](long double a, long double b) { return a / b; };
+				b->eval_func_discrete = [](T a, T b) { return a / b; };
 			}
 			b->left = std::move(left);
 			b->right = std::move(right);
@@ -1198,38 +2695,31 @@ public:
 	}
 
 	// additive: multiplicative ((+|-) multiplicative)*
-	std::unique_ptr<expression> compile_additive(const token_map& tokenz, size_t start_pos, size_t& advance)
+	std::unique_ptr<basic_expression<T>> compile_additive(size_t start, size_t& advance)
 	{
-		size_t cur = start_pos;
-		std::unique_ptr<expression> left = compile_multiplicative(tokenz, cur, cur);
-		if (!left) { advance = start_pos; return nullptr; }
+		size_t cur = start;
+		std::unique_ptr<basic_expression<T>> left = compile_multiplicative(cur, cur);
+		if (!left) { advance = start; return nullptr; }
 
 		while (true)
 		{
-			token_map_iterator it = it_at(tokenz, cur);
-			it = skip_spaces_it(tokenz, it);
-			if (it == tokenz.end()) break;
-			if (it->second->type() != token_type::binary_operator) break;
-			std::wstring opv = it->second->value;
-			if (opv != L"+" && opv != L"-") break;
+			bool add = is(cur, token_type::binary_operator, L"+");
+			if (!add && !is(cur, token_type::binary_operator, L"-")) break;
 			// consume op
-			token_map_iterator it_after = std::next(it);
-			it_after = skip_spaces_it(tokenz, it_after);
-			if (it_after == tokenz.end()) return nullptr;
-			size_t right_start = it_after->first;
+			size_t right_start = next(cur);
 			size_t right_end = right_start;
-			std::unique_ptr<expression> right = compile_multiplicative(tokenz, right_start, right_end);
+			std::unique_ptr<basic_expression<T>> right = compile_multiplicative(right_start, right_end);
 			if (!right) return nullptr;
-			std::unique_ptr<binary_expression> b = std::make_unique<binary_expression>();
-			if (opv == L"+")
+			std::unique_ptr<basic_binary_expression<T>> b = std::make_unique<basic_binary_expression<T>>();
+			if (add)
 			{
 				b->op = expresie_tokenizer::plus;
-				b->eval_func_discrete = [](long double a, long double b) { return a + b; };
+				b->eval_func_discrete = [](T a, T b) { return a + b; };
 			}
 			else
 			{
 				b->op = expresie_tokenizer::minus;
-				b->eval_func_discrete = [](long double a, long double b) { return a - b; };
+				b->eval_func_discrete = [](T a, T b) { return a - b; };
 			}
 			b->left = std::move(left);
 			b->right = std::move(right);
@@ -1241,6 +2731,198 @@ public:
 	}
 };
 
+//========================================
+// Formula cache - process-wide LRU of compiled programs and derivatives
+// Keyed by the formula with case folded and insignificant whitespace
+// dropped, so "Cos(5*theta)" and "cos( 5 * theta )" share one entry.
+// The key is what gets compiled: whitespace the tokenizer needs stays.
+// Entries are immutable once published and shared across threads, each
+// caller evaluates through its own basic_program_state.
+//========================================
+template <typename T>
+struct basic_compiled_formula
+{
+	std::wstring key;                                                 // normalized formula
+	std::wstring wrt;                                                 // derivative variable, lowercase
+	std::shared_ptr<const basic_expression_program<T>> program;
+	std::shared_ptr<const basic_expression_program<T>> derivative;    // simplified d/dwrt, nullptr if not differentiable
+};
+
+template <typename T>
+class basic_formula_cache
+{
+public:
+	using entry = basic_compiled_formula<T>;
+	using entry_ptr = std::shared_ptr<const entry>;
+
+	static basic_formula_cache<T>& instance()
+	{
+		static basic_formula_cache<T> cache;
+		return cache;
+	}
+
+	// lowercase, whitespace kept as one space where the tokenizer reads it: between two
+	// identifier characters, two operator characters ("5 - -3" is not "5--3") and after
+	// an exponent-like 'e' before a sign ("2e -3" is not the number "2e-3")
+	static std::wstring normalize(const std::wstring& formula)
+	{
+		std::wstring key;
+		key.reserve(formula.size());
+		bool pending_space = false;
+		for (wchar_t c : formula)
+		{
+			if (std::iswspace(c)) { pending_space = !key.empty(); continue; }
+			if (pending_space && is_significant_space(key.back(), c))
+				key.push_back(L' ');
+			pending_space = false;
+			key.push_back(static_cast<wchar_t>(std::towlower(c)));
+		}
+		return key;
+	}
+
+	// compiled formula for `formula`, compiling on a miss; throws what the compiler throws
+	entry_ptr get(const std::wstring& formula, const std::wstring& wrt = L"theta")
+	{
+		std::wstring key = normalize(formula);
+		std::wstring lwrt = normalize(wrt);
+		std::wstring map_key = key + L'\n' + lwrt;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			typename std::unordered_map<std::wstring, typename lru_list::iterator>::iterator it = index_.find(map_key);
+			if (it != index_.end())
+			{
+				++hits_;
+				lru_.splice(lru_.begin(), lru_, it->second);
+				return it->second->second;
+			}
+			++misses_;
+		}
+
+		// compile outside the lock; a concurrent miss on the same key keeps the first entry published
+		entry_ptr compiled = compile(key, lwrt);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		typename std::unordered_map<std::wstring, typename lru_list::iterator>::iterator it = index_.find(map_key);
+		if (it != index_.end())
+			return it->second->second;
+		lru_.emplace_front(map_key, compiled);
+		index_[map_key] = lru_.begin();
+		evict();
+		return compiled;
+	}
+
+	size_t hits() const { std::lock_guard<std::mutex> lock(mutex_); return hits_; }
+	size_t misses() const { std::lock_guard<std::mutex> lock(mutex_); return misses_; }
+	size_t size() const { std::lock_guard<std::mutex> lock(mutex_); return lru_.size(); }
+	size_t capacity() const { std::lock_guard<std::mutex> lock(mutex_); return capacity_; }
+
+	void set_capacity(size_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		capacity_ = capacity ? capacity : 1;
+		evict();
+	}
+
+	// drops every entry, programs already handed out stay alive through their owners
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		lru_.clear();
+		index_.clear();
+	}
+
+	void reset_counters()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		hits_ = misses_ = 0;
+	}
+
+private:
+	using lru_list = std::list<std::pair<std::wstring, entry_ptr>>;
+
+	basic_formula_cache() = default;
+	basic_formula_cache(const basic_formula_cache&) = delete;
+	basic_formula_cache& operator=(const basic_formula_cache&) = delete;
+
+	static bool is_identifier_char(wchar_t c)
+	{
+		return std::iswalnum(c) || c == L'_' || c == L'.';
+	}
+
+	static bool is_operator_char(wchar_t c)
+	{
+		return c == L'+' || c == L'-' || c == L'*' || c == L'/' || c == L'%' || c == L'=';
+	}
+
+	static bool is_significant_space(wchar_t before, wchar_t after)
+	{
+		if (is_identifier_char(before) && is_identifier_char(after)) return true;
+		if (is_operator_char(before) && is_operator_char(after)) return true;
+		return std::towlower(before) == L'e' && (after == L'+' || after == L'-');
+	}
+
+	static entry_ptr compile(const std::wstring& key, const std::wstring& wrt)
+	{
+		basic_expression_token_compiler<T> compiler;
+		std::unique_ptr<basic_expression<T>> tree = compiler.compile(key);
+		if (!tree)
+			throw std::runtime_error("Empty formula");
+
+		std::shared_ptr<entry> compiled = std::make_shared<entry>();
+		compiled->key = key;
+		compiled->wrt = wrt;
+		try
+		{
+			compiled->derivative = compile_program(*simplify(tree->derivative(wrt)));
+		}
+		catch (const std::runtime_error&)
+		{
+			// variable exponents and functions without a derivative: evaluate r only
+		}
+		compiled->program = compile_program(*simplify(std::move(tree)));
+		return compiled;
+	}
+
+	void evict()
+	{
+		while (lru_.size() > capacity_)
+		{
+			index_.erase(lru_.back().first);
+			lru_.pop_back();
+		}
+	}
+
+	mutable std::mutex mutex_;
+	lru_list lru_;                                                              // most recently used first
+	std::unordered_map<std::wstring, typename lru_list::iterator> index_;
+	size_t capacity_ = 64;
+	size_t hits_ = 0;
+	size_t misses_ = 0;
+};
+
+//========================================
+// Scalar type aliases - the engine is templated on T, the plain names keep
+// long double for the 3DCalculator precision use case; instantiate
+// basic_*<double> or basic_*<float> where the result is narrowed anyway
+//========================================
+using expression_context = basic_expression_context<long double>;
+using expression = basic_expression<long double>;
+using constant_expression = basic_constant_expression<long double>;
+using sub_expression = basic_sub_expression<long double>;
+using number_constant_expression = basic_number_constant_expression<long double>;
+using variable_expression = basic_variable_expression<long double>;
+using unary_expression = basic_unary_expression<long double>;
+using binary_expression = basic_binary_expression<long double>;
+using unary_function_expression = basic_unary_function_expression<long double>;
+using binary_function_expression = basic_binary_function_expression<long double>;
+using function_registry = basic_function_registry<long double>;
+using interval = basic_interval<long double>;
+using program_instruction = basic_program_instruction<long double>;
+using expression_program = basic_expression_program<long double>;
+using expression_token_compiler = basic_expression_token_compiler<long double>;
+using compiled_formula = basic_compiled_formula<long double>;
+using formula_cache = basic_formula_cache<long double>;
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,468 @@
+#pragma once
+#ifndef __EXPRESSION_SIMD_H__
+#define __EXPRESSION_SIMD_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define EXPRESSION_SIMD_AVX
+#elif defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXPRESSION_SIMD_SSE2
+#endif
+
+namespace expresie_tokenizer
+{
+namespace simd
+{
+//========================================
+// Lanes - the widest double vector the target was compiled for
+// AVX (/arch:AVX, -mavx): 4 lanes, SSE2 (any x64): 2 lanes, otherwise scalar
+//========================================
+#if defined(EXPRESSION_SIMD_AVX)
+typedef __m256d lanes;
+typedef __m256d mask;
+const size_t width = 4;
+
+inline lanes load(const double* p)           { return _mm256_loadu_pd(p); }
+inline void  store(double* p, lanes a)       { _mm256_storeu_pd(p, a); }
+inline lanes set1(double v)                  { return _mm256_set1_pd(v); }
+inline lanes add(lanes a, lanes b)           { return _mm256_add_pd(a, b); }
+inline lanes sub(lanes a, lanes b)           { return _mm256_sub_pd(a, b); }
+inline lanes mul(lanes a, lanes b)           { return _mm256_mul_pd(a, b); }
+inline lanes div(lanes a, lanes b)           { return _mm256_div_pd(a, b); }
+inline lanes sqrt(lanes a)                   { return _mm256_sqrt_pd(a); }
+inline lanes abs(lanes a)                    { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+inline lanes trunc(lanes a)                  { return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+inline mask  less(lanes a, lanes b)          { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+inline mask  less_equal(lanes a, lanes b)    { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+inline mask  both(mask a, mask b)            { return _mm256_and_pd(a, b); }
+inline lanes select(mask m, lanes a, lanes b){ return _mm256_blendv_pd(b, a, m); }
+inline bool  all(mask m)                     { return _mm256_movemask_pd(m) == 0xF; }
+
+// shift the 64-bit integer view of each lane
+inline lanes shift_left_52(lanes a)
+{
+#if defined(__AVX2__)
+	return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a), 52));
+#else
+	__m128i lo = _mm_slli_epi64(_mm256_castsi256_si128(_mm256_castpd_si256(a)), 52);
+	__m128i hi = _mm_slli_epi64(_mm256_extractf128_si256(_mm256_castpd_si256(a), 1), 52);
+	return _mm256_castsi256_pd(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+#endif
+}
+inline lanes shift_right_52(lanes a)
+{
+#if defined(__AVX2__)
+	return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a), 52));
+#else
+	__m128i lo = _mm_srli_epi64(_mm256_castsi256_si128(_mm256_castpd_si256(a)), 52);
+	__m128i hi = _mm_srli_epi64(_mm256_extractf128_si256(_mm256_castpd_si256(a), 1), 52);
+	return _mm256_castsi256_pd(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+#endif
+}
+inline lanes bit_and(lanes a, lanes b)       { return _mm256_and_pd(a, b); }
+inline lanes bit_or(lanes a, lanes b)        { return _mm256_or_pd(a, b); }
+inline lanes bits(uint64_t v)                { return _mm256_castsi256_pd(_mm256_set1_epi64x(static_cast<long long>(v))); }
+
+#elif defined(EXPRESSION_SIMD_SSE2)
+typedef __m128d lanes;
+typedef __m128d mask;
+const size_t width = 2;
+
+inline lanes load(const double* p)           { return _mm_loadu_pd(p); }
+inline void  store(double* p, lanes a)       { _mm_storeu_pd(p, a); }
+inline lanes set1(double v)                  { return _mm_set1_pd(v); }
+inline lanes add(lanes a, lanes b)           { return _mm_add_pd(a, b); }
+inline lanes sub(lanes a, lanes b)           { return _mm_sub_pd(a, b); }
+inline lanes mul(lanes a, lanes b)           { return _mm_mul_pd(a, b); }
+inline lanes div(lanes a, lanes b)           { return _mm_div_pd(a, b); }
+inline lanes sqrt(lanes a)                   { return _mm_sqrt_pd(a); }
+inline lanes abs(lanes a)                    { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+// valid for |a| < 2^31, callers range check first
+inline lanes trunc(lanes a)                  { return _mm_cvtepi32_pd(_mm_cvttpd_epi32(a)); }
+inline mask  less(lanes a, lanes b)          { return _mm_cmplt_pd(a, b); }
+inline mask  less_equal(lanes a, lanes b)    { return _mm_cmple_pd(a, b); }
+inline mask  both(mask a, mask b)            { return _mm_and_pd(a, b); }
+inline lanes select(mask m, lanes a, lanes b){ return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+inline bool  all(mask m)                     { return _mm_movemask_pd(m) == 0x3; }
+
+inline lanes shift_left_52(lanes a)          { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a), 52)); }
+inline lanes shift_right_52(lanes a)         { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a), 52)); }
+inline lanes bit_and(lanes a, lanes b)       { return _mm_and_pd(a, b); }
+inline lanes bit_or(lanes a, lanes b)        { return _mm_or_pd(a, b); }
+inline lanes bits(uint64_t v)                { return _mm_castsi128_pd(_mm_set1_epi64x(static_cast<long long>(v))); }
+
+#else
+typedef double lanes;
+typedef bool mask;
+const size_t width = 1;
+
+inline lanes load(const double* p)           { return *p; }
+inline void  store(double* p, lanes a)       { *p = a; }
+inline lanes set1(double v)                  { return v; }
+inline lanes add(lanes a, lanes b)           { return a + b; }
+inline lanes sub(lanes a, lanes b)           { return a - b; }
+inline lanes mul(lanes a, lanes b)           { return a * b; }
+inline lanes div(lanes a, lanes b)           { return a / b; }
+inline lanes sqrt(lanes a)                   { return std::sqrt(a); }
+inline lanes abs(lanes a)                    { return std::fabs(a); }
+inline lanes trunc(lanes a)                  { return std::trunc(a); }
+inline mask  less(lanes a, lanes b)          { return a < b; }
+inline mask  less_equal(lanes a, lanes b)    { return a <= b; }
+inline mask  both(mask a, mask b)            { return a && b; }
+inline lanes select(mask m, lanes a, lanes b){ return m ? a : b; }
+inline bool  all(mask m)                     { return m; }
+#endif
+
+//========================================
+// Vector math kernels over lanes
+// Cephes polynomial approximations, within 3 ulp of <cmath> in double;
+// lanes outside the reduced range fall back to <cmath> in the array kernels
+//========================================
+inline lanes floor(lanes a)
+{
+	lanes t = trunc(a);
+	return select(less(a, t), sub(t, set1(1.0)), t);
+}
+
+// 2^n for integral n in [-1022, 1023]
+inline lanes pow2i(lanes n)
+{
+#if defined(EXPRESSION_SIMD_AVX) || defined(EXPRESSION_SIMD_SSE2)
+	// n + 1023 lands in the low mantissa bits of 2^52 + n + 1023, shift it into the exponent
+	return shift_left_52(add(n, set1(4503599627370496.0 + 1023.0)));
+#else
+	return std::ldexp(1.0, static_cast<int>(n));
+#endif
+}
+
+// x = m * 2^e with m in [0.5, 1), for positive normal x
+inline lanes frexp(lanes x, lanes& e)
+{
+#if defined(EXPRESSION_SIMD_AVX) || defined(EXPRESSION_SIMD_SSE2)
+	lanes field = bit_or(shift_right_52(x), bits(0x4330000000000000ULL));  // 2^52 + biased exponent
+	e = sub(field, set1(4503599627370496.0 + 1022.0));
+	return bit_or(bit_and(x, bits(0x000FFFFFFFFFFFFFULL)), bits(0x3FE0000000000000ULL));
+#else
+	int ei = 0;
+	double m = std::frexp(x, &ei);
+	e = ei;
+	return m;
+#endif
+}
+
+inline lanes polevl(lanes x, const double* c, int n)
+{
+	lanes y = set1(c[0]);
+	for (int i = 1; i <= n; i++) y = add(mul(y, x), set1(c[i]));
+	return y;
+}
+
+inline lanes p1evl(lanes x, const double* c, int n)
+{
+	lanes y = add(x, set1(c[0]));
+	for (int i = 1; i < n; i++) y = add(mul(y, x), set1(c[i]));
+	return y;
+}
+
+const double sincof[] = { 1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6, -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1 };
+const double coscof[] = { -1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7, 2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2 };
+const double sincos_limit = 1.0e8;
+
+// Shared range reduction: x into [-pi/4, pi/4] plus octant q in {0..3}
+inline void sincos(lanes x, lanes& s, lanes& c)
+{
+	const double DP1 = 7.85398125648498535156E-1;
+	const double DP2 = 3.77489470793079817668E-8;
+	const double DP3 = 2.69515142907905952645E-15;
+	const double FOPI = 1.27323954473516268615;  // 4/pi
+
+	lanes ax = abs(x);
+	lanes y = trunc(mul(ax, set1(FOPI)));
+	lanes odd = sub(y, mul(set1(2.0), trunc(mul(y, set1(0.5)))));
+	y = add(y, odd);
+	lanes k = mul(y, set1(0.5));
+	lanes q = sub(k, mul(set1(4.0), trunc(mul(k, set1(0.25)))));     // (j >> 1) & 3
+	lanes q_odd = sub(q, mul(set1(2.0), trunc(mul(q, set1(0.5)))));
+
+	lanes z = sub(sub(sub(ax, mul(y, set1(DP1))), mul(y, set1(DP2))), mul(y, set1(DP3)));
+	lanes zz = mul(z, z);
+	lanes ps = add(z, mul(mul(z, zz), polevl(zz, sincof, 5)));
+	lanes pc = add(sub(set1(1.0), mul(zz, set1(0.5))), mul(mul(zz, zz), polevl(zz, coscof, 5)));
+
+	mask swap = less(set1(0.5), q_odd);
+	lanes sv = select(swap, pc, ps);
+	lanes cv = select(swap, ps, pc);
+
+	// sin flips for q >= 2 and for negative x; cos flips for q in {1, 2}
+	lanes one = set1(1.0), minus_one = set1(-1.0);
+	lanes sin_sign = mul(select(less(set1(1.5), q), minus_one, one), select(less(x, set1(0.0)), minus_one, one));
+	lanes cos_sign = select(both(less(set1(0.5), q), less(q, set1(2.5))), minus_one, one);
+	s = mul(sv, sin_sign);
+	c = mul(cv, cos_sign);
+}
+
+inline mask sincos_in_range(lanes x)
+{
+	return less_equal(abs(x), set1(sincos_limit));
+}
+
+const double expP[] = { 1.26177193074810590878E-4, 3.02994407707441961300E-2, 9.99999999999999999910E-1 };
+const double expQ[] = { 3.00198505138664455042E-6, 2.52448340349684104192E-3, 2.27265548208155028766E-1, 2.00000000000000000009E0 };
+
+inline lanes exp(lanes x)
+{
+	const double C1 = 6.93145751953125E-1;
+	const double C2 = 1.42860682030941723212E-6;
+	const double LOG2E = 1.4426950408889634073599;
+
+	lanes n = floor(add(mul(x, set1(LOG2E)), set1(0.5)));
+	x = sub(x, mul(n, set1(C1)));
+	x = sub(x, mul(n, set1(C2)));
+	lanes xx = mul(x, x);
+	lanes px = mul(x, polevl(xx, expP, 2));
+	x = div(px, sub(polevl(xx, expQ, 3), px));
+	x = add(set1(1.0), mul(set1(2.0), x));
+	return mul(x, pow2i(n));
+}
+
+inline mask exp_in_range(lanes x)
+{
+	return both(less_equal(set1(-707.0), x), less_equal(x, set1(709.0)));
+}
+
+const double logP[] = { 1.01875663804580931796E-4, 4.97494994976747001425E-1, 4.70579119878881725854E0, 1.44989225341610930846E1, 1.79368678507819816313E1, 7.70838733755885391666E0 };
+const double logQ[] = { 1.12873587189167450590E1, 4.52279145837532221105E1, 8.29875266912776603211E1, 7.11544750618563894466E1, 2.31251620126765340583E1 };
+
+inline lanes log(lanes x)
+{
+	const double SQRTH = 0.70710678118654752440;
+
+	lanes e;
+	lanes m = frexp(x, e);
+	mask small = less(m, set1(SQRTH));
+	e = select(small, sub(e, set1(1.0)), e);
+	m = select(small, sub(add(m, m), set1(1.0)), sub(m, set1(1.0)));
+
+	lanes z = mul(m, m);
+	lanes y = mul(m, div(mul(z, polevl(m, logP, 5)), p1evl(m, logQ, 5)));
+	y = sub(y, mul(e, set1(2.121944400546905827679e-4)));
+	y = sub(y, mul(z, set1(0.5)));
+	z = add(m, y);
+	return add(z, mul(e, set1(0.693359375)));
+}
+
+inline mask log_in_range(lanes x)
+{
+	return both(less_equal(set1(2.2250738585072014e-308), x), less_equal(x, set1(1.7976931348623157e308)));
+}
+
+//========================================
+// Array kernels - out[i] = f(in[i]) for n a multiple of width
+// Signature shared with the batch hook of function_registry
+//========================================
+typedef void (*batch_fn_t)(const double* in, double* out, size_t n);
+
+inline void sin_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes x = load(in + i), s, c;
+		if (!all(sincos_in_range(x)))
+		{
+			for (size_t l = i; l < i + width; l++) out[l] = std::sin(in[l]);
+			continue;
+		}
+		sincos(x, s, c);
+		store(out + i, s);
+	}
+}
+
+inline void cos_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes x = load(in + i), s, c;
+		if (!all(sincos_in_range(x)))
+		{
+			for (size_t l = i; l < i + width; l++) out[l] = std::cos(in[l]);
+			continue;
+		}
+		sincos(x, s, c);
+		store(out + i, c);
+	}
+}
+
+// d/dx cos(x)
+inline void neg_sin_batch(const double* in, double* out, size_t n)
+{
+	sin_batch(in, out, n);
+	for (size_t i = 0; i < n; i += width) store(out + i, mul(load(out + i), set1(-1.0)));
+}
+
+inline void tan_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes x = load(in + i), s, c;
+		if (!all(sincos_in_range(x)))
+		{
+			for (size_t l = i; l < i + width; l++) out[l] = std::tan(in[l]);
+			continue;
+		}
+		sincos(x, s, c);
+		store(out + i, div(s, c));
+	}
+}
+
+// d/dx tan(x) = 1 / cos(x)^2
+inline void sec2_batch(const double* in, double* out, size_t n)
+{
+	cos_batch(in, out, n);
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes c = load(out + i);
+		store(out + i, div(set1(1.0), mul(c, c)));
+	}
+}
+
+inline void exp_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes x = load(in + i);
+		if (!all(exp_in_range(x)))
+		{
+			for (size_t l = i; l < i + width; l++) out[l] = std::exp(in[l]);
+			continue;
+		}
+		store(out + i, exp(x));
+	}
+}
+
+inline void log_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes x = load(in + i);
+		if (!all(log_in_range(x)))
+		{
+			for (size_t l = i; l < i + width; l++) out[l] = std::log(in[l]);
+			continue;
+		}
+		store(out + i, log(x));
+	}
+}
+
+// d/dx log(x)
+inline void reciprocal_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width) store(out + i, div(set1(1.0), load(in + i)));
+}
+
+inline void sqrt_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width) store(out + i, sqrt(load(in + i)));
+}
+
+// d/dx sqrt(x)
+inline void half_rsqrt_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width) store(out + i, div(set1(0.5), sqrt(load(in + i))));
+}
+
+inline void abs_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width) store(out + i, abs(load(in + i)));
+}
+
+// d/dx abs(x)
+inline void sign_batch(const double* in, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+		store(out + i, select(less(load(in + i), set1(0.0)), set1(-1.0), set1(1.0)));
+}
+
+//========================================
+// Fused kernels - one range reduction for both outputs
+//========================================
+inline void sincos_batch(const double* in, double* s_out, double* c_out, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes x = load(in + i), s, c;
+		if (!all(sincos_in_range(x)))
+		{
+			for (size_t l = i; l < i + width; l++) { s_out[l] = std::sin(in[l]); c_out[l] = std::cos(in[l]); }
+			continue;
+		}
+		sincos(x, s, c);
+		store(s_out + i, s);
+		store(c_out + i, c);
+	}
+}
+
+//========================================
+// Dual kernels - out[i] = f(in[i]), deriv[i] = f'(in[i]) in one pass
+// Signature shared with the dual hook of function_registry
+//========================================
+typedef void (*dual_batch_fn_t)(const double* in, double* out, double* deriv, size_t n);
+
+inline void sin_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	sincos_batch(in, out, deriv, n);
+}
+
+inline void cos_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	sincos_batch(in, deriv, out, n);
+	for (size_t i = 0; i < n; i += width) store(deriv + i, mul(load(deriv + i), set1(-1.0)));
+}
+
+inline void tan_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	sincos_batch(in, out, deriv, n);
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes s = load(out + i), c = load(deriv + i);
+		store(out + i, div(s, c));
+		store(deriv + i, div(set1(1.0), mul(c, c)));
+	}
+}
+
+inline void sqrt_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	for (size_t i = 0; i < n; i += width)
+	{
+		lanes r = sqrt(load(in + i));
+		store(out + i, r);
+		store(deriv + i, div(set1(0.5), r));
+	}
+}
+
+inline void exp_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	exp_batch(in, out, n);
+	for (size_t i = 0; i < n; i += width) store(deriv + i, load(out + i));
+}
+
+inline void log_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	log_batch(in, out, n);
+	reciprocal_batch(in, deriv, n);
+}
+
+inline void abs_dual_batch(const double* in, double* out, double* deriv, size_t n)
+{
+	abs_batch(in, out, n);
+	sign_batch(in, deriv, n);
+}
+
+} // namespace simd
+} // namespace expresie_tokenizer
+
+#endif
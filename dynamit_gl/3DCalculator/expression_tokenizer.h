@@ -3,6 +3,9 @@
 #define __EXPRESSION_TOKENIZER_H__
 #include <iostream>
 #include <cassert>
+#include <cwchar>
+#include <cwctype>
+#include <vector>
 #include "syntax_tree.h"
 
 namespace expresie_tokenizer
@@ -261,9 +264,14 @@ public:
 class unary_operator_tokenizer : public tokenizer<unary_operator_token>
 {
 public:
-	syntax_tree t = syntax_tree::merge<std::wstring>(L"+", L"-");
+	const syntax_automaton& t = operators();
 	
 	unary_operator_tokenizer() {}
+	static const syntax_automaton& operators()
+	{
+		static const syntax_automaton frozen = syntax_automaton::freeze(syntax_tree::merge<std::wstring>(L"+", L"-"));
+		return frozen;
+	}
 	
 	token_result check(wchar_t c)
 	{
@@ -281,7 +289,7 @@ public:
 	{
 		if (tkn->value.empty())
 			return token_result::reject;
-		syntax_tree::search_result res = t.find(tkn->value);
+		syntax_automaton::search_result res = t.find(tkn->value);
 		if (!res.found)
 			return token_result::reject;
 		return token_result::accept;
@@ -291,8 +299,13 @@ public:
 class binary_operator_tokenizer : public tokenizer <binary_operator_token>
 {
 public:
-	syntax_tree t = syntax_tree::merge <std::wstring>(L"+", L"-", L"*", L"**", L"/", L"%", L"==");
+	const syntax_automaton& t = operators();
 	binary_operator_tokenizer() {}
+	static const syntax_automaton& operators()
+	{
+		static const syntax_automaton frozen = syntax_automaton::freeze(syntax_tree::merge <std::wstring>(L"+", L"-", L"*", L"**", L"/", L"%", L"=="));
+		return frozen;
+	}
 	token_result check(wchar_t c)
 	{
 		if (t.in_alphabet(c))
@@ -307,7 +320,7 @@ public:
 	{
 		std::unique_ptr<binary_operator_token> x = nullptr;
 		x.reset(flush_result());
-		syntax_tree::search_result res = t.find(x->value);
+		syntax_automaton::search_result res = t.find(x->value);
 		if (!(res.found || res.partial_finish))  return token_result::reject;
 		set(x->value.substr(0, res.iterated));
 		return token_result::accept;
@@ -334,15 +347,20 @@ public:
 class expression_bound_tokenizer : public tokenizer <expression_bound_token>
 {
 public:
-	syntax_tree syntax_tree = syntax_tree::merge <std::wstring>(L"(", L")");
+	const syntax_automaton& t = bounds();
 	expression_bound_tokenizer() {}
+	static const syntax_automaton& bounds()
+	{
+		static const syntax_automaton frozen = syntax_automaton::freeze(syntax_tree::merge <std::wstring>(L"(", L")"));
+		return frozen;
+	}
 	std::wstring accumulator;
 	token_result check(wchar_t c)
 	{
-		if (syntax_tree.in_alphabet(c))
+		if (t.in_alphabet(c))
 		{
 			accumulator += c;
-			syntax_tree::search_result res = syntax_tree.find(accumulator);
+			syntax_automaton::search_result res = t.find(accumulator);
 			if (res.found)
 				feed(c);
 			return token_result::accept;
@@ -355,7 +373,7 @@ public:
 		accumulator = L"";
 		std::unique_ptr<expression_bound_token> x = nullptr;
 		x.reset(flush_result());
-		syntax_tree::search_result res = syntax_tree.find(x->value);
+		syntax_automaton::search_result res = t.find(x->value);
 		if (res.final)
 		{
 			if (expected.length() > 0)
@@ -780,5 +798,299 @@ public:
 
 };
 
+//========================================
+// Flat tokenizer - the grammar of expression_token_reader without allocation
+// Tokens are POD (type, offset, length) into the source, appended to a
+// caller-owned vector that keeps its capacity between calls. Spaces are
+// not emitted; the last token is always end, or unknown covering the
+// unparsed tail, so a parser never runs off the buffer.
+//========================================
+struct flat_token
+{
+	token_type type;
+	unsigned int offset;
+	unsigned int length;
+};
+
+class flat_token_reader
+{
+private:
+	const wchar_t* src_ = nullptr;
+	size_t length_ = 0;
+	std::vector<flat_token>* tokens_ = nullptr;
+
+	void push(token_type type, size_t offset, size_t length)
+	{
+		flat_token tk = { type, static_cast<unsigned int>(offset), static_cast<unsigned int>(length) };
+		tokens_->push_back(tk);
+	}
+
+	bool at(size_t pos, wchar_t c) const { return pos < length_ && src_[pos] == c; }
+
+	size_t scan_spaces(size_t pos) const
+	{
+		size_t i = pos;
+		while (i < length_ && iswspace(src_[i])) i++;
+		return i - pos;
+	}
+
+	// number_tokenizer: digits, one dot, one exponent with an optional sign; 0 if none or malformed
+	size_t scan_number(size_t pos) const
+	{
+		bool has_dot = false, has_exp = false, exp_sign_allowed = false;
+		size_t i = pos;
+		for (; i < length_; i++)
+		{
+			wchar_t c = src_[i];
+			if (iswdigit(c)) exp_sign_allowed = false;
+			else if (c == L'.' && !has_dot && !has_exp) { has_dot = true; exp_sign_allowed = false; }
+			else if ((c == L'e' || c == L'E') && !has_exp && i > pos) { has_exp = true; exp_sign_allowed = true; }
+			else if ((c == L'+' || c == L'-') && exp_sign_allowed) exp_sign_allowed = false;
+			else break;
+		}
+		if (i == pos) return 0;
+		if (in(src_[i - 1], L'e', L'E', L'+', L'-', L'.')) return 0;
+		return i - pos;
+	}
+
+	// function_tokenizer: letter or _, then letters, digits and _
+	size_t scan_identifier(size_t pos) const
+	{
+		if (pos >= length_ || !(iswalpha(src_[pos]) || src_[pos] == L'_')) return 0;
+		size_t i = pos + 1;
+		while (i < length_ && (iswalpha(src_[i]) || iswdigit(src_[i]) || src_[i] == L'_')) i++;
+		return i - pos;
+	}
+
+	// binary_operator_tokenizer: the run of operator characters walked through
+	// the + - * ** / % == trie; the walked prefix is accepted when it covers
+	// the whole run or passed a complete operator, 0 otherwise
+	size_t scan_binary_operator(size_t pos) const
+	{
+		size_t run = pos;
+		while (run < length_ && in(src_[run], L'+', L'-', L'*', L'/', L'%', L'=')) run++;
+		run -= pos;
+		if (run == 0) return 0;
+
+		wchar_t c = src_[pos];
+		size_t walked = 1;
+		bool complete = (c != L'=');
+		if ((c == L'*' || c == L'=') && run > 1 && src_[pos + 1] == c)
+		{
+			walked = 2;
+			complete = true;
+		}
+		return (walked == run || complete) ? walked : 0;
+	}
+
+	token_result eat_binary_operator(size_t& start)
+	{
+		if (start == length_) return token_result::empty;
+		size_t n = scan_binary_operator(start);
+		if (n == 0) return token_result::reject;
+		push(token_type::binary_operator, start, n);
+		start += n;
+		return (start < length_) ? token_result::finish : token_result::accept;
+	}
+
+	token_result eat_grouping_parenthesis(size_t& start)
+	{
+		if (!at(start, L'(')) return token_result::empty;
+		push(token_type::expression_bound, start, 1);
+		size_t advance = start + 1;
+
+		size_t expr_start = advance;
+		tokenize_expression(advance);
+		if (expr_start == advance)
+			return token_result::reject;
+
+		if (!at(advance, L')'))
+			return token_result::reject;
+		push(token_type::expression_bound, advance, 1);
+		start = advance + 1;
+		return token_result::accept;
+	}
+
+	token_result eat_function_call(size_t& start)
+	{
+		size_t id_length = scan_identifier(start);
+		if (id_length == 0) return token_result::empty;
+		size_t advance = start + id_length;
+		advance += scan_spaces(advance);
+		if (!at(advance, L'('))
+			return token_result::empty;
+
+		push(token_type::identifier, start, id_length);
+		push(token_type::expression_bound, advance, 1);
+		advance++;
+		advance += scan_spaces(advance);
+
+		if (at(advance, L')'))
+		{
+			push(token_type::expression_bound, advance, 1);
+			start = advance + 1;
+			return token_result::accept;
+		}
+
+		size_t arg_start = advance;
+		tokenize_expression(advance);
+		if (arg_start == advance)
+			return token_result::reject;
+
+		while (true)
+		{
+			advance += scan_spaces(advance);
+			// comma_tokenizer takes the whole run of commas, only a single one validates
+			if (!at(advance, L',') || at(advance + 1, L','))
+				break;
+			push(token_type::comma, advance, 1);
+			advance++;
+			advance += scan_spaces(advance);
+			arg_start = advance;
+			tokenize_expression(advance);
+			if (arg_start == advance)
+				return token_result::reject;
+		}
+
+		if (!at(advance, L')'))
+			return token_result::reject;
+		push(token_type::expression_bound, advance, 1);
+		start = advance + 1;
+		return token_result::accept;
+	}
+
+	token_result eat_primary(size_t& start)
+	{
+		token_result result = eat_grouping_parenthesis(start);
+		if (result != token_result::empty)
+			return result;
+
+		size_t n = scan_number(start);
+		if (n)
+		{
+			push(token_type::number, start, n);
+			start += n;
+			return token_result::accept;
+		}
+
+		result = eat_function_call(start);
+		if (result != token_result::empty)
+			return result;
+
+		n = scan_identifier(start);
+		if (n)
+		{
+			push(token_type::identifier, start, n);
+			start += n;
+			return token_result::accept;
+		}
+		return token_result::empty;
+	}
+
+	token_result eat_unary_expression(size_t& start)
+	{
+		size_t advance = start;
+
+		bool found_unary = false;
+		if (at(advance, L'+') || at(advance, L'-'))
+		{
+			push(token_type::unary_operator, advance, 1);
+			advance++;
+			found_unary = true;
+		}
+		advance += scan_spaces(advance);
+
+		size_t primary_start = advance;
+		token_result result = eat_primary(advance);
+		if (result == token_result::reject)
+			return token_result::reject;
+		if (advance == primary_start)
+			return found_unary ? token_result::reject : token_result::empty;
+
+		start = advance;
+		return token_result::accept;
+	}
+
+	void tokenize_expression(size_t& start)
+	{
+		using std::wcerr;
+		using std::endl;
+
+		size_t advance = start;
+		advance += scan_spaces(advance);
+
+		token_result tk_result = eat_unary_expression(advance);
+		bool haveExpression = (tk_result != token_result::reject && tk_result != token_result::empty);
+		advance += scan_spaces(advance);
+
+		if (!haveExpression) { wcerr << L"{expected expression:" << (src_ + advance) << L"}" << endl; }
+		else
+			while (advance < length_)
+			{
+				size_t local_start = advance;
+
+				tk_result = eat_binary_operator(advance);
+				if (tk_result == token_result::reject) break;
+				if (advance == length_) break;
+				if (tk_result == token_result::empty) break;
+
+				size_t spaces = scan_spaces(advance);
+				advance += spaces;
+				if (advance == length_) break;
+
+				if (spaces == 0 && (src_[advance] == L'+' || src_[advance] == L'-'))
+				{
+					const flat_token& op = tokens_->back();
+					if (!(op.length == 2 && src_[op.offset] == L'*'))
+					{
+						wcerr << L"        ERROR: operators must be separated by space: '"
+							  << std::wstring(src_ + op.offset, op.length) << L"' and '" << src_[advance] << L"' at position " << advance << endl;
+						break;
+					}
+				}
+
+				tk_result = eat_unary_expression(advance);
+				if (tk_result == token_result::reject || tk_result == token_result::empty)
+				{
+					wcerr << L"        ERROR: expected expression: {" << (src_ + advance) << L"}" << endl;
+					break;
+				}
+
+				advance += scan_spaces(advance);
+				if (advance == length_) break;
+
+				if (local_start == advance) break;
+			}
+		start = advance;
+	}
+
+public:
+	// tokens of src[0, length) into `tokens`, which is cleared first
+	void tokenize(const wchar_t* src, size_t length, std::vector<flat_token>& tokens)
+	{
+		src_ = src;
+		length_ = length;
+		tokens_ = &tokens;
+		tokens.clear();
+
+		size_t advance = 0;
+		tokenize_expression(advance);
+
+		// a failed branch may have left tokens past the point where tokenizing stopped
+		while (!tokens.empty() && tokens.back().offset >= advance)
+			tokens.pop_back();
+		if (advance < length_)
+			push(token_type::unknown, advance, length_ - advance);
+		else
+			push(token_type::end, advance, 0);
+		tokens_ = nullptr;
+	}
+
+	void tokenize(const std::wstring& src, std::vector<flat_token>& tokens)
+	{
+		tokenize(src.c_str(), src.length(), tokens);
+	}
+};
+
 }
 #endif
\ No newline at end of file
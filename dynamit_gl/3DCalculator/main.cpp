@@ -193,6 +193,32 @@ int main()
 	x = 1; y = 1; z = 1;
 	std::wcout << program->eval() << std::endl;  // 3
 
+	// formula cache: the normalized key compiles as the formula does, valid or not
+	wcout << L"formula cache against direct compile, theta = 0.5:" << endl;
+	long double theta = 0.5;
+	for (std::wstring formula : {L"2 * -theta", L"5 - -3", L"1 + -cos(theta)", L"2* *3", L"Cos( 5 * Theta )", L"2e -3", L"2e-3 * theta"})
+	{
+		std::wstring direct, cached;
+		std::unique_ptr<expression> tree = compiler.compile(formula);
+		if (tree)
+		{
+			tree->bind(L"theta", &theta);
+			direct = std::to_wstring(tree->eval());
+		}
+		else direct = L"rejected";
+		try
+		{
+			formula_cache::entry_ptr entry = formula_cache::instance().get(formula);
+			basic_program_state<long double> state(*entry->program);
+			for (size_t slot = 0; slot < state.slot_count(); slot++)
+				if (entry->program->slot_name(slot) == L"theta") state.set(slot, theta);
+			cached = std::to_wstring(entry->program->eval(state));
+		}
+		catch (const std::runtime_error&) { cached = L"rejected"; }
+		std::wcout << L"   " << (direct == cached ? L"+ " : L"! ") << formula << L" -> [" << formula_cache::normalize(formula) << L"] direct: "
+		           << direct << L"; cached: " << cached << std::endl;
+	}
+
 	//expr.reset(compiler.compile(lang));
 	return 0;
 }
@@ -0,0 +1,78 @@
+#include "enabler.h"
+#ifdef __SYNTAX_BENCHMARK_CPP__
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "syntax_tree.h"
+
+using namespace std;
+using namespace expresie_tokenizer;
+
+static const int lookup_repeats = 200000;
+
+// Words looked up in every set: members, prefixes, overlong and foreign words
+static const wchar_t* lookup_words[] =
+{
+	L"+", L"-", L"*", L"**", L"/", L"%", L"==", L"=", L"***", L"+-", L"//",
+	L"sin", L"si", L"sinh", L"sinhx", L"cos", L"cosh", L"acos", L"atan", L"atan2", L"atan3",
+	L"sqrt", L"sqr", L"floor", L"flo", L"round", L"rounds", L"fmod", L"min", L"max", L"maximum",
+	L"\u03C0", L"\u221A", L"\u221Ax", L"theta", L"x",
+};
+
+static size_t checksum(const syntax_tree::search_result& r)
+{
+	return r.iterated * 8 + r.found * 4 + r.final * 2 + (r.partial_finish != 0);
+}
+
+template <typename F>
+static double time_ns_per_lookup(const vector<wstring>& words, F&& find, size_t& sum)
+{
+	sum = 0;
+	chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+	for (int i = 0; i < lookup_repeats; i++)
+		for (const wstring& w : words) sum += find(w);
+	chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+	return chrono::duration<double, nano>(t1 - t0).count() / (static_cast<double>(lookup_repeats) * words.size());
+}
+
+static void compare(const wchar_t* name, syntax_tree tree)
+{
+	syntax_automaton frozen = syntax_automaton::freeze(tree);
+	vector<wstring> words(begin(lookup_words), end(lookup_words));
+
+	size_t sum_tree = 0, sum_frozen = 0, sum_alpha_tree = 0, sum_alpha_frozen = 0;
+	double t_tree = time_ns_per_lookup(words, [&](const wstring& w) { return checksum(tree.find(w)); }, sum_tree);
+	double t_frozen = time_ns_per_lookup(words, [&](const wstring& w) { return checksum(frozen.find(w)); }, sum_frozen);
+	double t_alpha_tree = time_ns_per_lookup(words, [&](const wstring& w) { return static_cast<size_t>(tree.in_alphabet(w[0]) + tree.can_start(w[0])); }, sum_alpha_tree);
+	double t_alpha_frozen = time_ns_per_lookup(words, [&](const wstring& w) { return static_cast<size_t>(frozen.in_alphabet(w[0]) + frozen.can_start(w[0])); }, sum_alpha_frozen);
+
+	wcout << left << setw(12) << name << right << setw(8) << frozen.state_count() << setw(10) << frozen.memory_bytes()
+		<< fixed << setprecision(1)
+		<< setw(12) << t_tree << setw(12) << t_frozen << setw(8) << setprecision(2) << t_tree / t_frozen << L"x"
+		<< setprecision(1) << setw(14) << t_alpha_tree << setw(14) << t_alpha_frozen << endl;
+	if (sum_tree != sum_frozen || sum_alpha_tree != sum_alpha_frozen)
+		wcout << L"   !! lookup mismatch: " << sum_tree << L" / " << sum_frozen << endl;
+}
+
+int main()
+{
+	wcout << L"syntax_tree against syntax_automaton, " << lookup_repeats << L" x "
+		<< (sizeof(lookup_words) / sizeof(lookup_words[0])) << L" lookups, ns per lookup" << endl;
+	wcout << left << setw(12) << L"set" << right << setw(8) << L"states" << setw(10) << L"bytes"
+		<< setw(12) << L"tree find" << setw(12) << L"frozen find" << setw(9) << L"speedup"
+		<< setw(14) << L"tree alpha" << setw(14) << L"frozen alpha" << endl;
+
+	compare(L"operators", syntax_tree::merge <std::wstring>(L"+", L"-", L"*", L"**", L"/", L"%", L"=="));
+	compare(L"functions", syntax_tree::merge <std::wstring>(L"sin", L"cos", L"tan", L"sqrt", L"exp", L"log", L"abs",
+		L"asin", L"acos", L"atan", L"sinh", L"cosh", L"tanh", L"floor", L"ceil", L"round",
+		L"pow", L"atan2", L"fmod", L"min", L"max"));
+	// non ASCII names exercise the sparse fallback
+	compare(L"symbols", syntax_tree::merge <std::wstring>(L"\u03C0", L"\u221A", L"sin", L"cos", L"**", L"=="));
+	return 0;
+}
+
+#endif
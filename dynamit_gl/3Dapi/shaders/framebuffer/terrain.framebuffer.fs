@@ -5,6 +5,9 @@ in vec3 terrainNormal;
 in vec3 lightDirection;
 void main()
 {
-    float strength =  dot(-lightDirection, terrainNormal);
+    // a back face is the underside of a two sided terrain's one coat, lit by a unit
+    // normal as the second coat was (the top's normals are twice as long)
+    vec3 normal = gl_FrontFacing ? terrainNormal : -normalize(terrainNormal);
+    float strength =  dot(-lightDirection, normal);
     FragColor = vec4( terrainColor.rgb * strength, terrainColor.a);
 }
@@ -1,7 +1,10 @@
 #include "pch.h"
 #include "Dynamit.h"
+#include "builders.h"
+#include "meshopt.h"
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 
 namespace dynamit
 {
@@ -127,6 +130,7 @@ namespace dynamit
         case GL_UNSIGNED_INT:  return sizeof(GLuint);
         case GL_SHORT:         return sizeof(GLshort);
         case GL_UNSIGNED_SHORT:return sizeof(GLushort);
+        case GL_HALF_FLOAT:    return sizeof(GLhalf);
         case GL_BYTE:          return sizeof(GLbyte);
         case GL_UNSIGNED_BYTE: return sizeof(GLubyte);
         case GL_DOUBLE:        return sizeof(GLdouble);
@@ -149,6 +153,20 @@ namespace dynamit
         currentOffset += size * sizeOf(type);
     }
 
+    void StrideLayout::setDecode(const std::string& name, StrideDecode decode,
+        const std::array<float, 3>& scale, const std::array<float, 3>& offset)
+    {
+        for (auto& attr : attributes)
+            if (attr.name == name)
+            {
+                attr.decode = decode;
+                attr.decodeScale = scale;
+                attr.decodeOffset = offset;
+                return;
+            }
+        throw std::runtime_error("setDecode: no stride attribute " + name);
+    }
+
     void StrideLayout::setOffset(GLsizei offset)
     {
         currentOffset = offset;
@@ -216,6 +234,18 @@ namespace dynamit
         return oss.str();
     }
 
+    //========================================
+    // TwoSided Implementation
+    //========================================
+
+    std::string TwoSided::toGLSL() const
+    {
+        std::ostringstream oss;
+        oss << "const vec4 " << name << " = vec4("
+            << innerColor[0] << ", " << innerColor[1] << ", " << innerColor[2] << ", " << innerColor[3] << ");";
+        return oss.str();
+    }
+
     //========================================
     // Translation Implementation
     //========================================
@@ -245,6 +275,18 @@ namespace dynamit
         return oss.str();
     }
 
+    //========================================
+    // GeneratedVertex Implementation
+    //========================================
+
+    std::string GeneratedVertex::toGLSLUniforms() const
+    {
+        std::string uniforms;
+        for (const VertexVariable& variable : variables)
+            uniforms += "uniform float " + variable.name + ";\n";
+        return uniforms;
+    }
+
     //========================================
     // GlSet Implementation
     //========================================
@@ -259,6 +301,9 @@ namespace dynamit
     const std::optional<ConstTranslation>& GlSet::getConstTranslation() const { return constTranslation; }
     const std::optional<TransformMatrix3>& GlSet::getTransformMatrix3() const { return transformMatrix3; }
     const std::optional<TransformMatrix4>& GlSet::getTransformMatrix4() const { return transformMatrix4; }
+    const std::optional<GeneratedVertex>& GlSet::getGeneratedVertex() const { return generatedVertex; }
+    std::optional<GeneratedVertex>& GlSet::getGeneratedVertex() { return generatedVertex; }
+    const std::optional<TwoSided>& GlSet::getTwoSided() const { return twoSided; }
 
     void GlSet::setPrecision(const std::string& p) { precision = p; }
 
@@ -302,6 +347,18 @@ namespace dynamit
         constTranslation = trans;
     }
 
+    void GlSet::setGeneratedVertex(const GeneratedVertex& generated)
+    {
+        if (normalsBuffer)
+            throw std::runtime_error("Cannot generate vertices when normal buffer is used");
+        generatedVertex = generated;
+    }
+
+    void GlSet::setTwoSided(const TwoSided& sides)
+    {
+        twoSided = sides;
+    }
+
     //void GlSet::setTransformMatrix3(std::unique_ptr<GlArrayBuffer> buffer)
     //{
     //    transformMatrix3 = std::move(buffer);
@@ -409,7 +466,7 @@ namespace dynamit
     {
         glSet.requireColor();
 
-        bool hasNormals = glSet.getNormalsBuffer() != nullptr;
+        bool hasNormals = glSet.getNormalsBuffer() != nullptr || glSet.getGeneratedVertex();
         if (strideLayout)
             hasNormals = hasNormals || strideLayout->hasAttribute("normal");
 
@@ -438,12 +495,32 @@ namespace dynamit
         fsBuilder.addHead("precision " + glSet.getPrecision() + ";");
         fsBuilder.addHead("out vec4 fragColor;");
 
+        bool octahedral = false;
         for (const StrideAttribute& attr : strideLayout->getAttributes())
         {
             std::string vecType = "vec" + std::to_string(attr.size);
             vsBuilder.addHead("layout (location = " + std::to_string(attr.location) +
                 ") in " + vecType + " " + attr.name + ";");
 
+            if (attr.decode == StrideDecode::ScaleOffset)
+            {
+                std::ostringstream oss;
+                oss.precision(9);
+                oss << "const " << vecType << " " << attr.name << "Scale = " << vecType << "(";
+                for (int i = 0; i < attr.size; i++)
+                    oss << (i ? ", " : "") << (i < 3 ? attr.decodeScale[i] : 1.0f);
+                oss << ");\nconst " << vecType << " " << attr.name << "Offset = " << vecType << "(";
+                for (int i = 0; i < attr.size; i++)
+                    oss << (i ? ", " : "") << (i < 3 ? attr.decodeOffset[i] : 0.0f);
+                oss << ");";
+                vsBuilder.addHead(oss.str());
+            }
+            if (attr.decode == StrideDecode::Octahedral)
+            {
+                octahedral = true;
+                vecType = "vec3";
+            }
+
             // Add varyings for normals and colors
             if (attr.name == "normal" || attr.name == "color")
             {
@@ -452,9 +529,25 @@ namespace dynamit
             }
         }
 
+        if (octahedral)
+        {
+            // the lower half of the octahedron is folded over the upper one
+            vsBuilder.addHead(
+                "vec3 octahedralDecode(vec2 e)\n"
+                "{\n"
+                "    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+                "    float t = max(-n.z, 0.0);\n"
+                "    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);\n"
+                "    return normalize(n);\n"
+                "}");
+        }
+
         if (glSet.getConstColor())
             fsBuilder.addHead(glSet.getConstColor()->toGLSL());
 
+        if (glSet.getTwoSided() && glSet.getTwoSided()->hasInnerColor)
+            fsBuilder.addHead(glSet.getTwoSided()->toGLSL());
+
         if (glSet.getLightDirection())
         {
             const LightDirection& light = *glSet.getLightDirection();
@@ -477,6 +570,19 @@ namespace dynamit
             vsBuilder.addHead(glSet.getTransformMatrix4()->toGLSLUniform());
     }
 
+    std::string ShaderStrategy::strideValue(const StrideAttribute& attr) const
+    {
+        switch (attr.decode)
+        {
+        case StrideDecode::ScaleOffset:
+            return "(" + attr.name + " * " + attr.name + "Scale + " + attr.name + "Offset)";
+        case StrideDecode::Octahedral:
+            return "octahedralDecode(" + attr.name + ")";
+        default:
+            return attr.name;
+        }
+    }
+
     void ShaderStrategy::addDeclarations()
     {
         fsBuilder.addHead("precision " + glSet.getPrecision() + ";");
@@ -505,6 +611,9 @@ namespace dynamit
         if (glSet.getConstColor())
             fsBuilder.addHead(glSet.getConstColor()->toGLSL());
 
+        if (glSet.getTwoSided() && glSet.getTwoSided()->hasInnerColor)
+            fsBuilder.addHead(glSet.getTwoSided()->toGLSL());
+
         if (glSet.getLightDirection())
         {
             const LightDirection& light = *glSet.getLightDirection();
@@ -525,6 +634,17 @@ namespace dynamit
 
         if (glSet.getTransformMatrix4())
             vsBuilder.addHead(glSet.getTransformMatrix4()->toGLSLUniform());
+
+        if (glSet.getGeneratedVertex())
+            addGeneratedVertexDeclarations();
+    }
+
+    void ShaderStrategy::addGeneratedVertexDeclarations()
+    {
+        const GeneratedVertex& generated = *glSet.getGeneratedVertex();
+        vsBuilder.addHead("out vec3 normalVary;");
+        fsBuilder.addHead("in vec3 normalVary;");
+        vsBuilder.addHead(generated.toGLSLUniforms() + generated.source);
     }
 
     std::string ShaderStrategy::buildPositionExpression()
@@ -538,9 +658,14 @@ namespace dynamit
         if (strideLayout && strideLayout->hasAttribute("vertex"))
         {
             const StrideAttribute* attr = strideLayout->getAttribute("vertex");
-            vertexExpr = "vertex";
+            vertexExpr = strideValue(*attr);
             vertexDim = attr->size;
         }
+        else if (glSet.getGeneratedVertex())
+        {
+            vertexExpr = "position";
+            vertexDim = 3;
+        }
         else if (glSet.getVertexBuffer())
         {
             GlArrayBuffer* vb = glSet.getVertexBuffer();
@@ -598,6 +723,14 @@ namespace dynamit
     }
 
     std::string ShaderStrategy::buildColorExpression()
+    {
+        std::string color = buildFrontColorExpression();
+        if (glSet.getTwoSided() && glSet.getTwoSided()->hasInnerColor)
+            return "(gl_FrontFacing ? " + color + " : " + glSet.getTwoSided()->name + ")";
+        return color;
+    }
+
+    std::string ShaderStrategy::buildFrontColorExpression()
     {
         if (strideLayout && strideLayout->hasAttribute("color"))
         {
@@ -623,14 +756,15 @@ namespace dynamit
 
         if (strideLayout && strideLayout->hasAttribute("normal"))
             hasNormals = true;
-        else if (glSet.getNormalsBuffer())
+        else if (glSet.getNormalsBuffer() || glSet.getGeneratedVertex())
             hasNormals = true;
 
         if (!hasNormals || !glSet.getLightDirection())
             return "";
 
         const LightDirection& light = *glSet.getLightDirection();
-        std::string normalVar = "normalVary";
+        // a back face is lit from the other side
+        std::string normalVar = glSet.getTwoSided() ? "(gl_FrontFacing ? normalVary : -normalVary)" : "normalVary";
 
         if (light.normalize)
             return "-dot(normalize(" + light.name + "), normalize(" + normalVar + "))";
@@ -640,18 +774,26 @@ namespace dynamit
 
     void ShaderStrategy::composeVertexMain()
     {
+        if (glSet.getGeneratedVertex())
+        {
+            vsBuilder.addMain("vec3 position;");
+            vsBuilder.addMain("vec3 normal;");
+            vsBuilder.addMain("generateVertex(" + glSet.getVertexBuffer()->name() + ", position, normal);");
+        }
+
         vsBuilder.addMain("gl_Position = " + buildPositionExpression() + ";");
 
         if (strideLayout)
         {
-            if (strideLayout->hasAttribute("normal"))
+            if (const StrideAttribute* attr = strideLayout->getAttribute("normal"))
             {
+                std::string normal = strideValue(*attr);
                 if (glSet.getTransformMatrix4())
-                    vsBuilder.addMain("normalVary = mat3(" + glSet.getTransformMatrix4()->name + ") * normal;");
+                    vsBuilder.addMain("normalVary = mat3(" + glSet.getTransformMatrix4()->name + ") * " + normal + ";");
                 else if (glSet.getTransformMatrix3())
-                    vsBuilder.addMain("normalVary = " + glSet.getTransformMatrix3()->name + " * normal;");
+                    vsBuilder.addMain("normalVary = " + glSet.getTransformMatrix3()->name + " * " + normal + ";");
                 else
-                    vsBuilder.addMain("normalVary = normal;");
+                    vsBuilder.addMain("normalVary = " + normal + ";");
             }
             if (strideLayout->hasAttribute("color"))
                 vsBuilder.addMain("colorVary = color;");
@@ -668,6 +810,16 @@ namespace dynamit
                     vsBuilder.addMain(nb->defaultVaryAssign() + ";");
             }
 
+            if (glSet.getGeneratedVertex())
+            {
+                if (glSet.getTransformMatrix4())
+                    vsBuilder.addMain("normalVary = mat3(" + glSet.getTransformMatrix4()->name + ") * normal;");
+                else if (glSet.getTransformMatrix3())
+                    vsBuilder.addMain("normalVary = " + glSet.getTransformMatrix3()->name + " * normal;");
+                else
+                    vsBuilder.addMain("normalVary = normal;");
+            }
+
             if (GlArrayBuffer* cb = glSet.getColorsBuffer())
                 vsBuilder.addMain(cb->defaultVaryAssign() + ";");
         }
@@ -806,6 +958,7 @@ namespace dynamit
 
         glBindBuffer(GL_ARRAY_BUFFER, vd.strideBuffer);
         glBufferData(GL_ARRAY_BUFFER, sizeBytes, data, GL_STATIC_DRAW);
+        vd.strideBytes = sizeBytes;
 
         // Calculate vertex count
         vd.vertexCount = sizeBytes / strideBytes;
@@ -854,6 +1007,209 @@ namespace dynamit
         return *this;
     }
 
+    Dynamit& Dynamit::withStrideVertexDecode(const std::array<float, 3>& scale, const std::array<float, 3>& offset)
+    {
+        strideLayout.setDecode("vertex", StrideDecode::ScaleOffset, scale, offset);
+        return *this;
+    }
+
+    Dynamit& Dynamit::withStrideOctahedralNormals(GLenum type)
+    {
+        GLuint location = getLocationFor("normal");
+        strideLayout.addAttribute("normal", location, 2, type, GL_TRUE);
+        strideLayout.setDecode("normal", StrideDecode::Octahedral);
+        return *this;
+    }
+
+    Dynamit& Dynamit::withInterleaved(const builders::InterleavedGeometry& geometry)
+    {
+        const builders::InterleavedLayout& layout = geometry.layout;
+        auto bytes = [](int floats) { return static_cast<GLsizei>(floats * sizeof(float)); };
+        withStride(geometry.data, bytes(layout.stride));
+
+        // Child VAOs reuse the layout declared on the root
+        if (currentVaoIndex == 0)
+        {
+            withStrideOffset(bytes(layout.vertex)).withStrideVertices(3);
+            if (layout.normal >= 0)
+                withStrideOffset(bytes(layout.normal)).withStrideNormals(3);
+            if (layout.texCoord >= 0)
+                withStrideOffset(bytes(layout.texCoord)).withStrideTexCoords(2);
+            if (layout.color >= 0)
+                withStrideOffset(bytes(layout.color)).withStrideColors(4);
+            // finalize() takes the stride from the end of the last attribute
+            withStrideOffset(bytes(layout.stride));
+        }
+
+        return withIndices(geometry.indices);
+    }
+
+    Dynamit& Dynamit::withQuantized(const builders::QuantizedGeometry& geometry)
+    {
+        using builders::VertexFormat;
+        const builders::QuantizedLayout& layout = geometry.layout;
+        withStride(geometry.data.data(), geometry.data.size(), layout.stride);
+
+        // Child VAOs reuse the layout and decode declared on the root
+        if (currentVaoIndex == 0)
+        {
+            withStrideOffset(layout.vertexOffset);
+            if (layout.position == VertexFormat::Half)
+                withStrideVertices(3, GL_FALSE, GL_HALF_FLOAT);
+            else if (layout.position == VertexFormat::Snorm16)
+                withStrideVertices(3, GL_TRUE, GL_SHORT).withStrideVertexDecode(layout.scale(), layout.offset());
+            else
+                withStrideVertices(3);
+
+            if (layout.normal == VertexFormat::Octahedral16)
+                withStrideOffset(layout.normalOffset).withStrideOctahedralNormals(GL_SHORT);
+            else if (layout.normal != VertexFormat::None)
+                withStrideOffset(layout.normalOffset).withStrideNormals(3);
+
+            if (layout.texCoord == VertexFormat::Half)
+                withStrideOffset(layout.texCoordOffset).withStrideTexCoords(2, GL_FALSE, GL_HALF_FLOAT);
+            else if (layout.texCoord != VertexFormat::None)
+                withStrideOffset(layout.texCoordOffset).withStrideTexCoords(2);
+
+            if (layout.color == VertexFormat::Unorm8)
+                withStrideOffset(layout.colorOffset).withStrideColors(4, GL_TRUE, GL_UNSIGNED_BYTE);
+            else if (layout.color != VertexFormat::None)
+                withStrideOffset(layout.colorOffset).withStrideColors(4);
+            // finalize() takes the stride from the end of the last attribute
+            withStrideOffset(layout.stride);
+        }
+
+        return withIndices(geometry.indices);
+    }
+
+    Dynamit& Dynamit::updateStride(const void* data, size_t sizeBytes)
+    {
+        VAOData& vd = currentVao();
+        if (vd.strideBuffer == 0)
+            throw std::runtime_error("updateStride: no stride buffer, call withStride first");
+
+        glBindBuffer(GL_ARRAY_BUFFER, vd.strideBuffer);
+        if (sizeBytes == vd.strideBytes)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeBytes, data);
+        else
+            glBufferData(GL_ARRAY_BUFFER, sizeBytes, data, GL_STATIC_DRAW);
+        vd.strideBytes = sizeBytes;
+
+        if (strideLayout.getStride() > 0)
+            vd.vertexCount = sizeBytes / strideLayout.getStride();
+        return *this;
+    }
+
+    // A triangle list of any index type in vertex cache order, in the same type. With
+    // level of detail ranges each range is ordered on its own, a triangle never leaves its level
+    static std::vector<uint8_t> cacheOrdered(const void* data, size_t count, GLenum type,
+        const std::vector<Dynamit::LodLevel>& lods)
+    {
+        std::vector<uint32_t> indices(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            switch (type)
+            {
+            case GL_UNSIGNED_BYTE:  indices[i] = static_cast<const uint8_t*>(data)[i];  break;
+            case GL_UNSIGNED_SHORT: indices[i] = static_cast<const uint16_t*>(data)[i]; break;
+            default:                indices[i] = static_cast<const uint32_t*>(data)[i]; break;
+            }
+        }
+        size_t vertexCount = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end()) + size_t(1);
+        if (lods.empty())
+            meshopt::optimizeVertexCache(indices, vertexCount);
+        for (const Dynamit::LodLevel& lod : lods)
+        {
+            if (lod.firstIndex + lod.indexCount > count)
+                continue;
+            std::vector<uint32_t> range(indices.begin() + lod.firstIndex, indices.begin() + lod.firstIndex + lod.indexCount);
+            meshopt::optimizeVertexCache(range, vertexCount);
+            std::copy(range.begin(), range.end(), indices.begin() + lod.firstIndex);
+        }
+
+        std::vector<uint8_t> ordered(count * StrideLayout::sizeOf(type));
+        for (size_t i = 0; i < count; i++)
+        {
+            switch (type)
+            {
+            case GL_UNSIGNED_BYTE:  ordered[i] = static_cast<uint8_t>(indices[i]); break;
+            case GL_UNSIGNED_SHORT: reinterpret_cast<uint16_t*>(ordered.data())[i] = static_cast<uint16_t>(indices[i]); break;
+            default:                reinterpret_cast<uint32_t*>(ordered.data())[i] = indices[i]; break;
+            }
+        }
+        return ordered;
+    }
+
+    // data in vertex cache order when the VAO asks for it; without level of detail ranges
+    // yet the data as given is kept too, for withLods to order each range of it
+    static const void* cacheOrder(Dynamit::VAOData& vd, const void* data, size_t count, GLenum type, std::vector<uint8_t>& ordered)
+    {
+        vd.unorderedIndices.clear();
+        if (!vd.vertexCacheOrder || vd.primitiveType != GL_TRIANGLES || !data)
+            return data;
+        if (vd.lods.empty())
+            vd.unorderedIndices.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + count * StrideLayout::sizeOf(type));
+        ordered = cacheOrdered(data, count, type, vd.lods);
+        return ordered.data();
+    }
+
+    Dynamit& Dynamit::updateIndices(const void* data, size_t count, GLenum type)
+    {
+        VAOData& vd = currentVao();
+        if (vd.indexBuffer == 0 || type != vd.indexType || count != vd.indexCount)
+            return withIndices(data, count, type);
+
+        std::vector<uint8_t> ordered;
+        data = cacheOrder(vd, data, count, type, ordered);
+        glBindVertexArray(vd.vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vd.indexBuffer);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, count * StrideLayout::sizeOf(type), data);
+        return *this;
+    }
+
+    Dynamit& Dynamit::updateInterleaved(const builders::InterleavedGeometry& geometry, bool indices)
+    {
+        updateStride(geometry.data.data(), geometry.data.size() * sizeof(float));
+        if (indices)
+            updateIndices(geometry.indices.data(), geometry.indices.size(), GL_UNSIGNED_INT);
+        return *this;
+    }
+
+    Dynamit& Dynamit::updateQuantized(const builders::QuantizedGeometry& geometry, bool indices)
+    {
+        updateStride(geometry.data.data(), geometry.data.size());
+        if (indices)
+            updateIndices(geometry.indices.data(), geometry.indices.size(), GL_UNSIGNED_INT);
+        return *this;
+    }
+
+    Dynamit& Dynamit::withLods(const std::vector<builders::LodRange>& lods)
+    {
+        VAOData& vd = currentVao();
+        vd.lods.clear();
+        for (const builders::LodRange& range : lods)
+        {
+            if (range.firstIndex + range.indexCount > vd.indexCount)
+                throw std::runtime_error("withLods: range outside the index buffer, call withIndices first");
+            LodLevel level;
+            level.firstIndex = range.firstIndex;
+            level.indexCount = range.indexCount;
+            level.sectors = range.sectors;
+            vd.lods.push_back(level);
+        }
+
+        // the buffer was ordered as one triangle list, mixing the levels: order each range instead
+        if (!vd.unorderedIndices.empty() && !vd.lods.empty())
+        {
+            std::vector<uint8_t> ordered = cacheOrdered(vd.unorderedIndices.data(), vd.indexCount, vd.indexType, vd.lods);
+            glBindVertexArray(vd.vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vd.indexBuffer);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, ordered.size(), ordered.data());
+            std::vector<uint8_t>().swap(vd.unorderedIndices);
+        }
+        return *this;
+    }
+
     // Original separate buffer methods
 
     Dynamit& Dynamit::withVertices2d(const std::vector<float>& data)
@@ -903,6 +1259,29 @@ namespace dynamit
         return withVertices3d(std::vector<float>{0.0f, 0.0f, 0.0f});
     }
 
+    Dynamit& Dynamit::withGeneratedVertices(const std::vector<float>& grid, const std::string& source,
+        const std::vector<std::string>& variables)
+    {
+        VAOData& vd = currentVao();
+        glBindVertexArray(vd.vao);
+
+        GLuint location = getLocationFor("vertex");
+        auto buffer = std::make_unique<GlArrayBuffer>(location, "grid");
+        buffer->build();
+        buffer->withData(grid);
+        buffer->bufferData();
+        buffer->attrib(2, GL_FLOAT);
+        vd.glSet.setVertexBuffer(std::move(buffer));
+        vd.vertexCount = grid.size() / 2;
+
+        GeneratedVertex generated;
+        generated.source = source;
+        for (const std::string& name : variables)
+            generated.variables.push_back({ name });
+        vd.glSet.setGeneratedVertex(generated);
+        return *this;
+    }
+
     Dynamit& Dynamit::withNormals3d(const std::vector<float>& data)
     {
         VAOData& vd = currentVao();
@@ -977,6 +1356,18 @@ namespace dynamit
         return *this;
     }
 
+    Dynamit& Dynamit::withTwoSided(const std::string& name)
+    {
+        currentVao().glSet.setTwoSided({ name, { 1.0f, 1.0f, 1.0f, 1.0f }, false });
+        return *this;
+    }
+
+    Dynamit& Dynamit::withTwoSided(const std::array<float, 4>& innerColor, const std::string& name)
+    {
+        currentVao().glSet.setTwoSided({ name, innerColor, true });
+        return *this;
+    }
+
     Dynamit& Dynamit::withConstTranslation(const std::array<float, 4>& trans, const std::string& name)
     {
         currentVao().glSet.setConstTranslation({ name, trans });
@@ -1171,9 +1562,30 @@ namespace dynamit
         return *this;
     }
 
+    // Culling is off while a two sided shape draws: its back faces are the inner coat
+    class BackFacesDrawn
+    {
+    public:
+        explicit BackFacesDrawn(const GlSet& glSet)
+            : culling(glSet.getTwoSided() && glIsEnabled(GL_CULL_FACE))
+        {
+            if (culling)
+                glDisable(GL_CULL_FACE);
+        }
+        ~BackFacesDrawn()
+        {
+            if (culling)
+                glEnable(GL_CULL_FACE);
+        }
+
+    private:
+        bool culling;
+    };
+
     void Dynamit::drawTriangles(GLint start)
     {
         useProgram();
+        BackFacesDrawn sides(vaoList[0].glSet);
 
         for (const auto& vd : vaoList)
         {
@@ -1188,6 +1600,7 @@ namespace dynamit
     void Dynamit::drawTriangleFan(GLint start)
     {
         useProgram();
+        BackFacesDrawn sides(vaoList[0].glSet);
 
         for (const auto& vd : vaoList)
         {
@@ -1202,6 +1615,7 @@ namespace dynamit
     void Dynamit::drawArrays(GLenum mode, GLint start, GLsizei count)
     {
         bind();
+        BackFacesDrawn sides(vaoList[0].glSet);
         glDrawArrays(mode, start, count);
     }
 
@@ -1245,6 +1659,34 @@ namespace dynamit
         light.data = { x, y, z };
     }
 
+    void Dynamit::variable1f(const std::string& name, float value)
+    {
+        if (!vaoList[0].glSet.getGeneratedVertex())
+            throw std::runtime_error("Generated vertices not initialized. Call withGeneratedVertices() first.");
+
+        useProgram();
+
+        GeneratedVertex& generated = *vaoList[0].glSet.getGeneratedVertex();
+
+        for (VertexVariable& variable : generated.variables)
+        {
+            if (variable.name != name)
+                continue;
+
+            if (variable.location == -1)
+            {
+                variable.location = glGetUniformLocation(program.id, variable.name.c_str());
+                if (variable.location == -1)
+                    throw std::runtime_error("Vertex variable uniform not found in shader");
+            }
+
+            glUniform1f(variable.location, value);
+            variable.value = value;
+            return;
+        }
+        throw std::runtime_error("Unknown vertex variable: " + name);
+    }
+
     void Dynamit::updateVertices(const std::vector<float>& newData)
     {
         VAOData& vd = currentVao();
@@ -1263,6 +1705,12 @@ namespace dynamit
 
     // Index buffer methods
 
+    Dynamit& Dynamit::withVertexCacheOrder(bool enabled)
+    {
+        currentVao().vertexCacheOrder = enabled;
+        return *this;
+    }
+
     Dynamit& Dynamit::withIndices(const std::vector<uint32_t>& indices)
     {
         return withIndices(indices.data(), indices.size(), GL_UNSIGNED_INT);
@@ -1281,6 +1729,8 @@ namespace dynamit
     Dynamit& Dynamit::withIndices(const void* data, size_t count, GLenum type)
     {
         VAOData& vd = currentVao();
+        std::vector<uint8_t> ordered;
+        data = cacheOrder(vd, data, count, type, ordered);
         glBindVertexArray(vd.vao);
 
         // Create or reuse index buffer
@@ -1308,25 +1758,96 @@ namespace dynamit
     }
 
     // Drawing methods
+
+    // Strips, fans and line strips restart at the largest index of their type
+    // (builders::RestartIndex for GL_UNSIGNED_INT); lists have nothing to restart.
+    // GL_PRIMITIVE_RESTART with an explicit index is core since 3.1, the fixed
+    // index variant only since 4.3
+    static bool restartsPrimitive(GLenum mode)
+    {
+        return mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN || mode == GL_LINE_STRIP || mode == GL_LINE_LOOP;
+    }
+
+    static void drawElementsRestarting(GLenum mode, GLsizei count, GLenum type, const void* offset)
+    {
+        if (!restartsPrimitive(mode))
+        {
+            glDrawElements(mode, count, type, offset);
+            return;
+        }
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(type == GL_UNSIGNED_BYTE ? 0xFFu : type == GL_UNSIGNED_SHORT ? 0xFFFFu : 0xFFFFFFFFu);
+        glDrawElements(mode, count, type, offset);
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+
     void Dynamit::drawTrianglesIndexed()
     {
         useProgram();
+        BackFacesDrawn sides(vaoList[0].glSet);
 
         for (const auto& vd : vaoList)
         {
             if (vd.vao != 0 && vd.indexCount > 0)
             {
                 glBindVertexArray(vd.vao);
-                glDrawElements(vd.primitiveType, static_cast<GLsizei>(vd.indexCount),
+                drawElementsRestarting(vd.primitiveType, static_cast<GLsizei>(vd.indexCount),
                     vd.indexType, nullptr);
             }
         }
     }
 
+    int Dynamit::drawTrianglesLod(float screenPixels, float pixelsPerSector)
+    {
+        // A sector spans about pi * screenPixels / sectors pixels of the outline
+        const float sectorsNeeded = 3.14159265f * screenPixels / pixelsPerSector;
+        int drawn = -1;
+
+        useProgram();
+        BackFacesDrawn sides(vaoList[0].glSet);
+
+        for (const auto& vd : vaoList)
+        {
+            if (vd.vao == 0 || vd.indexCount == 0)
+                continue;
+            glBindVertexArray(vd.vao);
+            if (vd.lods.empty())
+            {
+                drawElementsRestarting(vd.primitiveType, static_cast<GLsizei>(vd.indexCount), vd.indexType, nullptr);
+                continue;
+            }
+
+            int level = 0;
+            for (int i = static_cast<int>(vd.lods.size()) - 1; i > 0; i--)
+            {
+                if (vd.lods[i].sectors >= sectorsNeeded)
+                {
+                    level = i;
+                    break;
+                }
+            }
+            if (drawn < 0)
+                drawn = level;
+
+            const LodLevel& lod = vd.lods[level];
+            drawElementsRestarting(vd.primitiveType, static_cast<GLsizei>(lod.indexCount), vd.indexType,
+                reinterpret_cast<const void*>(lod.firstIndex * StrideLayout::sizeOf(vd.indexType)));
+        }
+        return drawn;
+    }
+
+    float Dynamit::projectedPixels(float radius, float distance, float fovY, int viewportHeight)
+    {
+        if (distance <= radius)
+            return static_cast<float>(viewportHeight);
+        return radius / (distance * std::tan(fovY * 0.5f)) * viewportHeight;
+    }
+
     void Dynamit::drawElements(GLenum mode, GLsizei count, GLenum type, const void* offset)
     {
         bind();
-        glDrawElements(mode, count, type, offset);
+        BackFacesDrawn sides(vaoList[0].glSet);
+        drawElementsRestarting(mode, count, type, offset);
     }
 
     std::unique_ptr<NormalsHighlighter> Dynamit::createNormalsHighlighter(float length)
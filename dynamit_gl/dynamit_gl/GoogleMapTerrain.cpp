@@ -106,7 +106,7 @@ int GoogleMapTerrain::fillHeightMapBuffer(float size, float h)
 	}
 
 	////double coating it
-	if (!doubleCoated) return 0;
+	if (!doubleCoated || twoSided) return 0;
 	vertexes.resize(vertexes.size() * 2);
 	for (size_t i = 0; i < width; i++)
 	{
@@ -212,5 +212,8 @@ void GoogleMapTerrain::draw()
 {
 	glUseProgram(*this);    //set shader program to drao
 	glBindVertexArray(vao); //set object to draw
+	GLboolean culling = twoSided && doubleCoated && glIsEnabled(GL_CULL_FACE);
+	if (culling) glDisable(GL_CULL_FACE);
 	glDrawArrays(GL_TRIANGLES, 0, vertexes.size() / 3); //draw
+	if (culling) glEnable(GL_CULL_FACE);
 }
@@ -3,6 +3,7 @@
 #include "GoogleMapTerrainIndexed.h"
 #include "BitmapReader.h"  // Bitmaps
 #include "geometry.h"
+#include "meshopt.h"
 #include <glm/glm.hpp> //basic glm math functions
 #include <glm/gtc/matrix_transform.hpp> //matrix functions
 #include <glm/gtc/type_ptr.hpp> //convert glm types to opengl types
@@ -97,7 +98,7 @@ int GoogleMapTerrainIndexed::fillHeightMapBuffer(float size, float h)
 	}
 
 	//////double coating it
-	if (!doubleCoated) return 0;
+	if (!doubleCoated || twoSided) return 0;
 	vertexes.resize(vertexes.size() * 2);
 	indexes.resize(indexes.size() * 2);
 
@@ -145,6 +146,11 @@ void GoogleMapTerrainIndexed::build()
 	fillHeightMapBuffer(1, 1);
 	vertexes.shrink_to_fit(); //will not have effect if double coated
 	indexes.shrink_to_fit();  //will not have effect if double coated
+	//rows of triangles miss the vertex cache about once a triangle, reorder them and then the vertices
+	uint32_t* indices = reinterpret_cast<uint32_t*>(indexes.data());
+	size_t vertexCount = vertexes.size() / stridesize;
+	dynamit::meshopt::optimizeVertexCache(indices, indexes.size(), vertexCount);
+	dynamit::meshopt::optimizeVertexFetch(indices, indexes.size(), 0, vertexCount, { { &vertexes, stridesize } });
 	float* pv = vertexes.data();
 	int *pi = indexes.data();
 
@@ -204,5 +210,8 @@ void GoogleMapTerrainIndexed::draw()
 {
 	glUseProgram(*this);
 	glBindVertexArray(vao);
+	GLboolean culling = twoSided && doubleCoated && glIsEnabled(GL_CULL_FACE);
+	if (culling) glDisable(GL_CULL_FACE);
 	glDrawElements(GL_TRIANGLES, indexes.size(), GL_UNSIGNED_INT, 0);
+	if (culling) glEnable(GL_CULL_FACE);
 }
\ No newline at end of file
@@ -25,6 +25,9 @@ class GoogleMapTerrainIndexed : public Shape
 public:
 	static const wchar_t* defTerrainImgPath;
 	bool doubleCoated = true;
+	// doubleCoated from one coat: its back faces are drawn as the other side, the
+	// fragment shader flips their normals (gl_FrontFacing). Takes effect on build()
+	bool twoSided = false;
 
 	unsigned int vao;
 	//unsigned int ebo;
@@ -52,16 +52,18 @@ NormalsHighlighter& NormalsHighlighter::withColorEnd(const std::array<float, 3>&
 }
 
 void NormalsHighlighter::generateLinesFromVertsNorms(
-    const std::vector<float>& verts,
-    const std::vector<float>& norms,
+    const float* verts,
+    const float* norms,
+    size_t count,
+    size_t stride,
     float length)
 {
     normalLines.clear();
     endpointMap.clear();
-    normalLines.reserve(verts.size() * 2);
-    endpointMap.reserve((verts.size() / 3) * 2);
+    normalLines.reserve(count * 6);
+    endpointMap.reserve(count * 2);
 
-    for (size_t vi = 0; vi < verts.size(); vi += 3)
+    for (size_t vi = 0; vi < count * stride; vi += stride)
     {
         float vx = verts[vi];
         float vy = verts[vi + 1];
@@ -87,16 +89,26 @@ void NormalsHighlighter::generateLinesFromVertsNorms(
 
 void NormalsHighlighter::build(const std::vector<float>& verts, const std::vector<float>& norms)
 {
-    generateLinesFromVertsNorms(verts, norms, normalLength);
+    generateLinesFromVertsNorms(verts.data(), norms.data(), verts.size() / 3, 3, normalLength);
+    upload();
+}
 
+void NormalsHighlighter::build(const float* data, size_t count, size_t stride, size_t vertexOffset, size_t normalOffset)
+{
+    generateLinesFromVertsNorms(data + vertexOffset, data + normalOffset, count, stride, normalLength);
+    upload();
+}
+
+void NormalsHighlighter::upload()
+{
     transformLoc = glGetUniformLocation(*this, "uTransform");
     colorStartLoc = glGetUniformLocation(*this, "uColorStart");
     colorEndLoc = glGetUniformLocation(*this, "uColorEnd");
 
-    // Create VAO/VBOs
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &endpointVbo);
+    // Create VAO/VBOs, a rebuild refills the ones it has
+    if (!vao) glGenVertexArrays(1, &vao);
+    if (!vbo) glGenBuffers(1, &vbo);
+    if (!endpointVbo) glGenBuffers(1, &endpointVbo);
 
     glBindVertexArray(vao);
 
@@ -104,7 +104,7 @@ int Terrain::fillHeightMapBuffer(float size, float h)
 	}
 
 	////double coating it
-	if (!doubleCoated) return 0;
+	if (!doubleCoated || twoSided) return 0;
 	vertexes.resize(vertexes.size() * 2);
 	for (int i = 0; i < width; i++)
 	{
@@ -211,5 +211,8 @@ void Terrain::draw()
 {
 	glUseProgram(*this);
 	glBindVertexArray(vao);
+	GLboolean culling = twoSided && doubleCoated && glIsEnabled(GL_CULL_FACE);
+	if (culling) glDisable(GL_CULL_FACE);
 	glDrawArrays(GL_TRIANGLES, 0, vertexes.size() / 3);
+	if (culling) glEnable(GL_CULL_FACE);
 }
@@ -26,6 +26,9 @@ class Terrain: public Shape
 public:
 	static const wchar_t* defTerrainImgPath;
 	bool doubleCoated = true;
+	// doubleCoated from one coat: its back faces are drawn as the other side, the
+	// fragment shader flips their normals (gl_FrontFacing). Takes effect on build()
+	bool twoSided = false;
 	unsigned int vao;
 
 	Terrain(const wchar_t* heigthsMapPath);
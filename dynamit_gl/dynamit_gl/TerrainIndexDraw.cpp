@@ -96,7 +96,7 @@ int TerrainIndexDraw::fillHeightMapBuffer(float size, float h)
 	}
 
 	//////double coating it
-	if (!doubleCoated) return 0;
+	if (!doubleCoated || twoSided) return 0;
 	vertexes.resize(vertexes.size() * 2);
 	indexes.resize(indexes.size() * 2);
 
@@ -196,5 +196,8 @@ void TerrainIndexDraw::draw()
 {
 	glUseProgram(*this);
 	glBindVertexArray(vao);
+	GLboolean culling = twoSided && doubleCoated && glIsEnabled(GL_CULL_FACE);
+	if (culling) glDisable(GL_CULL_FACE);
 	glDrawElementsBaseVertex(GL_TRIANGLES, indexes.size(), GL_UNSIGNED_INT, indexes.data(), 0);
+	if (culling) glEnable(GL_CULL_FACE);
 }
\ No newline at end of file
@@ -95,7 +95,7 @@ int TerrainIndexed::fillHeightMapBuffer(float size, float h)
 	}
 
 	//////double coating it
-	if (!doubleCoated) return 0;
+	if (!doubleCoated || twoSided) return 0;
 	vertexes.resize(vertexes.size() * 2);
 	indexes.resize(indexes.size() * 2);
 
@@ -202,5 +202,8 @@ void TerrainIndexed::draw()
 {
 	glUseProgram(*this);
 	glBindVertexArray(vao);
+	GLboolean culling = twoSided && doubleCoated && glIsEnabled(GL_CULL_FACE);
+	if (culling) glDisable(GL_CULL_FACE);
 	glDrawElements(GL_TRIANGLES, indexes.size(), GL_UNSIGNED_INT, 0);
+	if (culling) glEnable(GL_CULL_FACE);
 }
\ No newline at end of file
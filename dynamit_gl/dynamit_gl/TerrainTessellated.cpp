@@ -97,7 +97,7 @@ int TerrainTessellated::fillHeightMapBuffer(float size, float h)
 	}
 
 	//////double coating it
-	if (!doubleCoated) return 0;
+	if (!doubleCoated || twoSided) return 0;
 	vertexes.resize(vertexes.size() * 2);
 	indexes.resize(indexes.size() * 2);
 
@@ -206,5 +206,8 @@ void TerrainTessellated::draw()
 	glPatchParameteri(GL_PATCH_VERTICES, 3); //comment for tri patch
 
 	glBindVertexArray(vao);
+	GLboolean culling = twoSided && doubleCoated && glIsEnabled(GL_CULL_FACE);
+	if (culling) glDisable(GL_CULL_FACE);
 	glDrawElements(GL_PATCHES, indexes.size(), GL_UNSIGNED_INT, 0);
+	if (culling) glEnable(GL_CULL_FACE);
 }
\ No newline at end of file
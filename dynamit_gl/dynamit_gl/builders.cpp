@@ -5,12 +5,31 @@
 #include "expression_compiler.h"
 #include "geometry.h"
 #include <cmath>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <iostream> // For debug output
 
 
 namespace dynamit::builders
 {
 
+// Formulas are evaluated in double: every sample is narrowed to a float vertex,
+// the long double default of the expression engine only costs time here
+// Compiled programs come from the process-wide cache and are shared read-only,
+// every coat and rebuild of the same formula evaluates it through its own state
+using formula_program = expresie_tokenizer::basic_expression_program<double>;
+using formula_state = expresie_tokenizer::basic_program_state<double>;
+using formula_cache = expresie_tokenizer::basic_formula_cache<double>;
+
 PolarBuilder::PolarBuilder()
     : m_formula(L"1")
     , m_domainStart(0.0f)
@@ -21,21 +40,257 @@ PolarBuilder::PolarBuilder()
     , m_smooth(true)
     , m_doubleCoated(false)
     , m_reversed(false)
+    , m_threads(1)
+    , m_tolerance(0.0f)
+    , m_optimized(false)
+    , m_strips(false)
+    , m_twoSided(false)
 {
 }
 
 PolarBuilder& PolarBuilder::formula(const std::wstring& formula)
 {
     m_formula = formula;
+    m_compiledFormula = nullptr;
     return *this;
 }
 
 PolarBuilder& PolarBuilder::formula(const std::string& formula)
 {
     m_formula = std::wstring(formula.begin(), formula.end());
+    m_compiledFormula = nullptr;
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::compiledFormula(CompiledFormula compiled)
+{
+    m_compiledFormula = std::move(compiled);
+    return *this;
+}
+
+FormulaCacheStats PolarBuilder::formulaCacheStats()
+{
+    formula_cache& cache = formula_cache::instance();
+    FormulaCacheStats stats;
+    stats.hits = cache.hits();
+    stats.misses = cache.misses();
+    stats.entries = cache.size();
+    return stats;
+}
+
+// The domain is cut into pieces before interval evaluation: r, cos and sin all
+// depend on theta, over one wide range each overestimates against the others
+static const int boundsPieces = 64;
+
+// Float end of a double bound, pushed out past the few float roundings the
+// builders apply on the way (theta steps, r * cos / slices * slices)
+static float floatBound(double v, bool up)
+{
+    float f = static_cast<float>(v);
+    float towards = up ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < 4; i++) f = std::nextafter(f, towards);
+    return f;
+}
+
+AABB PolarBuilder::cylinderBounds() const
+{
+    using interval = expresie_tokenizer::basic_interval<double>;
+    namespace intervals = expresie_tokenizer::intervals;
+
+    // Interval evaluation walks the expression tree, the cached programs are bytecode only
+    if (m_compiledFormula)
+        throw std::runtime_error("Bounds need a formula string, a compiled formula has no expression tree");
+    expresie_tokenizer::basic_expression_token_compiler<double> compiler;
+    std::unique_ptr<expresie_tokenizer::basic_expression<double>> expr_r = compiler.compile(m_formula);
+    if (!expr_r)
+        throw std::runtime_error("Empty formula");
+
+    // Same float arithmetic as sampleRing, so every sampled theta is inside
+    float domainRange = m_domainEnd - m_domainStart;
+    double start = floatBound(std::min(m_domainStart, m_domainStart + domainRange), false);
+    double end = floatBound(std::max(m_domainStart, m_domainStart + domainRange), true);
+
+    interval x, y;
+    for (int i = 0; i < boundsPieces; i++)
+    {
+        interval theta(start + (end - start) * i / boundsPieces, start + (end - start) * (i + 1) / boundsPieces);
+        theta = intervals::outward(theta);
+        interval r = expr_r->eval_interval(L"theta", theta);
+        interval px = intervals::mul(r, intervals::cos(theta));
+        interval py = intervals::mul(r, intervals::sin(theta));
+        x = i ? intervals::hull(x, px) : px;
+        y = i ? intervals::hull(y, py) : py;
+    }
+
+    AABB box;
+    box.min = { floatBound(x.lo, false), floatBound(y.lo, false), -1.0f };
+    box.max = { floatBound(x.hi, true), floatBound(y.hi, true), 0.0f };
+    return box;
+}
+
+AABB PolarBuilder::bounds() const
+{
+    AABB box = cylinderBounds();
+    for (int k = 0; k < 2; k++)
+    {
+        box.min[k] = std::min(box.min[k], 0.0f);
+        box.max[k] = std::max(box.max[k], 0.0f);
+    }
+    return box;
+}
+
+// Triangle strips: the quads between ring p and ring c of count vertices are the
+// strip p0 c0 p1 c1 ..., which makes (p0, c0, p1), (p1, c0, c1) as the lists wind
+// them. Repeating p0 first shifts the strip by one and makes the other winding,
+// (p0, p1, c0), (p1, c1, c0). A fan is the band whose ring p is the tip repeated,
+// its every other triangle degenerate. RestartIndex ends the band.
+static size_t stripBandIndices(size_t count, bool repeatFirst)
+{
+    return 2 * count + (repeatFirst ? 1 : 0) + 1;
+}
+
+template<typename Add, typename Prev, typename Curr>
+static void addStripBand(Add&& add, size_t count, bool repeatFirst, Prev prev, Curr curr)
+{
+    if (repeatFirst)
+        add(prev(0));
+    for (size_t i = 0; i < count; i++)
+    {
+        add(prev(i));
+        add(curr(i));
+    }
+    add(RestartIndex);
+}
+
+PolarBuilder& PolarBuilder::buildConeGrid(std::vector<float>& grid, std::vector<uint32_t>& indices)
+{
+    // ring 0 is the tip, rings 1..slices scale the formula ring by ring / slices
+    uint32_t tip = static_cast<uint32_t>(grid.size() / 2);
+    grid.insert(grid.end(), { 0.0f, 0.0f });
+    for (int h = 1; h <= m_slices; h++)
+        for (int i = 0; i <= m_sectors; i++)
+            grid.insert(grid.end(), { static_cast<float>(i), static_cast<float>(h) });
+
+    uint32_t row = static_cast<uint32_t>(m_sectors + 1);
+    if (m_strips)
+    {
+        auto add = [&](uint32_t index) { indices.push_back(index); };
+        addStripBand(add, row, false, [&](size_t) { return tip; }, [&](size_t i) { return tip + 1 + static_cast<uint32_t>(i); });
+        for (int h = 1; h < m_slices; h++)
+        {
+            uint32_t prev = tip + 1 + (h - 1) * row;
+            uint32_t curr = prev + row;
+            addStripBand(add, row, false, [&](size_t i) { return prev + static_cast<uint32_t>(i); },
+                [&](size_t i) { return curr + static_cast<uint32_t>(i); });
+        }
+        return *this;
+    }
+
+    for (int i = 0; i < m_sectors; i++)
+        indices.insert(indices.end(), { tip, tip + 1 + i, tip + 2 + i });
+    for (int h = 1; h < m_slices; h++)
+    {
+        uint32_t prev = tip + 1 + (h - 1) * row;
+        uint32_t curr = prev + row;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_sectors); i++)
+            indices.insert(indices.end(), { prev + i, curr + i, prev + i + 1, prev + i + 1, curr + i, curr + i + 1 });
+    }
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::buildCylinderGrid(std::vector<float>& grid, std::vector<uint32_t>& indices)
+{
+    uint32_t start = static_cast<uint32_t>(grid.size() / 2);
+    for (int h = 0; h <= m_slices; h++)
+        for (int i = 0; i <= m_sectors; i++)
+            grid.insert(grid.end(), { static_cast<float>(i), static_cast<float>(h) });
+
+    uint32_t row = static_cast<uint32_t>(m_sectors + 1);
+    for (int h = 1; h <= m_slices; h++)
+    {
+        uint32_t prev = start + (h - 1) * row;
+        uint32_t curr = prev + row;
+        if (m_strips)
+        {
+            addStripBand([&](uint32_t index) { indices.push_back(index); }, row, true,
+                [&](size_t i) { return prev + static_cast<uint32_t>(i); }, [&](size_t i) { return curr + static_cast<uint32_t>(i); });
+            continue;
+        }
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_sectors); i++)
+            indices.insert(indices.end(), { prev + i, prev + i + 1, curr + i, prev + i + 1, curr + i + 1, curr + i });
+    }
     return *this;
 }
 
+PolarShaderSource PolarBuilder::coneShader() const
+{
+    return shaderSource(true);
+}
+
+PolarShaderSource PolarBuilder::cylinderShader() const
+{
+    return shaderSource(false);
+}
+
+// GLSL twin of the indexed builders: theta steps, normal formula and the
+// reversed / tip conventions are the same, evaluation is float instead of double
+PolarShaderSource PolarBuilder::shaderSource(bool cone) const
+{
+    namespace glsl = expresie_tokenizer::glsl;
+
+    if (m_compiledFormula)
+        throw std::runtime_error("Shader source needs a formula string, a compiled formula has no expression tree");
+    expresie_tokenizer::basic_expression_token_compiler<double> compiler;
+    std::unique_ptr<expresie_tokenizer::basic_expression<double>> expr_r = compiler.compile(m_formula);
+    if (!expr_r)
+        throw std::runtime_error("Empty formula");
+    std::unique_ptr<expresie_tokenizer::basic_expression<double>> expr_dr = expresie_tokenizer::simplify(expr_r->derivative(L"theta"));
+    expr_r = expresie_tokenizer::simplify(std::move(expr_r));
+
+    glsl::writer out;
+    std::string functions = expresie_tokenizer::glsl_function(*expr_r, "polarR", L"theta", out);
+    functions += expresie_tokenizer::glsl_function(*expr_dr, "polarDr", L"theta", out);
+
+    std::ostringstream oss;
+    oss << out.helpers() << functions
+        << "void generateVertex(vec2 grid, out vec3 position, out vec3 normal)\n"
+        << "{\n"
+        << "    float theta = " << out.number(m_domainStart) << " + " << out.number(m_domainEnd - m_domainStart)
+        << " * grid.x / " << out.number(m_sectors) << ";\n"
+        << "    float r = polarR(theta);\n"
+        << "    float dr = polarDr(theta);\n"
+        << "    float c = cos(theta);\n"
+        << "    float s = sin(theta);\n"
+        << "    float scale = grid.y / " << out.number(m_slices) << ";\n";
+    if (cone)
+    {
+        float z_tip = m_reversed ? 0.0f : -1.0f;
+        float z_base = m_reversed ? -1.0f : 0.0f;
+        oss << "    position = vec3(r * c * scale, r * s * scale, " << out.number(z_tip) << " + "
+            << out.number(z_base - z_tip) << " * scale);\n"
+            << "    vec3 n = vec3(dr * s + r * c, -(dr * c - r * s), -1.0);\n";
+        if (m_reversed)
+            oss << "    n.xy = -n.xy;\n";
+        oss << "    float len = length(n);\n"
+            << "    normal = (grid.y == 0.0) ? vec3(0.0) : ((len > 0.0001) ? n / len : n);\n";
+    }
+    else
+    {
+        oss << "    position = vec3(r * c, r * s, -scale);\n"
+            << "    vec2 n = vec2(dr * s + r * c, -(dr * c - r * s));\n"
+            << "    float len = length(n);\n"
+            << "    normal = vec3((len > 0.0001) ? n / len : n, 0.0);\n";
+    }
+    oss << "}\n";
+
+    PolarShaderSource source;
+    source.glsl = oss.str();
+    for (const std::string& name : out.variables())
+        if (name != "theta")
+            source.variables.push_back(name);
+    return source;
+}
+
 PolarBuilder& PolarBuilder::domain(float start, float end)
 {
     m_domainStart = start;
@@ -116,6 +371,43 @@ PolarBuilder& PolarBuilder::nonreversed(bool enabled)
     return  reversed(!enabled);
 }
 
+PolarBuilder& PolarBuilder::threads(int count)
+{
+    m_threads = count;
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::adaptive(float tolerance)
+{
+    m_tolerance = tolerance;
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::optimized(bool enabled)
+{
+    m_optimized = enabled;
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::strips(bool enabled)
+{
+    m_strips = enabled;
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::twoSided(bool enabled)
+{
+    m_twoSided = enabled;
+    return *this;
+}
+
+int PolarBuilder::threadCount() const
+{
+    if (m_threads > 0)
+        return m_threads;
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
 // Helper to compute cross product normal from 3 points using geometry.h utilities
 static void crossProductNormalLefthanded(
     float x0, float y0, float z0,
@@ -150,6 +442,481 @@ static void crossProductNormalLefthanded(
     }
 }
 
+// ============================================================================
+// PARALLEL SLICES
+// ============================================================================
+
+// Process-wide workers for threads(n) builds, started on first use and grown
+// to the largest count asked for. The calling thread always takes part.
+class BuildPool
+{
+public:
+    static BuildPool& instance()
+    {
+        static BuildPool pool;
+        return pool;
+    }
+
+    // fn(k) for every k in [0, count), returns once all are done;
+    // the first exception thrown by any fn is rethrown here
+    void run(int count, const std::function<void(int)>& fn)
+    {
+        std::shared_ptr<Batch> batch = std::make_shared<Batch>(fn, count);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (static_cast<int>(m_workers.size()) < count - 1)
+                m_workers.emplace_back([this] { work(); });
+            for (int k = 1; k < count; k++)
+                m_queue.push_back(batch);
+        }
+        m_wake.notify_all();
+
+        batch->drain();
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&] { return batch->done == batch->count; });
+        if (batch->error)
+            std::rethrow_exception(batch->error);
+    }
+
+    ~BuildPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers)
+            worker.join();
+    }
+
+private:
+    // One run(): tasks are claimed by index, so a worker picking the batch up
+    // after the others finished it just finds nothing left
+    struct Batch
+    {
+        const std::function<void(int)>& fn;
+        int count;
+        std::atomic<int> next{ 0 };
+        int done = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        Batch(const std::function<void(int)>& f, int n) : fn(f), count(n) {}
+
+        void drain()
+        {
+            for (int k = next++; k < count; k = next++)
+            {
+                std::exception_ptr failure;
+                try { fn(k); }
+                catch (...) { failure = std::current_exception(); }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failure && !error)
+                    error = failure;
+                if (++done == count)
+                    finished.notify_all();
+            }
+        }
+    };
+
+    BuildPool() = default;
+
+    void work()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                if (m_stop)
+                    return;
+                batch = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            batch->drain();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::shared_ptr<Batch>> m_queue;
+    std::vector<std::thread> m_workers;
+    bool m_stop = false;
+};
+
+// Below this many vertices per range a slice split costs more than it saves
+static const size_t minVerticesPerRange = 4096;
+
+// fill(hBegin, hEnd) over contiguous ranges covering slices [begin, end).
+// Every slice writes at offsets known in advance, so how the slices are
+// split never changes the output.
+static void forEachSliceRange(int threads, int begin, int end, size_t verticesPerSlice, const std::function<void(int, int)>& fill)
+{
+    int slices = end - begin;
+    if (slices <= 0)
+        return;
+    size_t bySize = std::max<size_t>(1, slices * verticesPerSlice / minVerticesPerRange);
+    int ranges = static_cast<int>(std::min<size_t>({ static_cast<size_t>(threads), static_cast<size_t>(slices), bySize }));
+    if (ranges <= 1)
+    {
+        fill(begin, end);
+        return;
+    }
+    BuildPool::instance().run(ranges, [&](int k) {
+        fill(begin + slices * k / ranges, begin + slices * (k + 1) / ranges);
+    });
+}
+
+// Where the coats of an indexed build go: appended to the vectors of
+// GeometryBuffers, or written into caller owned GeometrySpans. Each coat
+// takes one block of the final size; nothing is reallocated or copied later.
+class BuildSink
+{
+public:
+    struct Block
+    {
+        uint32_t first;  // output index of the block's first vertex
+        float* verts;
+        float* norms;
+        float* texCoords;  // null: not written
+        float* colors;     // null: not written
+        uint32_t* indices;
+        size_t vertsStride, normsStride, texCoordsStride, colorsStride;  // floats a vertex
+    };
+
+    // The vectors are reserved for the whole plan up front. A throwaway
+    // texCoords / colors vector (the build overload has no such output) stays empty.
+    BuildSink(GeometryBuffers& buffers, const BuildPlan& plan, bool texCoords, bool colors)
+        : m_buffers(&buffers), m_texCoords(texCoords), m_colors(colors)
+    {
+        buffers.verts.reserve(buffers.verts.size() + plan.vertices * 3);
+        buffers.norms.reserve(buffers.norms.size() + plan.vertices * 3);
+        if (texCoords)
+            buffers.texCoords.reserve(buffers.texCoords.size() + plan.vertices * 2);
+        if (colors)
+            buffers.colors.reserve(buffers.colors.size() + plan.vertices * 4);
+        buffers.indices.reserve(buffers.indices.size() + plan.indices);
+    }
+
+    explicit BuildSink(const GeometrySpans& spans)
+        : m_buffers(nullptr), m_spans(spans), m_texCoords(spans.texCoords != nullptr), m_colors(spans.colors != nullptr)
+    {
+    }
+
+    Block take(size_t vertexCount, size_t indexCount)
+    {
+        if (m_buffers)
+        {
+            Block block;
+            block.first = static_cast<uint32_t>(m_buffers->verts.size() / 3);
+            block.verts = grow(m_buffers->verts, vertexCount * 3);
+            block.norms = grow(m_buffers->norms, vertexCount * 3);
+            block.texCoords = m_texCoords ? grow(m_buffers->texCoords, vertexCount * 2) : nullptr;
+            block.colors = m_colors ? grow(m_buffers->colors, vertexCount * 4) : nullptr;
+            block.indices = grow(m_buffers->indices, indexCount);
+            block.vertsStride = block.normsStride = 3;
+            block.texCoordsStride = 2;
+            block.colorsStride = 4;
+            return block;
+        }
+
+        Block block;
+        block.first = m_spans.baseVertex + static_cast<uint32_t>(m_vertex);
+        block.vertsStride = m_spans.stride ? m_spans.stride : 3;
+        block.normsStride = m_spans.stride ? m_spans.stride : 3;
+        block.texCoordsStride = m_spans.stride ? m_spans.stride : 2;
+        block.colorsStride = m_spans.stride ? m_spans.stride : 4;
+        block.verts = m_spans.verts ? m_spans.verts + m_vertex * block.vertsStride : nullptr;
+        block.norms = m_spans.norms ? m_spans.norms + m_vertex * block.normsStride : nullptr;
+        block.texCoords = m_spans.texCoords ? m_spans.texCoords + m_vertex * block.texCoordsStride : nullptr;
+        block.colors = m_spans.colors ? m_spans.colors + m_vertex * block.colorsStride : nullptr;
+        block.indices = m_spans.indices + m_index;
+        m_vertex += vertexCount;
+        m_index += indexCount;
+        return block;
+    }
+
+private:
+    template<typename T>
+    static T* grow(std::vector<T>& v, size_t n)
+    {
+        size_t at = v.size();
+        v.resize(at + n);
+        return v.data() + at;
+    }
+
+    GeometryBuffers* m_buffers;
+    GeometrySpans m_spans;
+    bool m_texCoords;
+    bool m_colors;
+    size_t m_vertex = 0;
+    size_t m_index = 0;
+};
+
+// The output arrays of one coat, taken from the sink at their final size.
+// Cursors write at precomputed local vertex / index offsets, exactly where
+// the serial push_back build put the same values.
+class BuildWindow
+{
+public:
+    BuildWindow(BuildSink& sink, size_t vertexCount, size_t indexCount, const std::array<float, 4>& color)
+        : m_block(sink.take(vertexCount, indexCount))
+        , m_color(color)
+    {
+    }
+
+    struct Cursor
+    {
+        BuildWindow& window;
+        size_t vertex;
+        uint32_t* index;
+
+        uint32_t addVertex(float x, float y, float z, float nx, float ny, float nz, float u, float v)
+        {
+            const BuildSink::Block& out = window.m_block;
+            if (out.verts)
+            {
+                float* p = out.verts + vertex * out.vertsStride;
+                p[0] = x; p[1] = y; p[2] = z;
+            }
+            if (out.norms)
+            {
+                float* n = out.norms + vertex * out.normsStride;
+                n[0] = nx; n[1] = ny; n[2] = nz;
+            }
+            if (out.texCoords)
+            {
+                float* t = out.texCoords + vertex * out.texCoordsStride;
+                t[0] = u; t[1] = v;
+            }
+            if (out.colors)
+            {
+                float* c = out.colors + vertex * out.colorsStride;
+                c[0] = window.m_color[0]; c[1] = window.m_color[1]; c[2] = window.m_color[2]; c[3] = window.m_color[3];
+            }
+            return out.first + static_cast<uint32_t>(vertex++);
+        }
+
+        void addIndex(uint32_t i)
+        {
+            *index++ = i;
+        }
+    };
+
+    Cursor at(size_t vertex, size_t index)
+    {
+        return Cursor{ *this, vertex, m_block.indices + index };
+    }
+
+    // Output index of local vertex `vertex`
+    uint32_t index(size_t vertex) const
+    {
+        return m_block.first + static_cast<uint32_t>(vertex);
+    }
+
+private:
+    BuildSink::Block m_block;
+    const std::array<float, 4>& m_color;
+};
+
+// One ring of sector samples, theta_i = domainStart + domainRange * i / sectors.
+// r, and dr/dtheta with it when asked, are evaluated a whole ring per call
+// (eval_batch / eval_batch_dual), cos and sin by one fused SIMD kernel;
+// arrays are padded to the SIMD width. An adaptive ring keeps a subset of
+// those samples, sectors and u follow what is kept.
+struct RingSamples
+{
+    std::vector<double> theta, r, dr, cos, sin;
+    std::vector<float> u;   // texture u, i / sectors of the uniform grid
+    int sectors = 0;
+};
+
+// Where ring samples come from: the compiled formula when one is set,
+// otherwise the cached program of the formula string
+struct RingFormula
+{
+    formula_cache::entry_ptr cached;
+    const CompiledFormula* compiled = nullptr;
+
+    RingFormula(const std::wstring& formula, const CompiledFormula& compiledFormula)
+    {
+        if (compiledFormula)
+            compiled = &compiledFormula;
+        else
+            cached = formula_cache::instance().get(formula);
+    }
+};
+
+// Normal acceleration of the outline p(theta) = r (cos, sin), |p' x p''| / |p'|;
+// a chord over a step h strays from the curve about bend * h^2 / 8
+static double outlineBend(double r, double dr, double d2r)
+{
+    double speed = std::sqrt(r * r + dr * dr);
+    if (speed < 1e-12)
+        return std::sqrt((d2r - r) * (d2r - r) + 4 * dr * dr);
+    return std::fabs(r * r + 2 * dr * dr - r * d2r) / speed;
+}
+
+// Bend at every sample of a uniform ring. r' and r'' come from a dual evaluation
+// of the cached derivative() program; compiled formulas, and formulas whose
+// derivative has no derivative itself, use central differences of r instead.
+static std::vector<double> ringBend(const RingFormula& formula, const RingSamples& ring, int sectors)
+{
+    using expresie_tokenizer::span;
+
+    size_t n = static_cast<size_t>(sectors) + 1;
+    std::vector<double> dr(n), d2r(n);
+    bool exact = false;
+    const formula_program* derivative = formula.cached ? formula.cached->derivative.get() : nullptr;
+    if (derivative)
+    {
+        try
+        {
+            formula_state state(*derivative);
+            derivative->eval_batch_dual(state, derivative->find_slot(L"theta"), span<const double>(ring.theta.data(), n),
+                span<double>(dr.data(), n), span<double>(d2r.data(), n));
+            exact = true;
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+    }
+    if (!exact)
+    {
+        double h = ring.theta[1] - ring.theta[0];
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t lo = i > 0 ? i - 1 : i;
+            size_t hi = i + 1 < n ? i + 1 : i;
+            size_t mid = std::min(std::max(i, size_t(1)), n - 2);
+            dr[i] = (ring.r[hi] - ring.r[lo]) / (h * (hi - lo));
+            d2r[i] = (ring.r[mid + 1] - 2 * ring.r[mid] + ring.r[mid - 1]) / (h * h);
+        }
+    }
+
+    std::vector<double> bend(n);
+    for (size_t i = 0; i < n; i++)
+        bend[i] = outlineBend(ring.r[i], dr[i], d2r[i]);
+    return bend;
+}
+
+// Greedy walk over the uniform samples: a chord reaches as far as its curvature
+// estimate and the distance of every sample it skips stay within tolerance.
+// Distances catch kinks (abs, min, max) the second derivative does not see.
+static std::vector<size_t> adaptiveSamples(const RingSamples& ring, int sectors, double tolerance, const std::vector<double>& bend)
+{
+    auto x = [&](size_t i) { return ring.r[i] * ring.cos[i]; };
+    auto y = [&](size_t i) { return ring.r[i] * ring.sin[i]; };
+    auto fits = [&](size_t a, size_t b)
+    {
+        double h = ring.theta[b] - ring.theta[a];
+        double maxBend = *std::max_element(bend.begin() + a, bend.begin() + b + 1);
+        if (!(maxBend * h * h / 8 <= tolerance))
+            return false;
+
+        double dx = x(b) - x(a), dy = y(b) - y(a);
+        double len2 = dx * dx + dy * dy;
+        for (size_t k = a + 1; k < b; k++)
+        {
+            double px = x(k) - x(a), py = y(k) - y(a);
+            double t = len2 > 0 ? std::min(1.0, std::max(0.0, (px * dx + py * dy) / len2)) : 0.0;
+            double ex = px - t * dx, ey = py - t * dy;
+            if (!(ex * ex + ey * ey <= tolerance * tolerance))
+                return false;
+        }
+        return true;
+    };
+
+    std::vector<size_t> kept{ 0 };
+    size_t a = 0;
+    for (size_t b = 2; b <= static_cast<size_t>(sectors); b++)
+    {
+        if (fits(a, b))
+            continue;
+        a = b - 1;
+        kept.push_back(a);
+    }
+    kept.push_back(static_cast<size_t>(sectors));
+    return kept;
+}
+
+static void sampleRing(
+    const RingFormula& formula,
+    bool withDerivative,
+    float domainStart, float domainRange, int sectors, float tolerance,
+    RingSamples& ring)
+{
+    using expresie_tokenizer::span;
+    namespace simd = expresie_tokenizer::simd;
+
+    size_t n = static_cast<size_t>(sectors) + 1;
+    size_t padded = (n + simd::width - 1) / simd::width * simd::width;
+
+    ring.theta.resize(padded);
+    for (int i = 0; i <= sectors; i++)
+        ring.theta[i] = domainStart + domainRange * i / sectors;
+    std::fill(ring.theta.begin() + n, ring.theta.end(), ring.theta[n - 1]);
+
+    ring.r.resize(padded);
+    if (withDerivative)
+        ring.dr.resize(padded);
+
+    if (formula.compiled)
+        (*formula.compiled)(ring.theta.data(), ring.r.data(), withDerivative ? ring.dr.data() : nullptr, n);
+    else
+    {
+        const formula_program& expr_r = *formula.cached->program;
+
+        // theta is the only variable a polar formula may use
+        size_t theta = expr_r.find_slot(L"theta");
+        for (size_t i = 0; i < expr_r.slot_count(); i++)
+            if (i != theta)
+                throw std::runtime_error("Unbound variable: " + std::string(expr_r.slot_name(i).begin(), expr_r.slot_name(i).end()));
+
+        formula_state state(expr_r);
+        if (withDerivative)
+            expr_r.eval_batch_dual(state, theta, span<const double>(ring.theta.data(), n),
+                span<double>(ring.r.data(), n), span<double>(ring.dr.data(), n));
+        else
+            expr_r.eval_batch(state, theta, span<const double>(ring.theta.data(), n), span<double>(ring.r.data(), n));
+    }
+
+    ring.cos.resize(padded);
+    ring.sin.resize(padded);
+    simd::sincos_batch(ring.theta.data(), ring.sin.data(), ring.cos.data(), padded);
+
+    ring.u.resize(n);
+    for (int i = 0; i <= sectors; i++)
+        ring.u[i] = static_cast<float>(i) / sectors;
+    ring.sectors = sectors;
+    if (tolerance <= 0 || sectors < 2)
+        return;
+
+    // Keep the chosen samples in place, values unchanged; padding repeats the last
+    std::vector<size_t> kept = adaptiveSamples(ring, sectors, tolerance, ringBend(formula, ring, sectors));
+    size_t keptPadded = (kept.size() + simd::width - 1) / simd::width * simd::width;
+    auto compact = [&](auto& values)
+    {
+        if (values.empty())
+            return;
+        for (size_t j = 0; j < kept.size(); j++)
+            values[j] = values[kept[j]];
+        values.resize(keptPadded, values[kept.size() - 1]);
+        std::fill(values.begin() + kept.size(), values.end(), values[kept.size() - 1]);
+    };
+    compact(ring.theta);
+    compact(ring.r);
+    compact(ring.dr);
+    compact(ring.cos);
+    compact(ring.sin);
+    compact(ring.u);
+    ring.u.resize(kept.size());
+    ring.sectors = static_cast<int>(kept.size()) - 1;
+}
+
 // ============================================================================
 // CONE - PUBLIC METHODS (with post-build transformation)
 // ============================================================================
@@ -388,19 +1155,10 @@ PolarBuilder Builder::polar()
 // CONE - INTERNAL (UNCHANGED COMPUTATION LOGIC)
 // ============================================================================
 
-PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat)
+PolarBuilder& PolarBuilder::buildConeIndexedInternal(BuildSink& sink, const RingSamples& ring, bool strips, bool isSecondCoat)
 {
-    using expresie_tokenizer::expression_token_compiler;
-    using expresie_tokenizer::expression;
-    expression_token_compiler compiler;
-
-    long double theta = 0.0L;
-
-    std::unique_ptr<expression> expr_r = compiler.compile(m_formula);
-    expr_r->bind(L"theta", &theta);
-
-    std::unique_ptr<expression> expr_dr = simplify(expr_r->derivative(L"theta"));
-    expr_dr->bind(L"theta", &theta);
+    // r and dr/dtheta of the ring come from one dual evaluation, no symbolic derivative
+    const int sectors = ring.sectors;
 
     // Geometry position depends on m_reversed (user's choice)
     const float z_tip = m_reversed ? 0.0f : -1.0f;
@@ -413,39 +1171,37 @@ PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, b
 
     //std::array<float, 4> c = isSecondCoat ? m_color_inner : m_color_outer;
     const std::array<float, 4>& c = isSecondCoat ? m_color_inner : m_color_outer;
-    auto addVertex = [&](float x, float y, float z, float nx, float ny, float nz, float u, float v) -> uint32_t {
-        uint32_t idx = static_cast<uint32_t>(buffers.verts.size() / 3);
-        buffers.verts.insert(buffers.verts.end(), { x, y, z });
-        buffers.norms.insert(buffers.norms.end(), { nx, ny, nz });
-        buffers.texCoords.insert(buffers.texCoords.end(), { u, v });
-        buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-        return idx;
-    };
 
-    uint32_t tipIndex = addVertex(0.0f, 0.0f, z_tip, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f);
+    // Tip, then slices rings of sectors + 1; tip fan, then two triangles per quad.
+    // Strips: the fan and every slice are one band, the second coat's repeating its first index
+    const size_t ringSize = static_cast<size_t>(sectors) + 1;
+    const size_t fanIndices = strips ? stripBandIndices(ringSize, isSecondCoat) : static_cast<size_t>(sectors) * 3;
+    const size_t quadIndices = strips ? stripBandIndices(ringSize, isSecondCoat) : static_cast<size_t>(sectors) * 6;
+    BuildWindow out(sink, 1 + m_slices * ringSize, fanIndices + (m_slices - 1) * quadIndices, c);
+    BuildWindow::Cursor first = out.at(0, 0);
 
-    std::vector<float> baseX(m_sectors + 1);
-    std::vector<float> baseY(m_sectors + 1);
-    std::vector<float> baseNx(m_sectors + 1);
-    std::vector<float> baseNy(m_sectors + 1);
-    std::vector<float> baseNz(m_sectors + 1);
-    std::vector<uint32_t> baseRing(m_sectors + 1);
+    uint32_t tipIndex = first.addVertex(0.0f, 0.0f, z_tip, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f);
 
-    float domainRange = m_domainEnd - m_domainStart;
+    std::vector<float> baseX(sectors + 1);
+    std::vector<float> baseY(sectors + 1);
+    std::vector<float> baseNx(sectors + 1);
+    std::vector<float> baseNy(sectors + 1);
+    std::vector<float> baseNz(sectors + 1);
+    std::vector<uint32_t> baseRing(sectors + 1);
 
-    for (int i = 0; i <= m_sectors; i++)
+
+    for (int i = 0; i <= sectors; i++)
     {
-        theta = m_domainStart + domainRange * i / m_sectors;
-        float u = static_cast<float>(i) / m_sectors;
+        float u = ring.u[i];
 
-        float r = static_cast<float>(expr_r->eval());
-        float dr = static_cast<float>(expr_dr->eval());
+        float r = static_cast<float>(ring.r[i]);
+        float dr = static_cast<float>(ring.dr[i]);
 
-        float x = static_cast<float>(expr_r->cyl_x(theta)) / m_slices;
-        float y = static_cast<float>(expr_r->cyl_y(theta)) / m_slices;
+        float x = static_cast<float>(ring.r[i] * ring.cos[i]) / m_slices;
+        float y = static_cast<float>(ring.r[i] * ring.sin[i]) / m_slices;
 
-        float cos_t = std::cos(static_cast<float>(theta));
-        float sin_t = std::sin(static_cast<float>(theta));
+        float cos_t = static_cast<float>(ring.cos[i]);
+        float sin_t = static_cast<float>(ring.sin[i]);
         float nx = (dr * sin_t + r * cos_t);
         float ny = -(dr * cos_t - r * sin_t);
         float nz = -1.0f;
@@ -485,41 +1241,46 @@ PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, b
         baseY[i] = y * m_slices;
 
         float firstRingZ = z_tip + (z_base - z_tip) / m_slices;
-        baseRing[i] = addVertex(x, y, firstRingZ, baseNx[i], baseNy[i], baseNz[i], u, 1.0f / m_slices);
+        baseRing[i] = first.addVertex(x, y, firstRingZ, baseNx[i], baseNy[i], baseNz[i], u, 1.0f / m_slices);
     }
 
     // Tip triangles
-    for (int i = 0; i < m_sectors; i++)
+    if (strips)
+        addStripBand([&](uint32_t index) { first.addIndex(index); }, ringSize, isSecondCoat,
+            [&](size_t) { return tipIndex; }, [&](size_t i) { return baseRing[i]; });
+    for (int i = 0; i < sectors && !strips; i++)
     {
         if (!isSecondCoat)
         {
-            buffers.indices.push_back(tipIndex);
-            buffers.indices.push_back(baseRing[i]);
-            buffers.indices.push_back(baseRing[i + 1]);
+            first.addIndex(tipIndex);
+            first.addIndex(baseRing[i]);
+            first.addIndex(baseRing[i + 1]);
         }
         else
         {
-            buffers.indices.push_back(tipIndex);
-            buffers.indices.push_back(baseRing[i + 1]);
-            buffers.indices.push_back(baseRing[i]);
+            first.addIndex(tipIndex);
+            first.addIndex(baseRing[i + 1]);
+            first.addIndex(baseRing[i]);
         }
     }
 
-    if (m_slices > 1)
-    {
-        std::vector<uint32_t> prevRing = baseRing;
-
-        for (int h = 1; h < m_slices; h++)
+    // Slice h joins ring h to ring h + 1; rings and their indices sit at fixed offsets
+    forEachSliceRange(threadCount(), 1, m_slices, ringSize, [&](int hBegin, int hEnd) {
+        for (int h = hBegin; h < hEnd; h++)
         {
             float h2n = static_cast<float>(h + 1) / m_slices;
             float z = z_tip + (z_base - z_tip) * h2n;
 
-            std::vector<uint32_t> currRing(m_sectors + 1);
+            BuildWindow::Cursor at = out.at(1 + h * ringSize, fanIndices + (h - 1) * quadIndices);
+            std::vector<uint32_t> prevRing(sectors + 1);
+            std::vector<uint32_t> currRing(sectors + 1);
+            for (int i = 0; i <= sectors; i++)
+                prevRing[i] = out.index(1 + (h - 1) * ringSize + i);
 
-            for (int i = 0; i <= m_sectors; i++)
+            for (int i = 0; i <= sectors; i++)
             {
                 float x, y, nx, ny, nz;
-                float u = static_cast<float>(i) / m_sectors;
+                float u = ring.u[i];
 
                 if (m_turbo)
                 {
@@ -531,16 +1292,14 @@ PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, b
                 }
                 else
                 {
-                    theta = m_domainStart + domainRange * i / m_sectors;
-
-                    float r = static_cast<float>(expr_r->eval());
-                    float dr = static_cast<float>(expr_dr->eval());
+                    float r = static_cast<float>(ring.r[i]);
+                    float dr = static_cast<float>(ring.dr[i]);
 
-                    x = static_cast<float>(expr_r->cyl_x(theta)) * h2n;
-                    y = static_cast<float>(expr_r->cyl_y(theta)) * h2n;
+                    x = static_cast<float>(ring.r[i] * ring.cos[i]) * h2n;
+                    y = static_cast<float>(ring.r[i] * ring.sin[i]) * h2n;
 
-                    float cos_t = std::cos(static_cast<float>(theta));
-                    float sin_t = std::sin(static_cast<float>(theta));
+                    float cos_t = static_cast<float>(ring.cos[i]);
+                    float sin_t = static_cast<float>(ring.sin[i]);
                     nx = (dr * sin_t + r * cos_t);
                     ny = -(dr * cos_t - r * sin_t);
                     nz = -1.0f;
@@ -572,10 +1331,13 @@ PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, b
                     }
                 }
 
-                currRing[i] = addVertex(x, y, z, nx, ny, nz, u, h2n);
+                currRing[i] = at.addVertex(x, y, z, nx, ny, nz, u, h2n);
             }
 
-            for (int i = 0; i < m_sectors; i++)
+            if (strips)
+                addStripBand([&](uint32_t index) { at.addIndex(index); }, ringSize, isSecondCoat,
+                    [&](size_t i) { return prevRing[i]; }, [&](size_t i) { return currRing[i]; });
+            for (int i = 0; i < sectors && !strips; i++)
             {
                 uint32_t v00 = prevRing[i];
                 uint32_t v01 = prevRing[i + 1];
@@ -584,37 +1346,31 @@ PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, b
 
                 if (!isSecondCoat)
                 {
-                    buffers.indices.push_back(v00);
-                    buffers.indices.push_back(v10);
-                    buffers.indices.push_back(v01);
+                    at.addIndex(v00);
+                    at.addIndex(v10);
+                    at.addIndex(v01);
 
-                    buffers.indices.push_back(v01);
-                    buffers.indices.push_back(v10);
-                    buffers.indices.push_back(v11);
+                    at.addIndex(v01);
+                    at.addIndex(v10);
+                    at.addIndex(v11);
                 }
                 else
                 {
-                    buffers.indices.push_back(v00);
-                    buffers.indices.push_back(v01);
-                    buffers.indices.push_back(v10);
+                    at.addIndex(v00);
+                    at.addIndex(v01);
+                    at.addIndex(v10);
 
-                    buffers.indices.push_back(v01);
-                    buffers.indices.push_back(v11);
-                    buffers.indices.push_back(v10);
+                    at.addIndex(v01);
+                    at.addIndex(v11);
+                    at.addIndex(v10);
                 }
             }
-
-            prevRing = currRing;
-            //buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-            //buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-            //buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-
         }
-    }
+    });
 
-    if (!isSecondCoat && m_doubleCoated)
+    if (!isSecondCoat && secondCoat())
     {
-        buildConeIndexedInternal(buffers, true);
+        buildConeIndexedInternal(sink, ring, strips, true);
     }
 
     return *this;
@@ -622,43 +1378,36 @@ PolarBuilder& PolarBuilder::buildConeIndexedInternal(GeometryBuffers& buffers, b
 
 PolarBuilder& PolarBuilder::buildConeDiscrete(GeometryBuffers& buffers)
 {
-    return buildConeDiscreteInternal(buffers, false);
+    RingSamples ring;
+    sampleSectors(ring, false);
+    return buildConeDiscreteInternal(buffers, ring, false);
 }
 
-PolarBuilder& PolarBuilder::buildConeDiscreteInternal(GeometryBuffers& buffers, bool isSecondCoat)
+PolarBuilder& PolarBuilder::buildConeDiscreteInternal(GeometryBuffers& buffers, const RingSamples& ring, bool isSecondCoat)
 {
-    using expresie_tokenizer::expression_token_compiler;
-    using expresie_tokenizer::expression;
-    expression_token_compiler compiler;
-
-    long double theta = 0.0L;
-
-    std::unique_ptr<expression> expr_r = compiler.compile(m_formula);
-    expr_r->bind(L"theta", &theta);
+    const int sectors = ring.sectors;
 
     // Geometry position depends on m_reversed (user's choice)
     const float z_tip = m_reversed ? 0.0f : -1.0f;
     const float z_base = m_reversed ? -1.0f : 0.0f;
 
-    float domainRange = m_domainEnd - m_domainStart;
+
     std::array<float, 4> c = isSecondCoat ?  m_color_outer : m_color_inner;
 
     // Precompute ring positions (ring 0 is closest to tip)
-    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(m_sectors + 1));
+    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(sectors + 1));
 
     for (int h = 0; h <= m_slices; h++)
     {
         float scale = static_cast<float>(h) / m_slices;
         float z = z_tip + (z_base - z_tip) * scale;
 
-        for (int i = 0; i <= m_sectors; i++)
+        for (int i = 0; i <= sectors; i++)
         {
-            theta = m_domainStart + domainRange * i / m_sectors;
-
-            float x = static_cast<float>(expr_r->cyl_x(theta)) * scale;
-            float y = static_cast<float>(expr_r->cyl_y(theta)) * scale;
+            float x = static_cast<float>(ring.r[i] * ring.cos[i]) * scale;
+            float y = static_cast<float>(ring.r[i] * ring.sin[i]) * scale;
 
             ringX[h][i] = x;
             ringY[h][i] = y;
@@ -669,10 +1418,10 @@ PolarBuilder& PolarBuilder::buildConeDiscreteInternal(GeometryBuffers& buffers,
     // Tip triangles (h=0 ring is at the tip, all vertices collapse to origin)
     float tipX = 0.0f, tipY = 0.0f, tipZ = z_tip;
 
-    for (int i = 0; i < m_sectors; i++)
+    for (int i = 0; i < sectors; i++)
     {
-        float u0 = static_cast<float>(i) / m_sectors;
-        float u1 = static_cast<float>(i + 1) / m_sectors;
+        float u0 = ring.u[i];
+        float u1 = ring.u[i + 1];
 
         // First ring vertices
         float x0 = ringX[1][i], y0 = ringY[1][i], z0 = ringZ[1][i];
@@ -710,10 +1459,10 @@ PolarBuilder& PolarBuilder::buildConeDiscreteInternal(GeometryBuffers& buffers,
         float v0 = static_cast<float>(h) / m_slices;
         float v1 = static_cast<float>(h + 1) / m_slices;
 
-        for (int i = 0; i < m_sectors; i++)
+        for (int i = 0; i < sectors; i++)
         {
-            float u0 = static_cast<float>(i) / m_sectors;
-            float u1 = static_cast<float>(i + 1) / m_sectors;
+            float u0 = ring.u[i];
+            float u1 = ring.u[i + 1];
 
             // Quad corners
             float x00 = ringX[h][i],         y00 = ringY[h][i],         z00 = ringZ[h][i];
@@ -776,9 +1525,9 @@ PolarBuilder& PolarBuilder::buildConeDiscreteInternal(GeometryBuffers& buffers,
         }
     }
 
-    if (!isSecondCoat && m_doubleCoated)
+    if (!isSecondCoat && secondCoat())
     {
-        buildConeDiscreteInternal(buffers, true);
+        buildConeDiscreteInternal(buffers, ring, true);
     }
 
     return *this;
@@ -788,54 +1537,41 @@ PolarBuilder& PolarBuilder::buildConeDiscreteInternal(GeometryBuffers& buffers,
 // CYLINDER - INTERNAL (UNCHANGED COMPUTATION LOGIC)
 // ============================================================================
 
-PolarBuilder& PolarBuilder::buildCylinderIndexedInternal( GeometryBuffers& buffers, bool isSecondCoat)
+PolarBuilder& PolarBuilder::buildCylinderIndexedInternal(BuildSink& sink, const RingSamples& ring, bool strips, bool isSecondCoat)
 {
-    using expresie_tokenizer::expression_token_compiler;
-    using expresie_tokenizer::expression;
-    expression_token_compiler compiler;
-
-    long double theta = 0.0L;
-
-    std::unique_ptr<expression> expr_r = compiler.compile(m_formula);
-    expr_r->bind(L"theta", &theta);
-
-    std::unique_ptr<expression> expr_dr = simplify(expr_r->derivative(L"theta"));
-    expr_dr->bind(L"theta", &theta);
+    // r and dr/dtheta of the ring come from one dual evaluation, no symbolic derivative
+    const int sectors = ring.sectors;
 
     const std::array<float, 4>& c = isSecondCoat ? m_color_inner : m_color_outer;
-    auto addVertex = [&](float x, float y, float z, float nx, float ny, float nz, float u, float v) -> uint32_t {
-        uint32_t idx = static_cast<uint32_t>(buffers.verts.size() / 3);
-        buffers.verts.insert(buffers.verts.end(), { x, y, z });
-        buffers.norms.insert(buffers.norms.end(), { nx, ny, nz });
-        buffers.texCoords.insert(buffers.texCoords.end(), { u, v });
-        buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-        return idx;
-    };
+
+    // slices + 1 rings of sectors + 1, two triangles per quad or a band per slice;
+    // the first coat winds (p0, p1, c0), its strips repeat their first index
+    const size_t ringSize = static_cast<size_t>(sectors) + 1;
+    const size_t quadIndices = strips ? stripBandIndices(ringSize, !isSecondCoat) : static_cast<size_t>(sectors) * 6;
+    BuildWindow out(sink, (m_slices + 1) * ringSize, m_slices * quadIndices, c);
+    BuildWindow::Cursor first = out.at(0, 0);
 
     // Store first ring data for turbo mode
-    std::vector<float> baseX(m_sectors + 1);
-    std::vector<float> baseY(m_sectors + 1);
-    std::vector<float> baseNx(m_sectors + 1);
-    std::vector<float> baseNy(m_sectors + 1);
+    std::vector<float> baseX(sectors + 1);
+    std::vector<float> baseY(sectors + 1);
+    std::vector<float> baseNx(sectors + 1);
+    std::vector<float> baseNy(sectors + 1);
 
-    float domainRange = m_domainEnd - m_domainStart;
 
-	//std::cout << "Building cylinder indexed: sectors=" << m_sectors << ", slices=" << m_slices << ", turbo=" << m_turbo << "\n";
+	//std::cout << "Building cylinder indexed: sectors=" << sectors << ", slices=" << m_slices << ", turbo=" << m_turbo << "\n";
     // Build first ring at z = 0
-    std::vector<uint32_t> prevRing(m_sectors + 1);
-    for (int i = 0; i <= m_sectors; i++)
+    for (int i = 0; i <= sectors; i++)
     {
-        theta = m_domainStart + domainRange * i / m_sectors;
-        float u = static_cast<float>(i) / m_sectors;
+        float u = ring.u[i];
 
-        float r = static_cast<float>(expr_r->eval());
-        float dr = static_cast<float>(expr_dr->eval());
+        float r = static_cast<float>(ring.r[i]);
+        float dr = static_cast<float>(ring.dr[i]);
 
-        float x = static_cast<float>(expr_r->cyl_x(theta));
-        float y = static_cast<float>(expr_r->cyl_y(theta));
+        float x = static_cast<float>(ring.r[i] * ring.cos[i]);
+        float y = static_cast<float>(ring.r[i] * ring.sin[i]);
 
-        float cos_t = std::cos(static_cast<float>(theta));
-        float sin_t = std::sin(static_cast<float>(theta));
+        float cos_t = static_cast<float>(ring.cos[i]);
+        float sin_t = static_cast<float>(ring.sin[i]);
         float nx = (dr * sin_t + r * cos_t);
         float ny = -(dr * cos_t - r * sin_t);
 
@@ -857,22 +1593,27 @@ PolarBuilder& PolarBuilder::buildCylinderIndexedInternal( GeometryBuffers& buffe
         baseNx[i] = nx;
         baseNy[i] = ny;
 
-        prevRing[i] = addVertex(x, y, 0.0f, nx, ny, 0.0f, u, 0.0f);
+        first.addVertex(x, y, 0.0f, nx, ny, 0.0f, u, 0.0f);
     }
 
-    // Build remaining rings and quads
-    for (int h = 1; h <= m_slices; h++)
+    // Build remaining rings and quads, ring h and its indices at fixed offsets
+    forEachSliceRange(threadCount(), 1, m_slices + 1, ringSize, [&](int hBegin, int hEnd) {
+    for (int h = hBegin; h < hEnd; h++)
     {
         float t = static_cast<float>(h) / m_slices;
         float z = -t;  // Goes from 0 to -1
         float v = t;
 
-        std::vector<uint32_t> currRing(m_sectors + 1);
+        BuildWindow::Cursor at = out.at(h * ringSize, (h - 1) * quadIndices);
+        std::vector<uint32_t> prevRing(sectors + 1);
+        std::vector<uint32_t> currRing(sectors + 1);
+        for (int i = 0; i <= sectors; i++)
+            prevRing[i] = out.index((h - 1) * ringSize + i);
 
-        for (int i = 0; i <= m_sectors; i++)
+        for (int i = 0; i <= sectors; i++)
         {
             float x, y, nx, ny;
-            float u = static_cast<float>(i) / m_sectors;
+            float u = ring.u[i];
 
             if (m_turbo)
             {
@@ -883,16 +1624,14 @@ PolarBuilder& PolarBuilder::buildCylinderIndexedInternal( GeometryBuffers& buffe
             }
             else
             {
-                theta = m_domainStart + domainRange * i / m_sectors;
-
-                float r = static_cast<float>(expr_r->eval());
-                float dr = static_cast<float>(expr_dr->eval());
+                float r = static_cast<float>(ring.r[i]);
+                float dr = static_cast<float>(ring.dr[i]);
 
-                x = static_cast<float>(expr_r->cyl_x(theta));
-                y = static_cast<float>(expr_r->cyl_y(theta));
+                x = static_cast<float>(ring.r[i] * ring.cos[i]);
+                y = static_cast<float>(ring.r[i] * ring.sin[i]);
 
-                float cos_t = std::cos(static_cast<float>(theta));
-                float sin_t = std::sin(static_cast<float>(theta));
+                float cos_t = static_cast<float>(ring.cos[i]);
+                float sin_t = static_cast<float>(ring.sin[i]);
                 nx = dr * sin_t + r * cos_t;
                 ny = -(dr * cos_t - r * sin_t);
 
@@ -910,10 +1649,13 @@ PolarBuilder& PolarBuilder::buildCylinderIndexedInternal( GeometryBuffers& buffe
                 }
             }
 
-            currRing[i] = addVertex(x, y, z, nx, ny, 0.0f, u, v);
+            currRing[i] = at.addVertex(x, y, z, nx, ny, 0.0f, u, v);
         }
 
-        for (int i = 0; i < m_sectors; i++)
+        if (strips)
+            addStripBand([&](uint32_t index) { at.addIndex(index); }, ringSize, !isSecondCoat,
+                [&](size_t i) { return prevRing[i]; }, [&](size_t i) { return currRing[i]; });
+        for (int i = 0; i < sectors && !strips; i++)
         {
             uint32_t v00 = prevRing[i];
             uint32_t v01 = prevRing[i + 1];
@@ -922,65 +1664,56 @@ PolarBuilder& PolarBuilder::buildCylinderIndexedInternal( GeometryBuffers& buffe
 
             if (isSecondCoat)
             {
-                buffers.indices.push_back(v00);
-                buffers.indices.push_back(v10);
-                buffers.indices.push_back(v01);
+                at.addIndex(v00);
+                at.addIndex(v10);
+                at.addIndex(v01);
 
-                buffers.indices.push_back(v01);
-                buffers.indices.push_back(v10);
-                buffers.indices.push_back(v11);
+                at.addIndex(v01);
+                at.addIndex(v10);
+                at.addIndex(v11);
             }
             else
             {
-                buffers.indices.push_back(v00);
-                buffers.indices.push_back(v01);
-                buffers.indices.push_back(v10);
+                at.addIndex(v00);
+                at.addIndex(v01);
+                at.addIndex(v10);
 
-                buffers.indices.push_back(v01);
-                buffers.indices.push_back(v11);
-                buffers.indices.push_back(v10);
+                at.addIndex(v01);
+                at.addIndex(v11);
+                at.addIndex(v10);
             }
         }
-
-        prevRing = currRing;
     }
+    });
 
-    if (!isSecondCoat && m_doubleCoated)
+    if (!isSecondCoat && secondCoat())
     {
-        buildCylinderIndexedInternal(buffers, true);
+        buildCylinderIndexedInternal(sink, ring, strips, true);
     }
 
     return *this;
 }
 
-PolarBuilder& PolarBuilder::buildCylinderDiscreteIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat)
+PolarBuilder& PolarBuilder::buildCylinderDiscreteIndexedInternal(BuildSink& sink, const RingSamples& ring, bool isSecondCoat)
 {
-    using expresie_tokenizer::expression_token_compiler;
-    using expresie_tokenizer::expression;
-    expression_token_compiler compiler;
+    if (m_strips)
+        throw std::runtime_error("Triangle strips run over the shared vertices of a smooth build, edged builds have none to share");
+    const int sectors = ring.sectors;
 
-    long double theta = 0.0L;
 
-    std::unique_ptr<expression> expr_r = compiler.compile(m_formula);
-    expr_r->bind(L"theta", &theta);
-
-    float domainRange = m_domainEnd - m_domainStart;
-
-    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(m_sectors + 1));
+    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(sectors + 1));
 
     for (int h = 0; h <= m_slices; h++)
     {
         float t = static_cast<float>(h) / m_slices;
         float z = -t;  // Goes from 0 to -1
 
-        for (int i = 0; i <= m_sectors; i++)
+        for (int i = 0; i <= sectors; i++)
         {
-            theta = m_domainStart + domainRange * i / m_sectors;
-
-            float x = static_cast<float>(expr_r->cyl_x(theta));
-            float y = static_cast<float>(expr_r->cyl_y(theta));
+            float x = static_cast<float>(ring.r[i] * ring.cos[i]);
+            float y = static_cast<float>(ring.r[i] * ring.sin[i]);
 
             ringX[h][i] = x;
             ringY[h][i] = y;
@@ -988,25 +1721,23 @@ PolarBuilder& PolarBuilder::buildCylinderDiscreteIndexedInternal(GeometryBuffers
         }
     }
     const std::array<float, 4>& c = isSecondCoat ? m_color_inner : m_color_outer;
-    auto addVertex = [&](float x, float y, float z, float nx, float ny, float nz, float u, float v) -> uint32_t {
-        uint32_t idx = static_cast<uint32_t>(buffers.verts.size() / 3);
-        buffers.verts.insert(buffers.verts.end(), { x, y, z });
-        buffers.norms.insert(buffers.norms.end(), { nx, ny, nz });
-        buffers.texCoords.insert(buffers.   texCoords.end(), { u, v });
-        buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-        return idx;
-    };
+
+    // Six vertices and six indices per quad, slice h starts at h * sliceSize
+    const size_t sliceSize = static_cast<size_t>(sectors) * 6;
+    BuildWindow out(sink, m_slices * sliceSize, m_slices * sliceSize, c);
 
     // Generate triangles with flat normals
-    for (int h = 0; h < m_slices; h++)
+    forEachSliceRange(threadCount(), 0, m_slices, sliceSize, [&](int hBegin, int hEnd) {
+    for (int h = hBegin; h < hEnd; h++)
     {
         float v0 = static_cast<float>(h) / m_slices;
         float v1 = static_cast<float>(h + 1) / m_slices;
+        BuildWindow::Cursor at = out.at(h * sliceSize, h * sliceSize);
 
-        for (int i = 0; i < m_sectors; i++)
+        for (int i = 0; i < sectors; i++)
         {
-            float u0 = static_cast<float>(i) / m_sectors;
-            float u1 = static_cast<float>(i + 1) / m_sectors;
+            float u0 = ring.u[i];
+            float u1 = ring.u[i + 1];
 
             // Quad corners
             float x00 = ringX[h][i], y00 = ringY[h][i], z00 = ringZ[h][i];
@@ -1019,22 +1750,22 @@ PolarBuilder& PolarBuilder::buildCylinderDiscreteIndexedInternal(GeometryBuffers
             if (!isSecondCoat)
             {
                 crossProductNormalLefthanded(x00, y00, z00, x10, y10, z10, x01, y01, z01, nx1, ny1, nz1, false);
-                uint32_t i0 = addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
-                uint32_t i1 = addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
-                uint32_t i2 = addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
+                uint32_t i1 = at.addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
+                uint32_t i2 = at.addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
             else
             {
                 crossProductNormalLefthanded(x00, y00, z00, x01, y01, z01, x10, y10, z10, nx1, ny1, nz1, false);
-                uint32_t i0 = addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
-                uint32_t i1 = addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
-                uint32_t i2 = addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
+                uint32_t i1 = at.addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
+                uint32_t i2 = at.addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
 
             // Triangle 2
@@ -1042,29 +1773,30 @@ PolarBuilder& PolarBuilder::buildCylinderDiscreteIndexedInternal(GeometryBuffers
             if (!isSecondCoat)
             {
                 crossProductNormalLefthanded(x01, y01, z01, x10, y10, z10, x11, y11, z11, nx2, ny2, nz2, false);
-                uint32_t i0 = addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
-                uint32_t i1 = addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
-                uint32_t i2 = addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
+                uint32_t i1 = at.addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
+                uint32_t i2 = at.addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
             else
             {
                 crossProductNormalLefthanded(x01, y01, z01, x11, y11, z11, x10, y10, z10, nx2, ny2, nz2, false);
-                uint32_t i0 = addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
-                uint32_t i1 = addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
-                uint32_t i2 = addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
+                uint32_t i1 = at.addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
+                uint32_t i2 = at.addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
         }
     }
+    });
 
-    if (!isSecondCoat && m_doubleCoated)
+    if (!isSecondCoat && secondCoat())
     {
-        buildCylinderDiscreteIndexedInternal(buffers, true);
+        buildCylinderDiscreteIndexedInternal(sink, ring, true);
     }
 
     return *this;
@@ -1072,37 +1804,30 @@ PolarBuilder& PolarBuilder::buildCylinderDiscreteIndexedInternal(GeometryBuffers
 
 PolarBuilder& PolarBuilder::buildCylinderDiscrete(GeometryBuffers& buffers)
 {
-    return buildCylinderDiscreteInternal(buffers, false);
+    RingSamples ring;
+    sampleSectors(ring, false);
+    return buildCylinderDiscreteInternal(buffers, ring, false);
 }
 
-PolarBuilder& PolarBuilder::buildCylinderDiscreteInternal(GeometryBuffers& buffers, bool isSecondCoat)
+PolarBuilder& PolarBuilder::buildCylinderDiscreteInternal(GeometryBuffers& buffers, const RingSamples& ring, bool isSecondCoat)
 {
-    using expresie_tokenizer::expression_token_compiler;
-    using expresie_tokenizer::expression;
-    expression_token_compiler compiler;
-    long double theta = 0.0L;
-
-    std::unique_ptr<expression> expr_r = compiler.compile(m_formula);
-    expr_r->bind(L"theta", &theta);
+    const int sectors = ring.sectors;
 
-    float domainRange = m_domainEnd - m_domainStart;
 
     // Precompute ring positions
-    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(m_sectors + 1));
+    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(sectors + 1));
 
     for (int h = 0; h <= m_slices; h++)
     {
         float t = static_cast<float>(h) / m_slices;
         float z = -t;  // Goes from 0 to -1
 
-        for (int i = 0; i <= m_sectors; i++)
+        for (int i = 0; i <= sectors; i++)
         {
-            theta = m_domainStart + domainRange * i / m_sectors;
-
-            float x = static_cast<float>(expr_r->cyl_x(theta));
-            float y = static_cast<float>(expr_r->cyl_y(theta));
+            float x = static_cast<float>(ring.r[i] * ring.cos[i]);
+            float y = static_cast<float>(ring.r[i] * ring.sin[i]);
 
             ringX[h][i] = x;
             ringY[h][i] = y;
@@ -1117,10 +1842,10 @@ PolarBuilder& PolarBuilder::buildCylinderDiscreteInternal(GeometryBuffers& buffe
         float v0 = static_cast<float>(h) / m_slices;
         float v1 = static_cast<float>(h + 1) / m_slices;
 
-        for (int i = 0; i < m_sectors; i++)
+        for (int i = 0; i < sectors; i++)
         {
-            float u0 = static_cast<float>(i) / m_sectors;
-            float u1 = static_cast<float>(i + 1) / m_sectors;
+            float u0 = ring.u[i];
+            float u1 = ring.u[i + 1];
 
             float x00 = ringX[h][i], y00 = ringY[h][i], z00 = ringZ[h][i];
             float x01 = ringX[h][i + 1], y01 = ringY[h][i + 1], z01 = ringZ[h][i + 1];
@@ -1185,45 +1910,37 @@ PolarBuilder& PolarBuilder::buildCylinderDiscreteInternal(GeometryBuffers& buffe
         }
     }
 
-    if (!isSecondCoat && m_doubleCoated)
+    if (!isSecondCoat && secondCoat())
     {
-        buildCylinderDiscreteInternal(buffers, true);
+        buildCylinderDiscreteInternal(buffers, ring, true);
     }
 
     return *this;
 }
-PolarBuilder& PolarBuilder::buildConeDiscreteIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat)
+PolarBuilder& PolarBuilder::buildConeDiscreteIndexedInternal(BuildSink& sink, const RingSamples& ring, bool isSecondCoat)
 {
-    using expresie_tokenizer::expression_token_compiler;
-    using expresie_tokenizer::expression;
-    expression_token_compiler compiler;
-
-    long double theta = 0.0L;
-
-    std::unique_ptr<expression> expr_r = compiler.compile(m_formula);
-    expr_r->bind(L"theta", &theta);
+    if (m_strips)
+        throw std::runtime_error("Triangle strips run over the shared vertices of a smooth build, edged builds have none to share");
+    const int sectors = ring.sectors;
 
     const float z_tip = m_reversed ? 0.0f : -1.0f;
     const float z_base = m_reversed ? -1.0f : 0.0f;
 
-    float domainRange = m_domainEnd - m_domainStart;
 
     // Precompute ring positions (ring 0 is at tip, ring m_slices is at base)
-    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(m_sectors + 1));
-    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(m_sectors + 1));
+    std::vector<std::vector<float>> ringX(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringY(m_slices + 1, std::vector<float>(sectors + 1));
+    std::vector<std::vector<float>> ringZ(m_slices + 1, std::vector<float>(sectors + 1));
 
     for (int h = 0; h <= m_slices; h++)
     {
         float scale = static_cast<float>(h) / m_slices;
         float z = z_tip + (z_base - z_tip) * scale;
 
-        for (int i = 0; i <= m_sectors; i++)
+        for (int i = 0; i <= sectors; i++)
         {
-            theta = m_domainStart + domainRange * i / m_sectors;
-
-            float x = static_cast<float>(expr_r->cyl_x(theta)) * scale;
-            float y = static_cast<float>(expr_r->cyl_y(theta)) * scale;
+            float x = static_cast<float>(ring.r[i] * ring.cos[i]) * scale;
+            float y = static_cast<float>(ring.r[i] * ring.sin[i]) * scale;
 
             ringX[h][i] = x;
             ringY[h][i] = y;
@@ -1233,22 +1950,19 @@ PolarBuilder& PolarBuilder::buildConeDiscreteIndexedInternal(GeometryBuffers& bu
 
     const std::array<float, 4>& c = isSecondCoat ? m_color_inner : m_color_outer;
 
-    auto addVertex = [&](float x, float y, float z, float nx, float ny, float nz, float u, float v) -> uint32_t {
-        uint32_t idx = static_cast<uint32_t>(buffers.verts.size() / 3);
-        buffers.verts.insert(buffers.verts.end(), { x, y, z });
-        buffers.norms.insert(buffers.norms.end(), { nx, ny, nz });
-        buffers.texCoords.insert(buffers.texCoords.end(), { u, v });
-        buffers.colors.insert(buffers.colors.end(), { c[0], c[1], c[2], c[3] });
-        return idx;
-        };
+    // Three vertices and indices per tip triangle, then six per quad
+    const size_t tipSize = static_cast<size_t>(sectors) * 3;
+    const size_t sliceSize = static_cast<size_t>(sectors) * 6;
+    BuildWindow out(sink, tipSize + (m_slices - 1) * sliceSize, tipSize + (m_slices - 1) * sliceSize, c);
+    BuildWindow::Cursor tip = out.at(0, 0);
 
     // Tip triangles (h=0 ring is at the tip, all vertices collapse to origin)
     float tipX = 0.0f, tipY = 0.0f, tipZ = z_tip;
 
-    for (int i = 0; i < m_sectors; i++)
+    for (int i = 0; i < sectors; i++)
     {
-        float u0 = static_cast<float>(i) / m_sectors;
-        float u1 = static_cast<float>(i + 1) / m_sectors;
+        float u0 = ring.u[i];
+        float u1 = ring.u[i + 1];
 
         // First ring vertices
         float x0 = ringX[1][i], y0 = ringY[1][i], z0 = ringZ[1][i];
@@ -1259,35 +1973,37 @@ PolarBuilder& PolarBuilder::buildConeDiscreteIndexedInternal(GeometryBuffers& bu
         if (!isSecondCoat)
         {
             crossProductNormalLefthanded(tipX, tipY, tipZ, x0, y0, z0, x1, y1, z1, nx, ny, nz, false);
-            uint32_t i0 = addVertex(tipX, tipY, tipZ, nx, ny, nz, 0.5f, 0.0f);
-            uint32_t i1 = addVertex(x0, y0, z0, nx, ny, nz, u0, 1.0f / m_slices);
-            uint32_t i2 = addVertex(x1, y1, z1, nx, ny, nz, u1, 1.0f / m_slices);
-            buffers.indices.push_back(i0);
-            buffers.indices.push_back(i1);
-            buffers.indices.push_back(i2);
+            uint32_t i0 = tip.addVertex(tipX, tipY, tipZ, nx, ny, nz, 0.5f, 0.0f);
+            uint32_t i1 = tip.addVertex(x0, y0, z0, nx, ny, nz, u0, 1.0f / m_slices);
+            uint32_t i2 = tip.addVertex(x1, y1, z1, nx, ny, nz, u1, 1.0f / m_slices);
+            tip.addIndex(i0);
+            tip.addIndex(i1);
+            tip.addIndex(i2);
         }
         else
         {
             crossProductNormalLefthanded(tipX, tipY, tipZ, x1, y1, z1, x0, y0, z0, nx, ny, nz, false);
-            uint32_t i0 = addVertex(tipX, tipY, tipZ, nx, ny, nz, 0.5f, 0.0f);
-            uint32_t i1 = addVertex(x1, y1, z1, nx, ny, nz, u1, 1.0f / m_slices);
-            uint32_t i2 = addVertex(x0, y0, z0, nx, ny, nz, u0, 1.0f / m_slices);
-            buffers.indices.push_back(i0);
-            buffers.indices.push_back(i1);
-            buffers.indices.push_back(i2);
+            uint32_t i0 = tip.addVertex(tipX, tipY, tipZ, nx, ny, nz, 0.5f, 0.0f);
+            uint32_t i1 = tip.addVertex(x1, y1, z1, nx, ny, nz, u1, 1.0f / m_slices);
+            uint32_t i2 = tip.addVertex(x0, y0, z0, nx, ny, nz, u0, 1.0f / m_slices);
+            tip.addIndex(i0);
+            tip.addIndex(i1);
+            tip.addIndex(i2);
         }
     }
 
     // Remaining quads (from ring 1 to ring m_slices)
-    for (int h = 1; h < m_slices; h++)
+    forEachSliceRange(threadCount(), 1, m_slices, sliceSize, [&](int hBegin, int hEnd) {
+    for (int h = hBegin; h < hEnd; h++)
     {
         float v0 = static_cast<float>(h) / m_slices;
         float v1 = static_cast<float>(h + 1) / m_slices;
+        BuildWindow::Cursor at = out.at(tipSize + (h - 1) * sliceSize, tipSize + (h - 1) * sliceSize);
 
-        for (int i = 0; i < m_sectors; i++)
+        for (int i = 0; i < sectors; i++)
         {
-            float u0 = static_cast<float>(i) / m_sectors;
-            float u1 = static_cast<float>(i + 1) / m_sectors;
+            float u0 = ring.u[i];
+            float u1 = ring.u[i + 1];
 
             // Quad corners
             float x00 = ringX[h][i], y00 = ringY[h][i], z00 = ringZ[h][i];
@@ -1300,22 +2016,22 @@ PolarBuilder& PolarBuilder::buildConeDiscreteIndexedInternal(GeometryBuffers& bu
             if (!isSecondCoat)
             {
                 crossProductNormalLefthanded(x00, y00, z00, x10, y10, z10, x01, y01, z01, nx1, ny1, nz1, false);
-                uint32_t i0 = addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
-                uint32_t i1 = addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
-                uint32_t i2 = addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
+                uint32_t i1 = at.addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
+                uint32_t i2 = at.addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
             else
             {
                 crossProductNormalLefthanded(x00, y00, z00, x01, y01, z01, x10, y10, z10, nx1, ny1, nz1, false);
-                uint32_t i0 = addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
-                uint32_t i1 = addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
-                uint32_t i2 = addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x00, y00, z00, nx1, ny1, nz1, u0, v0);
+                uint32_t i1 = at.addVertex(x01, y01, z01, nx1, ny1, nz1, u1, v0);
+                uint32_t i2 = at.addVertex(x10, y10, z10, nx1, ny1, nz1, u0, v1);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
 
             // Triangle 2
@@ -1323,29 +2039,30 @@ PolarBuilder& PolarBuilder::buildConeDiscreteIndexedInternal(GeometryBuffers& bu
             if (!isSecondCoat)
             {
                 crossProductNormalLefthanded(x01, y01, z01, x10, y10, z10, x11, y11, z11, nx2, ny2, nz2, false);
-                uint32_t i0 = addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
-                uint32_t i1 = addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
-                uint32_t i2 = addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
+                uint32_t i1 = at.addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
+                uint32_t i2 = at.addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
             else
             {
                 crossProductNormalLefthanded(x01, y01, z01, x11, y11, z11, x10, y10, z10, nx2, ny2, nz2, false);
-                uint32_t i0 = addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
-                uint32_t i1 = addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
-                uint32_t i2 = addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
-                buffers.indices.push_back(i0);
-                buffers.indices.push_back(i1);
-                buffers.indices.push_back(i2);
+                uint32_t i0 = at.addVertex(x01, y01, z01, nx2, ny2, nz2, u1, v0);
+                uint32_t i1 = at.addVertex(x11, y11, z11, nx2, ny2, nz2, u1, v1);
+                uint32_t i2 = at.addVertex(x10, y10, z10, nx2, ny2, nz2, u0, v1);
+                at.addIndex(i0);
+                at.addIndex(i1);
+                at.addIndex(i2);
             }
         }
     }
+    });
 
-    if (!isSecondCoat && m_doubleCoated)
+    if (!isSecondCoat && secondCoat())
     {
-        buildConeDiscreteIndexedInternal(buffers, true);
+        buildConeDiscreteIndexedInternal(sink, ring, true);
     }
 
     return *this;
@@ -1354,33 +2071,616 @@ PolarBuilder& PolarBuilder::buildConeIndexed(std::vector<float>& verts, std::vec
 {
     std::vector<float> colors;
     GeometryBuffers buffers(verts, norms, texCoords, colors, indices);
-    return buildConeIndexedInternal(buffers, false);
+    RingSamples ring;
+    sampleSectors(ring, true);
+    BuildSink sink(buffers, planIndexed(true, true, m_strips, ring.sectors), true, false);
+    size_t firstVertex = verts.size() / 3, firstIndex = indices.size();
+    buildConeIndexedInternal(sink, ring, m_strips, false);
+    return finishIndexed(buffers, firstVertex, firstIndex);
 }
 
 PolarBuilder& PolarBuilder::buildConeIndexedWithColor(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& colors, std::vector<uint32_t>& indices)
 {
     std::vector<float> texCoords;
     GeometryBuffers buffers(verts, norms, texCoords, colors, indices);
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    BuildSink sink(buffers, planIndexed(true, m_smooth, m_strips, ring.sectors), false, true);
+    size_t firstVertex = verts.size() / 3, firstIndex = indices.size();
     if (!m_smooth)
-        return buildConeDiscreteIndexedInternal(buffers, false);
-    return buildConeIndexedInternal(buffers, false);
+        buildConeDiscreteIndexedInternal(sink, ring, false);
+    else
+        buildConeIndexedInternal(sink, ring, m_strips, false);
+    return finishIndexed(buffers, firstVertex, firstIndex);
 }
 PolarBuilder& PolarBuilder::buildCylinderIndexed(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& texCoords, std::vector<uint32_t>& indices)
 {
     std::vector<float> colors;
     GeometryBuffers buffers(verts, norms, texCoords, colors, indices);
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    BuildSink sink(buffers, planIndexed(false, m_smooth, m_strips, ring.sectors), true, false);
+    size_t firstVertex = verts.size() / 3, firstIndex = indices.size();
     if (!m_smooth)
-        return buildCylinderDiscreteIndexedInternal(buffers, false);
-    return buildCylinderIndexedInternal(buffers, false);
+        buildCylinderDiscreteIndexedInternal(sink, ring, false);
+    else
+        buildCylinderIndexedInternal(sink, ring, m_strips, false);
+    return finishIndexed(buffers, firstVertex, firstIndex);
 }
 
 PolarBuilder& PolarBuilder::buildCylinderIndexedWithColor(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& colors, std::vector<uint32_t>& indices)
 {
     std::vector<float> texCoords;
     GeometryBuffers buffers(verts, norms, texCoords, colors, indices);
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    BuildSink sink(buffers, planIndexed(false, m_smooth, m_strips, ring.sectors), false, true);
+    size_t firstVertex = verts.size() / 3, firstIndex = indices.size();
+    if (!m_smooth)
+        buildCylinderDiscreteIndexedInternal(sink, ring, false);
+    else
+        buildCylinderIndexedInternal(sink, ring, m_strips, false);
+    return finishIndexed(buffers, firstVertex, firstIndex);
+}
+
+// ============================================================================
+// VERTEX CACHE AND FETCH ORDER
+// ============================================================================
+
+// Reorders count indices from firstIndex, all of the vertexCount vertices from
+// firstVertex, for the vertex cache
+static void orderForCache(std::vector<uint32_t>& indices, size_t firstIndex, size_t count, size_t firstVertex, size_t vertexCount,
+    meshopt::MeshStats& stats)
+{
+    uint32_t* range = indices.data() + firstIndex;
+    std::vector<uint32_t> local(range, range + count);
+    for (uint32_t& index : local)
+        index -= static_cast<uint32_t>(firstVertex);
+
+    stats.verticesBefore = stats.verticesAfter = vertexCount;
+    stats.acmrBefore = meshopt::acmr(local, vertexCount);
+    meshopt::optimizeVertexCache(local, vertexCount);
+    stats.acmrAfter = meshopt::acmr(local, vertexCount);
+
+    for (size_t i = 0; i < count; i++)
+        range[i] = local[i] + static_cast<uint32_t>(firstVertex);
+}
+
+// Reorders the triangles appended from firstIndex for the vertex cache, then the
+// vertexCount vertices appended from firstVertex in the order they are first used
+static void optimizeAppended(std::vector<uint32_t>& indices, size_t firstIndex, size_t firstVertex, size_t vertexCount,
+    const std::vector<meshopt::VertexStream>& streams, meshopt::MeshStats& stats)
+{
+    size_t count = indices.size() - firstIndex;
+    orderForCache(indices, firstIndex, count, firstVertex, vertexCount, stats);
+    meshopt::optimizeVertexFetch(indices.data() + firstIndex, count, firstVertex, vertexCount, streams);
+}
+
+PolarBuilder& PolarBuilder::finishIndexed(GeometryBuffers& buffers, size_t firstVertex, size_t firstIndex)
+{
+    // strips keep their ring order, the cache pass reorders triangle lists
+    if (!m_optimized || m_strips || buffers.indices.size() == firstIndex)
+        return *this;
+
+    // the throwaway texCoords / colors vector of the overload stays empty
+    std::vector<meshopt::VertexStream> streams = { { &buffers.verts, 3 }, { &buffers.norms, 3 } };
+    if (!buffers.texCoords.empty())
+        streams.push_back({ &buffers.texCoords, 2 });
+    if (!buffers.colors.empty())
+        streams.push_back({ &buffers.colors, 4 });
+    optimizeAppended(buffers.indices, firstIndex, firstVertex, buffers.verts.size() / 3 - firstVertex, streams, m_optimizationStats);
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::finishInterleaved(InterleavedGeometry& out, size_t firstVertex, size_t firstIndex)
+{
+    if (!m_optimized || m_strips || out.indices.size() == firstIndex)
+        return *this;
+
+    // a record is one stream of stride floats
+    std::vector<meshopt::VertexStream> streams = { { &out.data, out.layout.stride } };
+    optimizeAppended(out.indices, firstIndex, firstVertex, out.vertexCount() - firstVertex, streams, m_optimizationStats);
+    return *this;
+}
+
+// ============================================================================
+// PLANNING AND CALLER OWNED OUTPUT
+// ============================================================================
+
+// A build samples its ring once: the plan, both coats and the levels of detail
+// all take the sectors kept from it
+void PolarBuilder::sampleSectors(RingSamples& ring, bool withDerivative) const
+{
+    RingFormula formula(m_formula, m_compiledFormula);
+    float domainRange = m_domainEnd - m_domainStart;
+    sampleRing(formula, withDerivative, m_domainStart, domainRange, m_sectors, m_tolerance, ring);
+}
+
+int PolarBuilder::sectorCount() const
+{
+    if (m_tolerance <= 0 || m_sectors < 2)
+        return m_sectors;
+    // the ring the builds will sample, without the geometry
+    RingSamples ring;
+    sampleSectors(ring, false);
+    return ring.sectors;
+}
+
+BuildPlan PolarBuilder::planIndexed(bool cone, bool smooth, bool strips, int sectorsKept) const
+{
+    BuildPlan plan;
+    if (m_sectors < 1 || m_slices < 1)
+        return plan;
+
+    size_t sectors = static_cast<size_t>(sectorsKept);
+    size_t slices = static_cast<size_t>(m_slices);
+    if (smooth && strips)
+    {
+        // one band per slice, the cone's tip fan being its first; the coat winding
+        // (p0, p1, c0), the cone's second and the cylinder's first, is one index longer
+        plan.vertices = cone ? 1 + slices * (sectors + 1) : (slices + 1) * (sectors + 1);
+        plan.indices = slices * stripBandIndices(sectors + 1, !cone);
+        if (secondCoat())
+        {
+            plan.vertices *= 2;
+            plan.indices += slices * stripBandIndices(sectors + 1, cone);
+        }
+        return plan;
+    }
+
+    if (cone && smooth)
+    {
+        // tip vertex and one ring per slice; tip fan, then a quad strip per slice
+        plan.vertices = 1 + slices * (sectors + 1);
+        plan.indices = sectors * 3 + (slices - 1) * sectors * 6;
+    }
+    else if (cone)
+    {
+        // every triangle has its own three vertices
+        plan.vertices = plan.indices = sectors * 3 + (slices - 1) * sectors * 6;
+    }
+    else if (smooth)
+    {
+        plan.vertices = (slices + 1) * (sectors + 1);
+        plan.indices = slices * sectors * 6;
+    }
+    else
+    {
+        plan.vertices = plan.indices = slices * sectors * 6;
+    }
+
+    if (secondCoat())
+    {
+        plan.vertices *= 2;
+        plan.indices *= 2;
+    }
+    return plan;
+}
+
+BuildPlan PolarBuilder::planCone() const
+{
+    return planIndexed(true, m_smooth, m_strips, sectorCount());
+}
+
+BuildPlan PolarBuilder::planCylinder() const
+{
+    return planIndexed(false, m_smooth, m_strips, sectorCount());
+}
+
+static void checkSpans(const GeometrySpans& out, const BuildPlan& plan)
+{
+    if (out.vertexCapacity < plan.vertices || out.indexCapacity < plan.indices)
+        throw std::runtime_error("GeometrySpans smaller than the build plan: "
+            + std::to_string(plan.vertices) + " vertices and " + std::to_string(plan.indices) + " indices needed");
+    if (!out.indices && plan.indices)
+        throw std::runtime_error("GeometrySpans without an index array");
+}
+
+PolarBuilder& PolarBuilder::buildIndexed(bool cone, const GeometrySpans& out, const RingSamples& ring)
+{
+    checkSpans(out, planIndexed(cone, m_smooth, m_strips, ring.sectors));
+    BuildSink sink(out);
+    if (cone)
+        return m_smooth ? buildConeIndexedInternal(sink, ring, m_strips, false) : buildConeDiscreteIndexedInternal(sink, ring, false);
+    return m_smooth ? buildCylinderIndexedInternal(sink, ring, m_strips, false) : buildCylinderDiscreteIndexedInternal(sink, ring, false);
+}
+
+PolarBuilder& PolarBuilder::buildConeIndexed(const GeometrySpans& out)
+{
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    return buildIndexed(true, out, ring);
+}
+
+PolarBuilder& PolarBuilder::buildCylinderIndexed(const GeometrySpans& out)
+{
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    return buildIndexed(false, out, ring);
+}
+
+// Grows the stream by a plan and points the spans at the new records
+static GeometrySpans interleavedSpans(InterleavedGeometry& out, const BuildPlan& plan)
+{
+    const InterleavedLayout& layout = out.layout;
+    if (layout.stride < 3 || layout.vertex < 0)
+        throw std::runtime_error("InterleavedLayout without vertex positions");
+
+    size_t first = out.vertexCount();
+    size_t firstIndex = out.indices.size();
+    out.data.resize((first + plan.vertices) * layout.stride);
+    out.indices.resize(firstIndex + plan.indices);
+
+    float* record = out.data.data() + first * layout.stride;
+    GeometrySpans spans;
+    spans.verts = record + layout.vertex;
+    spans.norms = layout.normal >= 0 ? record + layout.normal : nullptr;
+    spans.texCoords = layout.texCoord >= 0 ? record + layout.texCoord : nullptr;
+    spans.colors = layout.color >= 0 ? record + layout.color : nullptr;
+    spans.indices = out.indices.data() + firstIndex;
+    spans.vertexCapacity = plan.vertices;
+    spans.indexCapacity = plan.indices;
+    spans.baseVertex = static_cast<uint32_t>(first);
+    spans.stride = layout.stride;
+    return spans;
+}
+
+PolarBuilder& PolarBuilder::buildConeInterleaved(InterleavedGeometry& out)
+{
+    size_t firstVertex = out.vertexCount(), firstIndex = out.indices.size();
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    buildIndexed(true, interleavedSpans(out, planIndexed(true, m_smooth, m_strips, ring.sectors)), ring);
+    return finishInterleaved(out, firstVertex, firstIndex);
+}
+
+PolarBuilder& PolarBuilder::buildCylinderInterleaved(InterleavedGeometry& out)
+{
+    size_t firstVertex = out.vertexCount(), firstIndex = out.indices.size();
+    RingSamples ring;
+    sampleSectors(ring, m_smooth);
+    buildIndexed(false, interleavedSpans(out, planIndexed(false, m_smooth, m_strips, ring.sectors)), ring);
+    return finishInterleaved(out, firstVertex, firstIndex);
+}
+
+// ============================================================================
+// QUANTIZED OUTPUT
+// ============================================================================
+
+std::array<float, 3> QuantizedLayout::scale() const
+{
+    return { (box.max[0] - box.min[0]) * 0.5f, (box.max[1] - box.min[1]) * 0.5f, (box.max[2] - box.min[2]) * 0.5f };
+}
+
+std::array<float, 3> QuantizedLayout::offset() const
+{
+    return { (box.max[0] + box.min[0]) * 0.5f, (box.max[1] + box.min[1]) * 0.5f, (box.max[2] + box.min[2]) * 0.5f };
+}
+
+// IEEE binary16, rounded to nearest; values under 2^-14 flush to zero, values
+// past 65504 become infinity
+static uint16_t halfFromFloat(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t magnitude = bits & 0x7fffffffu;
+    if (magnitude > 0x7f800000u)
+        return static_cast<uint16_t>(sign | 0x7e00u);   // NaN
+    if (magnitude < (113u << 23))
+        return static_cast<uint16_t>(sign);             // under the smallest normal half
+    // rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits
+    uint32_t half = (magnitude - (112u << 23) + (1u << 12)) >> 13;
+    if (half >= 0x7c00u)
+        half = 0x7c00u;
+    return static_cast<uint16_t>(sign | half);
+}
+
+static int16_t snorm16(float value)
+{
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return static_cast<int16_t>(std::lround(value * 32767.0f));
+}
+
+static uint8_t unorm8(float value)
+{
+    value = std::max(0.0f, std::min(1.0f, value));
+    return static_cast<uint8_t>(std::lround(value * 255.0f));
+}
+
+// Unit normal to the octahedron |x| + |y| + |z| = 1, the lower half folded over the
+// upper one, as two snorm16 (decoded by Dynamit's generated vertex shader)
+static void octahedral16(const float* normal, int16_t* out)
+{
+    float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    float u = length > 0.0f ? normal[0] / length : 0.0f;
+    float v = length > 0.0f ? normal[1] / length : 0.0f;
+    if (normal[2] < 0.0f)
+    {
+        float folded = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        v = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = folded;
+    }
+    out[0] = snorm16(u);
+    out[1] = snorm16(v);
+}
+
+// Bytes of one attribute in a format, padded to 4
+static int formatBytes(VertexFormat format, int components)
+{
+    switch (format)
+    {
+    case VertexFormat::None:         return 0;
+    case VertexFormat::Float32:      return components * 4;
+    case VertexFormat::Half:
+    case VertexFormat::Snorm16:      return (components * 2 + 3) & ~3;
+    case VertexFormat::Octahedral16: return 4;
+    case VertexFormat::Unorm8:       return 4;
+    }
+    return 0;
+}
+
+static void checkFormat(VertexFormat format, std::initializer_list<VertexFormat> allowed, int inputOffset, const char* attribute)
+{
+    if (std::find(allowed.begin(), allowed.end(), format) == allowed.end())
+        throw std::runtime_error(std::string("quantize: unsupported format for ") + attribute);
+    if (format != VertexFormat::None && inputOffset < 0)
+        throw std::runtime_error(std::string("quantize: the geometry has no ") + attribute);
+}
+
+void quantize(const InterleavedGeometry& geometry, QuantizedGeometry& out)
+{
+    const InterleavedLayout& in = geometry.layout;
+    QuantizedLayout& layout = out.layout;
+    const size_t count = geometry.vertexCount();
+
+    checkFormat(layout.position, { VertexFormat::Float32, VertexFormat::Half, VertexFormat::Snorm16 }, in.vertex, "positions");
+    checkFormat(layout.normal, { VertexFormat::None, VertexFormat::Float32, VertexFormat::Octahedral16 }, in.normal, "normals");
+    checkFormat(layout.texCoord, { VertexFormat::None, VertexFormat::Float32, VertexFormat::Half }, in.texCoord, "texCoords");
+    checkFormat(layout.color, { VertexFormat::None, VertexFormat::Float32, VertexFormat::Unorm8 }, in.color, "colors");
+
+    if (out.data.empty())
+    {
+        auto place = [&layout](VertexFormat format, int components) {
+            if (format == VertexFormat::None)
+                return -1;
+            int offset = layout.stride;
+            layout.stride += formatBytes(format, components);
+            return offset;
+        };
+        layout.stride = 0;
+        layout.vertexOffset = place(layout.position, 3);
+        layout.normalOffset = place(layout.normal, 3);
+        layout.texCoordOffset = place(layout.texCoord, 2);
+        layout.colorOffset = place(layout.color, 4);
+
+        if (layout.position == VertexFormat::Snorm16 && !layout.fixedBox && count > 0)
+        {
+            const float* first = geometry.data.data() + in.vertex;
+            for (int c = 0; c < 3; c++)
+                layout.box.min[c] = layout.box.max[c] = first[c];
+            for (size_t v = 1; v < count; v++)
+            {
+                const float* position = geometry.data.data() + v * in.stride + in.vertex;
+                for (int c = 0; c < 3; c++)
+                {
+                    layout.box.min[c] = std::min(layout.box.min[c], position[c]);
+                    layout.box.max[c] = std::max(layout.box.max[c], position[c]);
+                }
+            }
+        }
+    }
+
+    const std::array<float, 3> scale = layout.scale();
+    const std::array<float, 3> offset = layout.offset();
+    const size_t firstVertex = out.vertexCount();
+    out.data.resize((firstVertex + count) * layout.stride);
+
+    for (size_t v = 0; v < count; v++)
+    {
+        const float* record = geometry.data.data() + v * in.stride;
+        uint8_t* packed = out.data.data() + (firstVertex + v) * layout.stride;
+
+        const float* position = record + in.vertex;
+        uint8_t* target = packed + layout.vertexOffset;
+        if (layout.position == VertexFormat::Float32)
+            std::memcpy(target, position, 3 * sizeof(float));
+        else if (layout.position == VertexFormat::Half)
+        {
+            uint16_t half[4] = { halfFromFloat(position[0]), halfFromFloat(position[1]), halfFromFloat(position[2]), 0 };
+            std::memcpy(target, half, sizeof(half));
+        }
+        else
+        {
+            int16_t stored[4] = {};
+            for (int c = 0; c < 3; c++)
+            {
+                float slack = 1e-5f * std::max(1.0f, std::fabs(scale[c]) + std::fabs(offset[c]));
+                if (position[c] < layout.box.min[c] - slack || position[c] > layout.box.max[c] + slack)
+                    throw std::runtime_error("quantize: position outside the quantization box, set layout.box and fixedBox");
+                stored[c] = scale[c] > 0.0f ? snorm16((position[c] - offset[c]) / scale[c]) : 0;
+            }
+            std::memcpy(target, stored, sizeof(stored));
+        }
+
+        if (layout.normal == VertexFormat::Float32)
+            std::memcpy(packed + layout.normalOffset, record + in.normal, 3 * sizeof(float));
+        else if (layout.normal == VertexFormat::Octahedral16)
+        {
+            int16_t stored[2];
+            octahedral16(record + in.normal, stored);
+            std::memcpy(packed + layout.normalOffset, stored, sizeof(stored));
+        }
+
+        if (layout.texCoord == VertexFormat::Float32)
+            std::memcpy(packed + layout.texCoordOffset, record + in.texCoord, 2 * sizeof(float));
+        else if (layout.texCoord == VertexFormat::Half)
+        {
+            uint16_t half[2] = { halfFromFloat(record[in.texCoord]), halfFromFloat(record[in.texCoord + 1]) };
+            std::memcpy(packed + layout.texCoordOffset, half, sizeof(half));
+        }
+
+        if (layout.color == VertexFormat::Float32)
+            std::memcpy(packed + layout.colorOffset, record + in.color, 4 * sizeof(float));
+        else if (layout.color == VertexFormat::Unorm8)
+        {
+            for (int c = 0; c < 4; c++)
+                packed[layout.colorOffset + c] = unorm8(record[in.color + c]);
+        }
+    }
+
+    out.indices.reserve(out.indices.size() + geometry.indices.size());
+    for (uint32_t index : geometry.indices)
+        out.indices.push_back(index == RestartIndex ? index : index + static_cast<uint32_t>(firstVertex));
+}
+
+// The float stream a quantized build packs from
+static InterleavedLayout interleavedFor(const QuantizedLayout& layout)
+{
+    return InterleavedLayout::of(layout.normal != VertexFormat::None, layout.texCoord != VertexFormat::None,
+        layout.color != VertexFormat::None);
+}
+
+PolarBuilder& PolarBuilder::buildConeQuantized(QuantizedGeometry& out)
+{
+    InterleavedGeometry built;
+    built.layout = interleavedFor(out.layout);
+    buildConeInterleaved(built);
+    quantize(built, out);
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::buildCylinderQuantized(QuantizedGeometry& out)
+{
+    InterleavedGeometry built;
+    built.layout = interleavedFor(out.layout);
+    buildCylinderInterleaved(built);
+    quantize(built, out);
+    return *this;
+}
+
+// ============================================================================
+// LEVELS OF DETAIL
+// ============================================================================
+
+// Indices of one coat at every step-th sector and ring of the smooth grid starting
+// at base, wound as buildConeIndexedInternal / buildCylinderIndexedInternal wind it,
+// as lists or as strips
+static void appendLodIndices(std::vector<uint32_t>& indices, bool cone, bool isSecondCoat, bool strips,
+    uint32_t base, int sectors, int slices, int step)
+{
+    const uint32_t ringSize = static_cast<uint32_t>(sectors) + 1;
+    // cone: tip at 0, ring h (1..slices) at 1 + (h - 1) * ringSize; cylinder: ring h (0..slices) at h * ringSize
+    auto ring = [&](int h) { return base + (cone ? 1 + (h - 1) * ringSize : h * ringSize); };
+
+    // the cone's quads wind as the cylinder's second coat
+    bool coneWinding = cone != isSecondCoat;
+    if (strips)
+    {
+        auto add = [&](uint32_t index) { indices.push_back(index); };
+        const size_t count = static_cast<size_t>(sectors / step) + 1;
+        const uint32_t stride = static_cast<uint32_t>(step);
+        if (cone)
+            addStripBand(add, count, !coneWinding, [&](size_t) { return base; },
+                [&](size_t i) { return ring(step) + static_cast<uint32_t>(i) * stride; });
+        for (int h = cone ? step : 0; h + step <= slices; h += step)
+            addStripBand(add, count, !coneWinding, [&](size_t i) { return ring(h) + static_cast<uint32_t>(i) * stride; },
+                [&](size_t i) { return ring(h + step) + static_cast<uint32_t>(i) * stride; });
+        return;
+    }
+
+    int firstRing = 0;
+    if (cone)
+    {
+        uint32_t r = ring(step);
+        for (int i = 0; i < sectors; i += step)
+        {
+            uint32_t a = r + i, b = r + i + step;
+            indices.insert(indices.end(), { base, isSecondCoat ? b : a, isSecondCoat ? a : b });
+        }
+        firstRing = step;
+    }
+
+    for (int h = firstRing; h + step <= slices; h += step)
+    {
+        uint32_t prev = ring(h);
+        uint32_t curr = ring(h + step);
+        for (int i = 0; i < sectors; i += step)
+        {
+            uint32_t v00 = prev + i, v01 = prev + i + step;
+            uint32_t v10 = curr + i, v11 = curr + i + step;
+            if (coneWinding)
+                indices.insert(indices.end(), { v00, v10, v01, v01, v10, v11 });
+            else
+                indices.insert(indices.end(), { v00, v01, v10, v01, v11, v10 });
+        }
+    }
+}
+
+PolarBuilder& PolarBuilder::buildLods(bool cone, InterleavedGeometry& out, std::vector<LodRange>& lods, int levels)
+{
     if (!m_smooth)
-        return buildCylinderDiscreteIndexedInternal(buffers, false);
-    return buildCylinderIndexedInternal(buffers, false);
+        throw std::runtime_error("Levels of detail share the vertices of a smooth build, edged builds have none to share");
+
+    RingSamples ring;
+    sampleSectors(ring, true);
+    const int sectors = ring.sectors;
+    BuildPlan plan = planIndexed(cone, true, m_strips, sectors);
+    size_t firstVertex = out.vertexCount();
+    size_t firstIndex = out.indices.size();
+    // every level has about a quarter of the indices of the one before
+    out.indices.reserve(firstIndex + plan.indices + plan.indices / 3 + 64);
+    // the grid is built in its own order, the levels below index into it
+    buildIndexed(cone, interleavedSpans(out, plan), ring);
+
+    const size_t firstLod = lods.size();
+    LodRange finest;
+    finest.firstIndex = firstIndex;
+    finest.indexCount = out.indices.size() - firstIndex;
+    finest.sectors = sectors;
+    finest.slices = m_slices;
+    lods.push_back(finest);
+
+    const int coats = secondCoat() ? 2 : 1;
+    const size_t coatVertices = plan.vertices / coats;
+    for (int level = 1; level < levels; level++)
+    {
+        int step = 1 << level;
+        if (sectors % step != 0 || m_slices % step != 0 || sectors / step < 3)
+            break;
+
+        LodRange lod;
+        lod.firstIndex = out.indices.size();
+        lod.sectors = sectors / step;
+        lod.slices = m_slices / step;
+        for (int coat = 0; coat < coats; coat++)
+            appendLodIndices(out.indices, cone, coat == 1, m_strips,
+                static_cast<uint32_t>(firstVertex + coat * coatVertices), sectors, m_slices, step);
+        lod.indexCount = out.indices.size() - lod.firstIndex;
+        lods.push_back(lod);
+    }
+
+    if (m_optimized && !m_strips)
+    {
+        // every level in cache order on its own, then one vertex order for all,
+        // first use by the finest level
+        const size_t vertexCount = out.vertexCount() - firstVertex;
+        for (size_t l = lods.size(); l-- > firstLod;)
+            orderForCache(out.indices, lods[l].firstIndex, lods[l].indexCount, firstVertex, vertexCount, m_optimizationStats);
+        std::vector<meshopt::VertexStream> streams = { { &out.data, out.layout.stride } };
+        meshopt::optimizeVertexFetch(out.indices.data() + firstIndex, out.indices.size() - firstIndex, firstVertex, vertexCount, streams);
+    }
+    return *this;
+}
+
+PolarBuilder& PolarBuilder::buildConeLods(InterleavedGeometry& out, std::vector<LodRange>& lods, int levels)
+{
+    return buildLods(true, out, lods, levels);
+}
+
+PolarBuilder& PolarBuilder::buildCylinderLods(InterleavedGeometry& out, std::vector<LodRange>& lods, int levels)
+{
+    return buildLods(false, out, lods, levels);
 }
 
 PolarBuilder& PolarBuilder::buildCone(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& texCoords)
@@ -1397,7 +2697,10 @@ PolarBuilder& PolarBuilder::buildCone(std::vector<float>& verts, std::vector<flo
     {
         std::vector<float> indexedVerts, indexedNorms, indexedTexCoords, indexedColors;
         GeometryBuffers buffers(indexedVerts, indexedNorms, indexedTexCoords, indexedColors, indices);
-        buildConeIndexedInternal(buffers, false);
+        RingSamples ring;
+        sampleSectors(ring, true);
+        BuildSink sink(buffers, planIndexed(true, true, false, ring.sectors), true, false);
+        buildConeIndexedInternal(sink, ring, false, false);
 
         size_t additionalSize = indices.size() * 3;
         verts.reserve(verts.size() + additionalSize);
@@ -1439,7 +2742,10 @@ PolarBuilder& PolarBuilder::buildCylinder(std::vector<float>& verts, std::vector
     {
         std::vector<float> indexedVerts, indexedNorms, indexedTexCoords, indexedColors;
         GeometryBuffers buffers(indexedVerts, indexedNorms, indexedTexCoords, indexedColors, indices);
-        buildCylinderIndexedInternal(buffers, false);
+        RingSamples ring;
+        sampleSectors(ring, true);
+        BuildSink sink(buffers, planIndexed(false, true, false, ring.sectors), true, false);
+        buildCylinderIndexedInternal(sink, ring, false, false);
 
         size_t additionalSize = indices.size() * 3;
         verts.reserve(verts.size() + additionalSize);
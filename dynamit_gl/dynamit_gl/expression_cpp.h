@@ -0,0 +1,168 @@
+#pragma once
+#ifndef __EXPRESSION_CPP_H__
+#define __EXPRESSION_CPP_H__
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace expresie_tokenizer
+{
+namespace cpp
+{
+//========================================
+// C++ spellings of the registry functions, for ahead-of-time export
+// A function without a definition is a <cmath> function; the others are
+// helpers written into the generated source ahead of the code that calls them.
+// Every spelling computes what the registry lambda for double computes,
+// so compiled code and eval() agree to the last bit where the tree is the same.
+//========================================
+struct function
+{
+	const char* name;
+	const char* definition;  // nullptr for <cmath> functions
+	bool is_constexpr;       // callable from a constexpr function
+};
+
+inline const function* find(const std::string& name)
+{
+	static const function table[] =
+	{
+		{ "std::sin", nullptr, false },
+		{ "std::cos", nullptr, false },
+		{ "std::tan", nullptr, false },
+		{ "std::sqrt", nullptr, false },
+		{ "std::exp", nullptr, false },
+		{ "std::log", nullptr, false },
+		{ "std::fabs", nullptr, false },
+		{ "std::asin", nullptr, false },
+		{ "std::acos", nullptr, false },
+		{ "std::atan", nullptr, false },
+		{ "std::sinh", nullptr, false },
+		{ "std::cosh", nullptr, false },
+		{ "std::tanh", nullptr, false },
+		{ "std::floor", nullptr, false },
+		{ "std::ceil", nullptr, false },
+		{ "std::round", nullptr, false },
+		{ "std::pow", nullptr, false },
+		{ "std::atan2", nullptr, false },
+		{ "std::fmod", nullptr, false },
+		{ "dyn_min", "constexpr double dyn_min(double a, double b) { return a < b ? a : b; }", true },
+		{ "dyn_max", "constexpr double dyn_max(double a, double b) { return a > b ? a : b; }", true },
+		// derivatives, matching the unary_deriv / binary_deriv lambdas of the registry
+		{ "dyn_d_cos", "inline double dyn_d_cos(double x) { return -std::sin(x); }", false },
+		{ "dyn_d_tan", "inline double dyn_d_tan(double x) { double c = std::cos(x); return 1.0 / (c * c); }", false },
+		{ "dyn_d_sqrt", "inline double dyn_d_sqrt(double x) { return 0.5 / std::sqrt(x); }", false },
+		{ "dyn_d_log", "constexpr double dyn_d_log(double x) { return 1.0 / x; }", true },
+		{ "dyn_d_abs", "constexpr double dyn_d_abs(double x) { return x >= 0 ? 1.0 : -1.0; }", true },
+		{ "dyn_d_asin", "inline double dyn_d_asin(double x) { return 1.0 / std::sqrt(1.0 - x * x); }", false },
+		{ "dyn_d_acos", "inline double dyn_d_acos(double x) { return -1.0 / std::sqrt(1.0 - x * x); }", false },
+		{ "dyn_d_atan", "constexpr double dyn_d_atan(double x) { return 1.0 / (1.0 + x * x); }", true },
+		{ "dyn_d_tanh", "inline double dyn_d_tanh(double x) { double t = std::tanh(x); return 1.0 - t * t; }", false },
+		{ "dyn_d_pow_a", "inline double dyn_d_pow_a(double a, double b) { return b * std::pow(a, b - 1.0); }", false },
+		{ "dyn_d_pow_b", "inline double dyn_d_pow_b(double a, double b) { return std::pow(a, b) * std::log(a); }", false },
+		{ "dyn_d_atan2_y", "constexpr double dyn_d_atan2_y(double y, double x) { return x / (x * x + y * y); }", true },
+		{ "dyn_d_atan2_x", "constexpr double dyn_d_atan2_x(double y, double x) { return -y / (x * x + y * y); }", true },
+	};
+	for (const function& f : table)
+		if (name == f.name)
+			return &f;
+	throw std::runtime_error("Unknown C++ function: " + name);
+}
+
+//========================================
+// Writer - collects what the emitted expression depends on:
+// helper definitions, the free variables, and whether everything it
+// calls is constexpr (so the generated function can be constexpr too)
+//========================================
+class writer
+{
+	std::vector<const function*> helpers_;
+	std::vector<std::string> variables_;
+	bool constexpr_ = true;
+
+public:
+	// Shortest double literal that reads back to the same double
+	std::string number(long double value)
+	{
+		double d = static_cast<double>(value);
+		if (std::isnan(d)) return "std::numeric_limits<double>::quiet_NaN()";
+		if (std::isinf(d)) return d > 0 ? "std::numeric_limits<double>::infinity()" : "(-std::numeric_limits<double>::infinity())";
+
+		std::string text;
+		for (int digits = 15; digits <= 17; digits++)
+		{
+			std::ostringstream oss;
+			oss.imbue(std::locale::classic());
+			oss << std::setprecision(digits) << std::fabs(d);
+			text = oss.str();
+			if (std::strtod(text.c_str(), nullptr) == std::fabs(d)) break;
+		}
+		if (text.find_first_of(".e") == std::string::npos) text += ".0";
+		else if (text.find('.') == std::string::npos) text.insert(text.find('e'), ".0");
+		return (d < 0) ? "(-" + text + ")" : text;
+	}
+
+	// Variables are case-insensitive in the engine, the lower case name is the C++ one
+	std::string variable(const std::wstring& name)
+	{
+		std::string id;
+		for (wchar_t c : name)
+		{
+			bool ok = (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || c == L'_' || (!id.empty() && c >= L'0' && c <= L'9');
+			if (!ok) throw std::runtime_error("Variable name is not a C++ identifier");
+			id += static_cast<char>((c >= L'A' && c <= L'Z') ? c - L'A' + L'a' : c);
+		}
+		if (id.compare(0, 4, "dyn_") == 0 || id[0] == '_')
+			throw std::runtime_error("Variable name is reserved in generated C++: " + id);
+		for (const std::string& v : variables_)
+			if (v == id) return id;
+		variables_.push_back(id);
+		return id;
+	}
+
+	std::string call(const function* f, const std::string& arg)
+	{
+		use(f);
+		return std::string(f->name) + "(" + arg + ")";
+	}
+
+	std::string call(const function* f, const std::string& arg1, const std::string& arg2)
+	{
+		use(f);
+		return std::string(f->name) + "(" + arg1 + ", " + arg2 + ")";
+	}
+
+	void use(const function* f)
+	{
+		if (!f->is_constexpr) constexpr_ = false;
+		if (!f->definition) return;
+		for (const function* h : helpers_)
+			if (h == f) return;
+		helpers_.push_back(f);
+	}
+
+	std::string helpers() const
+	{
+		std::string out;
+		for (const function* h : helpers_)
+			out += std::string(h->definition) + "\n";
+		return out;
+	}
+
+	const std::vector<std::string>& variables() const { return variables_; }
+
+	// Whether everything called since begin_function() is constexpr
+	void begin_function() { constexpr_ = true; }
+	bool is_constexpr() const { return constexpr_; }
+};
+
+} // namespace cpp
+} // namespace expresie_tokenizer
+#endif
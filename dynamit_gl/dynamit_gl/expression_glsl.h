@@ -0,0 +1,169 @@
+#pragma once
+#ifndef __EXPRESSION_GLSL_H__
+#define __EXPRESSION_GLSL_H__
+
+#include <cmath>
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace expresie_tokenizer
+{
+namespace glsl
+{
+//========================================
+// GLSL spellings of the registry functions
+// A function without a definition is a GLSL built-in; the others are
+// helpers written into the shader ahead of the code that calls them.
+// Helpers follow the C library, not the GLSL built-in of the same name:
+// round() halves away from zero, fmod() truncates, pow() takes negative bases.
+//========================================
+struct function
+{
+	const char* name;
+	const char* definition;  // nullptr for built-ins
+	const char* needs;       // helper the definition calls, nullptr if none
+};
+
+inline const function* find(const std::string& name)
+{
+	static const function table[] =
+	{
+		{ "sin", nullptr, nullptr },
+		{ "cos", nullptr, nullptr },
+		{ "tan", nullptr, nullptr },
+		{ "sqrt", nullptr, nullptr },
+		{ "exp", nullptr, nullptr },
+		{ "log", nullptr, nullptr },
+		{ "abs", nullptr, nullptr },
+		{ "asin", nullptr, nullptr },
+		{ "acos", nullptr, nullptr },
+		{ "atan", nullptr, nullptr },
+		{ "sinh", nullptr, nullptr },
+		{ "cosh", nullptr, nullptr },
+		{ "tanh", nullptr, nullptr },
+		{ "floor", nullptr, nullptr },
+		{ "ceil", nullptr, nullptr },
+		{ "min", nullptr, nullptr },
+		{ "max", nullptr, nullptr },
+		{ "dyn_round", "float dyn_round(float x) { return sign(x) * floor(abs(x) + 0.5); }", nullptr },
+		{ "dyn_fmod", "float dyn_fmod(float a, float b) { return a - b * trunc(a / b); }", nullptr },
+		{ "dyn_pow",
+			"float dyn_pow(float a, float b)\n"
+			"{\n"
+			"    if (a > 0.0) return pow(a, b);\n"
+			"    if (a == 0.0) return (b > 0.0) ? 0.0 : ((b == 0.0) ? 1.0 : uintBitsToFloat(0x7F800000u));\n"
+			"    if (b != floor(b)) return uintBitsToFloat(0x7FC00000u);\n"
+			"    float m = pow(-a, b);\n"
+			"    return (mod(b, 2.0) == 0.0) ? m : -m;\n"
+			"}", nullptr },
+		// derivatives, matching the unary_deriv / binary_deriv lambdas of the registry
+		{ "dyn_d_cos", "float dyn_d_cos(float x) { return -sin(x); }", nullptr },
+		{ "dyn_d_tan", "float dyn_d_tan(float x) { float c = cos(x); return 1.0 / (c * c); }", nullptr },
+		{ "dyn_d_sqrt", "float dyn_d_sqrt(float x) { return 0.5 / sqrt(x); }", nullptr },
+		{ "dyn_d_log", "float dyn_d_log(float x) { return 1.0 / x; }", nullptr },
+		{ "dyn_d_abs", "float dyn_d_abs(float x) { return (x >= 0.0) ? 1.0 : -1.0; }", nullptr },
+		{ "dyn_d_asin", "float dyn_d_asin(float x) { return 1.0 / sqrt(1.0 - x * x); }", nullptr },
+		{ "dyn_d_acos", "float dyn_d_acos(float x) { return -1.0 / sqrt(1.0 - x * x); }", nullptr },
+		{ "dyn_d_atan", "float dyn_d_atan(float x) { return 1.0 / (1.0 + x * x); }", nullptr },
+		{ "dyn_d_tanh", "float dyn_d_tanh(float x) { float t = tanh(x); return 1.0 - t * t; }", nullptr },
+		{ "dyn_d_pow_a", "float dyn_d_pow_a(float a, float b) { return b * dyn_pow(a, b - 1.0); }", "dyn_pow" },
+		{ "dyn_d_pow_b", "float dyn_d_pow_b(float a, float b) { return dyn_pow(a, b) * log(a); }", "dyn_pow" },
+		{ "dyn_d_atan2_y", "float dyn_d_atan2_y(float y, float x) { return x / (x * x + y * y); }", nullptr },
+		{ "dyn_d_atan2_x", "float dyn_d_atan2_x(float y, float x) { return -y / (x * x + y * y); }", nullptr },
+	};
+	for (const function& f : table)
+		if (name == f.name)
+			return &f;
+	throw std::runtime_error("Unknown GLSL function: " + name);
+}
+
+//========================================
+// Writer - collects what the emitted expression depends on:
+// helper definitions in dependency order and the free variables,
+// which the shader has to declare (usually as uniform float)
+//========================================
+class writer
+{
+	std::vector<const function*> helpers_;
+	std::vector<std::string> variables_;
+
+public:
+	// Shortest float literal that reads back to the same float
+	std::string number(long double value)
+	{
+		float f = static_cast<float>(value);
+		if (std::isnan(f)) return "uintBitsToFloat(0x7FC00000u)";
+		if (std::isinf(f)) return f > 0 ? "uintBitsToFloat(0x7F800000u)" : "uintBitsToFloat(0xFF800000u)";
+
+		std::string text;
+		for (int digits = 6; digits <= 9; digits++)
+		{
+			std::ostringstream oss;
+			oss.imbue(std::locale::classic());
+			oss << std::setprecision(digits) << std::fabs(f);
+			text = oss.str();
+			if (std::strtof(text.c_str(), nullptr) == std::fabs(f)) break;
+		}
+		if (text.find_first_of(".e") == std::string::npos) text += ".0";
+		else if (text.find('.') == std::string::npos) text.insert(text.find('e'), ".0");
+		return (f < 0) ? "(-" + text + ")" : text;
+	}
+
+	// Variables are case-insensitive in the engine, the lower case name is the GLSL one
+	std::string variable(const std::wstring& name)
+	{
+		std::string id;
+		for (wchar_t c : name)
+		{
+			bool ok = (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || c == L'_' || (!id.empty() && c >= L'0' && c <= L'9');
+			if (!ok) throw std::runtime_error("Variable name is not a GLSL identifier");
+			id += static_cast<char>((c >= L'A' && c <= L'Z') ? c - L'A' + L'a' : c);
+		}
+		if (id.compare(0, 3, "gl_") == 0 || id.compare(0, 4, "dyn_") == 0)
+			throw std::runtime_error("Variable name is reserved in GLSL: " + id);
+		for (const std::string& v : variables_)
+			if (v == id) return id;
+		variables_.push_back(id);
+		return id;
+	}
+
+	std::string call(const function* f, const std::string& arg)
+	{
+		use(f);
+		return std::string(f->name) + "(" + arg + ")";
+	}
+
+	std::string call(const function* f, const std::string& arg1, const std::string& arg2)
+	{
+		use(f);
+		return std::string(f->name) + "(" + arg1 + ", " + arg2 + ")";
+	}
+
+	void use(const function* f)
+	{
+		if (!f->definition) return;
+		for (const function* h : helpers_)
+			if (h == f) return;
+		if (f->needs) use(find(f->needs));
+		helpers_.push_back(f);
+	}
+
+	std::string helpers() const
+	{
+		std::string out;
+		for (const function* h : helpers_)
+			out += std::string(h->definition) + "\n";
+		return out;
+	}
+
+	const std::vector<std::string>& variables() const { return variables_; }
+};
+
+} // namespace glsl
+} // namespace expresie_tokenizer
+#endif
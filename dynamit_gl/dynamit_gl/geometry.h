@@ -1,8 +1,18 @@
 #pragma once
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <vector>
 
+// Vertex transform kernels: AVX (/arch:AVX, -mavx) 8 vertices a step, SSE (any x64) 4
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GEOMETRY_SIMD_AVX
+#elif defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GEOMETRY_SIMD_SSE
+#endif
+
 #if _MSVC_LANG  >= 201703L
 
 template<class T, class ... T0> void resize(const T& r, T0& ... ts) { ((ts *= r), ...); };
@@ -344,7 +354,278 @@ inline void transformNormal(const mat4<float>& m, float& nx, float& ny, float& n
         nz = tnz;
     }
 }
-//// Apply single transformation to a range of vertices and normals
+// One matrix doing what the transforms do in sequence, the first applied first
+template<typename... Transforms> inline mat4<float> composeTransforms(const Transforms&... transforms)
+{
+    mat4<float> m = identity_mat4<float>();
+    (multiply_mat4(transforms, m), ...);
+    return m;
+}
+
+// Inverse transpose of the upper 3x3 of m, the matrix normals take. Its columns are
+// the cross products of m's columns over the determinant. They are divided by
+// |det|^(2/3) instead, which is the square of a uniform scale: a uniformly scaled
+// unit normal stays unit length at any scale and passes the normalize threshold.
+// A flattening (singular) matrix keeps the cross products and still gives the
+// normals of the plane it flattens to.
+inline mat3<float> normalMatrix(const mat4<float>& m)
+{
+    const std::array<float, 3> c0 = { m[0], m[1], m[2] };
+    const std::array<float, 3> c1 = { m[4], m[5], m[6] };
+    const std::array<float, 3> c2 = { m[8], m[9], m[10] };
+    auto cross = [](const std::array<float, 3>& a, const std::array<float, 3>& b) {
+        return std::array<float, 3>{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    };
+    std::array<float, 3> n0 = cross(c1, c2), n1 = cross(c2, c0), n2 = cross(c0, c1);
+    float det = c0[0] * n0[0] + c0[1] * n0[1] + c0[2] * n0[2];
+    float s = det < 0.0f ? -1.0f : 1.0f;
+    if (det != 0.0f)
+    {
+        float scale = std::cbrt(std::fabs(det));
+        s /= scale * scale;
+    }
+    return { s * n0[0], s * n0[1], s * n0[2], s * n1[0], s * n1[1], s * n1[2], s * n2[0], s * n2[1], s * n2[2] };
+}
+
+namespace simd
+{
+// Lanes of floats, one vertex each, and the packed xyz <-> x, y, z shuffles
+#if defined(GEOMETRY_SIMD_AVX)
+typedef __m256 lanes;
+const size_t width = 8;
+
+inline lanes set1(float v)                     { return _mm256_set1_ps(v); }
+inline lanes load(const float* p)              { return _mm256_loadu_ps(p); }
+inline void  store(float* p, lanes a)          { _mm256_storeu_ps(p, a); }
+inline lanes add(lanes a, lanes b)             { return _mm256_add_ps(a, b); }
+inline lanes mul(lanes a, lanes b)             { return _mm256_mul_ps(a, b); }
+inline lanes div(lanes a, lanes b)             { return _mm256_div_ps(a, b); }
+inline lanes sqrt(lanes a)                     { return _mm256_sqrt_ps(a); }
+// a where len > min, b elsewhere
+inline lanes select_greater(lanes len, lanes min, lanes a, lanes b) { return _mm256_blendv_ps(b, a, _mm256_cmp_ps(len, min, _CMP_GT_OQ)); }
+#define GEOMETRY_SHUFFLE(a, b, imm) _mm256_shuffle_ps(a, b, imm)
+// 128-bit halves hold vertices 0-3 and 4-7, the shuffles work on each half
+inline lanes load_halves(const float* p)       { return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 12), 1); }
+inline void  store_halves(float* p, lanes a)   { _mm_storeu_ps(p, _mm256_castps256_ps128(a)); _mm_storeu_ps(p + 12, _mm256_extractf128_ps(a, 1)); }
+
+#elif defined(GEOMETRY_SIMD_SSE)
+typedef __m128 lanes;
+const size_t width = 4;
+
+inline lanes set1(float v)                     { return _mm_set1_ps(v); }
+inline lanes load(const float* p)              { return _mm_loadu_ps(p); }
+inline void  store(float* p, lanes a)          { _mm_storeu_ps(p, a); }
+inline lanes add(lanes a, lanes b)             { return _mm_add_ps(a, b); }
+inline lanes mul(lanes a, lanes b)             { return _mm_mul_ps(a, b); }
+inline lanes div(lanes a, lanes b)             { return _mm_div_ps(a, b); }
+inline lanes sqrt(lanes a)                     { return _mm_sqrt_ps(a); }
+inline lanes select_greater(lanes len, lanes min, lanes a, lanes b)
+{
+    lanes m = _mm_cmpgt_ps(len, min);
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+#define GEOMETRY_SHUFFLE(a, b, imm) _mm_shuffle_ps(a, b, imm)
+inline lanes load_halves(const float* p)       { return _mm_loadu_ps(p); }
+inline void  store_halves(float* p, lanes a)   { _mm_storeu_ps(p, a); }
+#endif
+
+#if defined(GEOMETRY_SIMD_AVX) || defined(GEOMETRY_SIMD_SSE)
+// width packed xyz triples into x, y, z: per 4 vertices a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+inline void load3(const float* p, lanes& x, lanes& y, lanes& z)
+{
+    lanes a = load_halves(p), b = load_halves(p + 4), c = load_halves(p + 8);
+    lanes xy23 = GEOMETRY_SHUFFLE(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    lanes yz01 = GEOMETRY_SHUFFLE(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+    x = GEOMETRY_SHUFFLE(a, xy23, _MM_SHUFFLE(2, 0, 3, 0));
+    y = GEOMETRY_SHUFFLE(yz01, xy23, _MM_SHUFFLE(3, 1, 2, 0));
+    z = GEOMETRY_SHUFFLE(yz01, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+inline void store3(float* p, lanes x, lanes y, lanes z)
+{
+    lanes xy = GEOMETRY_SHUFFLE(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+    lanes yz = GEOMETRY_SHUFFLE(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+    lanes zx = GEOMETRY_SHUFFLE(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+    store_halves(p, GEOMETRY_SHUFFLE(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+    store_halves(p + 4, GEOMETRY_SHUFFLE(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+    store_halves(p + 8, GEOMETRY_SHUFFLE(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// Matrix columns broadcast once per call
+struct transform_lanes
+{
+    lanes m[12];
+    lanes n[9];
+    lanes minLength = set1(0.0001f);
+
+    transform_lanes(const mat4<float>& pm, const mat3<float>& nm)
+    {
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 3; r++)
+                m[c * 3 + r] = set1(pm[c * 4 + r]);
+        for (int i = 0; i < 9; i++)
+            n[i] = set1(nm[i]);
+    }
+
+    void position(lanes& x, lanes& y, lanes& z) const
+    {
+        lanes tx = add(add(mul(m[0], x), mul(m[3], y)), add(mul(m[6], z), m[9]));
+        lanes ty = add(add(mul(m[1], x), mul(m[4], y)), add(mul(m[7], z), m[10]));
+        lanes tz = add(add(mul(m[2], x), mul(m[5], y)), add(mul(m[8], z), m[11]));
+        x = tx; y = ty; z = tz;
+    }
+
+    void normal(lanes& x, lanes& y, lanes& z) const
+    {
+        lanes tx = add(add(mul(n[0], x), mul(n[3], y)), mul(n[6], z));
+        lanes ty = add(add(mul(n[1], x), mul(n[4], y)), mul(n[7], z));
+        lanes tz = add(add(mul(n[2], x), mul(n[5], y)), mul(n[8], z));
+        lanes len = sqrt(add(add(mul(tx, tx), mul(ty, ty)), mul(tz, tz)));
+        x = select_greater(len, minLength, div(tx, len), tx);
+        y = select_greater(len, minLength, div(ty, len), ty);
+        z = select_greater(len, minLength, div(tz, len), tz);
+    }
+};
+#endif
+} // namespace simd
+
+// Normal by a normalMatrix, normalized as transformNormal does
+inline void transformNormalBy(const mat3<float>& n, float& nx, float& ny, float& nz)
+{
+    float tnx = n[0] * nx + n[3] * ny + n[6] * nz;
+    float tny = n[1] * nx + n[4] * ny + n[7] * nz;
+    float tnz = n[2] * nx + n[5] * ny + n[8] * nz;
+    float len = std::sqrt(tnx * tnx + tny * tny + tnz * tnz);
+    if (len > 0.0001f)
+    {
+        nx = tnx / len;
+        ny = tny / len;
+        nz = tnz / len;
+    }
+    else
+    {
+        nx = tnx;
+        ny = tny;
+        nz = tnz;
+    }
+}
+
+// Positions by m and normals by n = normalMatrix(m) in one pass over count packed
+// xyz triples of each array, width vertices a step; either array may be null
+inline void transformVertices(const mat4<float>& m, const mat3<float>& n, float* verts, float* norms, size_t count)
+{
+    size_t i = 0;
+#if defined(GEOMETRY_SIMD_AVX) || defined(GEOMETRY_SIMD_SSE)
+    const simd::transform_lanes t(m, n);
+    for (; i + simd::width <= count; i += simd::width)
+    {
+        simd::lanes x, y, z;
+        if (verts)
+        {
+            simd::load3(verts + i * 3, x, y, z);
+            t.position(x, y, z);
+            simd::store3(verts + i * 3, x, y, z);
+        }
+        if (norms)
+        {
+            simd::load3(norms + i * 3, x, y, z);
+            t.normal(x, y, z);
+            simd::store3(norms + i * 3, x, y, z);
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (verts)
+            transformPosition(m, verts[i * 3], verts[i * 3 + 1], verts[i * 3 + 2]);
+        if (norms)
+            transformNormalBy(n, norms[i * 3], norms[i * 3 + 1], norms[i * 3 + 2]);
+    }
+}
+
+// The same over separate x, y, z arrays (structure of arrays); nx, ny, nz may be null
+inline void transformVerticesSoA(const mat4<float>& m, const mat3<float>& n,
+    float* x, float* y, float* z, float* nx, float* ny, float* nz, size_t count)
+{
+    size_t i = 0;
+#if defined(GEOMETRY_SIMD_AVX) || defined(GEOMETRY_SIMD_SSE)
+    const simd::transform_lanes t(m, n);
+    for (; i + simd::width <= count; i += simd::width)
+    {
+        simd::lanes px = simd::load(x + i), py = simd::load(y + i), pz = simd::load(z + i);
+        t.position(px, py, pz);
+        simd::store(x + i, px); simd::store(y + i, py); simd::store(z + i, pz);
+        if (nx)
+        {
+            simd::lanes qx = simd::load(nx + i), qy = simd::load(ny + i), qz = simd::load(nz + i);
+            t.normal(qx, qy, qz);
+            simd::store(nx + i, qx); simd::store(ny + i, qy); simd::store(nz + i, qz);
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        transformPosition(m, x[i], y[i], z[i]);
+        if (nx)
+            transformNormalBy(n, nx[i], ny[i], nz[i]);
+    }
+}
+
+// The same over interleaved records of stride floats, position at vertexOffset and
+// normal at normalOffset (-1 for none), e.g. an InterleavedGeometry's data. Records
+// are gathered width at a time into lanes and scattered back after.
+inline void transformVerticesStrided(const mat4<float>& m, const mat3<float>& n,
+    float* data, size_t count, size_t stride, size_t vertexOffset, int normalOffset)
+{
+    size_t i = 0;
+#if defined(GEOMETRY_SIMD_AVX) || defined(GEOMETRY_SIMD_SSE)
+    const simd::transform_lanes t(m, n);
+    const int columns = normalOffset >= 0 ? 6 : 3;
+    float block[6][simd::width];
+    for (; i + simd::width <= count; i += simd::width)
+    {
+        for (size_t j = 0; j < simd::width; j++)
+        {
+            const float* record = data + (i + j) * stride;
+            for (int k = 0; k < 3; k++)
+                block[k][j] = record[vertexOffset + k];
+            for (int k = 3; k < columns; k++)
+                block[k][j] = record[normalOffset + k - 3];
+        }
+
+        simd::lanes x = simd::load(block[0]), y = simd::load(block[1]), z = simd::load(block[2]);
+        t.position(x, y, z);
+        simd::store(block[0], x); simd::store(block[1], y); simd::store(block[2], z);
+        if (normalOffset >= 0)
+        {
+            x = simd::load(block[3]); y = simd::load(block[4]); z = simd::load(block[5]);
+            t.normal(x, y, z);
+            simd::store(block[3], x); simd::store(block[4], y); simd::store(block[5], z);
+        }
+
+        for (size_t j = 0; j < simd::width; j++)
+        {
+            float* record = data + (i + j) * stride;
+            for (int k = 0; k < 3; k++)
+                record[vertexOffset + k] = block[k][j];
+            for (int k = 3; k < columns; k++)
+                record[normalOffset + k - 3] = block[k][j];
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float* record = data + i * stride;
+        float* p = record + vertexOffset;
+        transformPosition(m, p[0], p[1], p[2]);
+        if (normalOffset >= 0)
+        {
+            float* q = record + normalOffset;
+            transformNormalBy(n, q[0], q[1], q[2]);
+        }
+    }
+}
+
 // Apply single transformation to a range of vertices and normals
 inline void applyTransformToRange(
     const mat4<float>& m,
@@ -365,13 +646,30 @@ inline void applyTransformToRange(
     }
 }
 
-// Variadic: apply multiple transformations in sequence
+// Variadic: the transformations in sequence, composed into one position and one
+// normal matrix first and applied in a single pass (applyTransformToRange each
+// is the pass-per-transform equivalent)
 template<typename... Transforms> inline void applyTransformsToRange(
     std::vector<float>& verts,
     std::vector<float>& norms,
     size_t startVertex,
     const Transforms&... transforms)
 {
-    (applyTransformToRange(transforms, verts, norms, startVertex), ...);
+    if constexpr (sizeof...(Transforms) > 0)
+    {
+        const mat4<float> m = composeTransforms(transforms...);
+        const mat3<float> n = normalMatrix(m);
+        size_t vertCount = verts.size() / 3 > startVertex ? verts.size() / 3 - startVertex : 0;
+        size_t normCount = norms.size() / 3 > startVertex ? norms.size() / 3 - startVertex : 0;
+        float* v = vertCount ? verts.data() + startVertex * 3 : nullptr;
+        float* nv = normCount ? norms.data() + startVertex * 3 : nullptr;
+        if (vertCount == normCount)
+            transformVertices(m, n, v, nv, vertCount);
+        else
+        {
+            transformVertices(m, n, v, nullptr, vertCount);
+            transformVertices(m, n, nullptr, nv, normCount);
+        }
+    }
 }
 }
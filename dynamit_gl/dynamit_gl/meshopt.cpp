@@ -0,0 +1,425 @@
+#include "pch.h"
+#include "meshopt.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace dynamit::meshopt
+{
+
+// ============================================================================
+// ACMR
+// ============================================================================
+
+float acmr(const uint32_t* indices, size_t indexCount, size_t vertexCount, int cacheSize)
+{
+    if (indexCount < 3)
+        return 0.0f;
+
+    // A vertex is in the FIFO while fewer than cacheSize misses happened since it entered
+    std::vector<size_t> entered(vertexCount, 0);
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t v = indices[i];
+        if (entered[v] == 0 || misses - entered[v] >= static_cast<size_t>(cacheSize))
+        {
+            misses++;
+            entered[v] = misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+}
+
+float acmr(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize)
+{
+    return acmr(indices.data(), indices.size(), vertexCount, cacheSize);
+}
+
+// ============================================================================
+// VERTEX CACHE ORDER
+// ============================================================================
+
+namespace
+{
+
+const int scoringCacheSize = 32;
+
+float vertexScore(int cachePosition, uint32_t liveTriangles)
+{
+    if (liveTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The last triangle's vertices score lower, so the next one does not reuse
+        // its edge only and strip away from the rest of the cache
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (scoringCacheSize - 3), 1.5f);
+    }
+    // Vertices with few triangles left are finished first, leaving no lone triangles
+    return score + 2.0f / std::sqrt(static_cast<float>(liveTriangles));
+}
+
+} // namespace
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles of each vertex, live ones first in its range
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        if (indices[i] >= vertexCount)
+            throw std::runtime_error("Index out of vertex range");
+        liveTriangles[indices[i]]++;
+    }
+    std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        firstTriangle[v + 1] = firstTriangle[v] + liveTriangles[v];
+    std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+    {
+        std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                vertexTriangles[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+    }
+
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        score[v] = vertexScore(-1, liveTriangles[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(scoringCacheSize + 3);
+    nextCache.reserve(scoringCacheSize + 3);
+
+    size_t scan = 0;
+    size_t best = 0;
+    for (size_t out = 0; out < triangleCount; out++)
+    {
+        // Nothing in the cache has triangles left: continue from the first unused one
+        if (best == triangleCount)
+        {
+            while (emitted[scan])
+                scan++;
+            best = scan;
+        }
+
+        const uint32_t* triangle = &source[best * 3];
+        indices[out * 3] = triangle[0];
+        indices[out * 3 + 1] = triangle[1];
+        indices[out * 3 + 2] = triangle[2];
+        emitted[best] = 1;
+
+        nextCache.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v = triangle[k];
+            nextCache.push_back(v);
+
+            // Take the triangle out of the vertex's live range
+            uint32_t* list = &vertexTriangles[firstTriangle[v]];
+            uint32_t live = liveTriangles[v];
+            for (uint32_t j = 0; j < live; j++)
+                if (list[j] == best)
+                {
+                    std::swap(list[j], list[live - 1]);
+                    break;
+                }
+            liveTriangles[v]--;
+        }
+        for (uint32_t v : cache)
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                nextCache.push_back(v);
+        cache.swap(nextCache);
+
+        // Vertices pushed out of the cache lose their cache score
+        for (size_t i = scoringCacheSize; i < cache.size(); i++)
+        {
+            uint32_t v = cache[i];
+            float newScore = vertexScore(-1, liveTriangles[v]);
+            float delta = newScore - score[v];
+            score[v] = newScore;
+            for (uint32_t j = 0; j < liveTriangles[v]; j++)
+                triangleScore[vertexTriangles[firstTriangle[v] + j]] += delta;
+        }
+        if (cache.size() > static_cast<size_t>(scoringCacheSize))
+            cache.resize(scoringCacheSize);
+
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            uint32_t v = cache[i];
+            float newScore = vertexScore(static_cast<int>(i), liveTriangles[v]);
+            float delta = newScore - score[v];
+            score[v] = newScore;
+            for (uint32_t j = 0; j < liveTriangles[v]; j++)
+                triangleScore[vertexTriangles[firstTriangle[v] + j]] += delta;
+        }
+
+        // The best live triangle of a cached vertex is next
+        best = triangleCount;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache)
+            for (uint32_t j = 0; j < liveTriangles[v]; j++)
+            {
+                uint32_t t = vertexTriangles[firstTriangle[v] + j];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+    }
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+}
+
+// ============================================================================
+// VERTEX FETCH ORDER
+// ============================================================================
+
+namespace
+{
+
+void permuteStream(const VertexStream& stream, size_t firstVertex, const std::vector<uint32_t>& remap)
+{
+    const size_t components = static_cast<size_t>(stream.components);
+    if (!stream.data || components == 0)
+        return;
+    if (stream.data->size() < (firstVertex + remap.size()) * components)
+        throw std::runtime_error("Vertex stream shorter than the vertex range");
+
+    float* base = stream.data->data() + firstVertex * components;
+    std::vector<float> old(base, base + remap.size() * components);
+    for (size_t v = 0; v < remap.size(); v++)
+        std::copy_n(&old[v * components], components, base + remap[v] * components);
+}
+
+} // namespace
+
+void optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t firstVertex, size_t vertexCount,
+    const std::vector<VertexStream>& streams)
+{
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        size_t v = indices[i] - firstVertex;
+        if (indices[i] >= firstVertex && v < vertexCount && remap[v] == unused)
+            remap[v] = next++;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+        if (remap[v] == unused)
+            remap[v] = next++;
+
+    for (const VertexStream& stream : streams)
+        permuteStream(stream, firstVertex, remap);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        size_t v = indices[i] - firstVertex;
+        if (indices[i] >= firstVertex && v < vertexCount)
+            indices[i] = static_cast<uint32_t>(firstVertex + remap[v]);
+    }
+}
+
+// ============================================================================
+// WELD
+// ============================================================================
+
+namespace
+{
+
+uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+{
+    // Different cells may share a key, candidates are compared anyway
+    return static_cast<uint64_t>(x) * 73856093ull ^ static_cast<uint64_t>(y) * 19349663ull
+        ^ static_cast<uint64_t>(z) * 83492791ull;
+}
+
+} // namespace
+
+size_t weldVertices(std::vector<float>& verts, std::vector<float>& norms, std::vector<uint32_t>& indices,
+    float normalAngle, float positionTolerance, const std::vector<VertexStream>& others)
+{
+    const size_t vertexCount = verts.size() / 3;
+    const bool hasNormals = !norms.empty();
+    if (hasNormals && norms.size() != verts.size())
+        throw std::runtime_error("Normals do not match the vertices");
+    for (const VertexStream& stream : others)
+        if (stream.data && stream.data->size() < vertexCount * stream.components)
+            throw std::runtime_error("Vertex stream shorter than the vertices");
+
+    // Exact duplicates fall in one cell whatever its size; with a tolerance the
+    // cell is the tolerance and the neighbouring cells are searched as well
+    float cell = positionTolerance;
+    int reach = 1;
+    if (cell <= 0.0f)
+    {
+        float extent = 0.0f;
+        for (float c : verts)
+            extent = std::max(extent, std::fabs(c));
+        cell = extent > 0.0f ? extent / 1024.0f : 1.0f;
+        reach = 0;
+    }
+    const float toleranceSquared = positionTolerance * positionTolerance;
+    const float minCos = std::cos(normalAngle) - 1e-6f;
+
+    auto unitNormal = [&](size_t v, float* n) {
+        n[0] = norms[v * 3]; n[1] = norms[v * 3 + 1]; n[2] = norms[v * 3 + 2];
+        float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len > 0.0f)
+            for (int k = 0; k < 3; k++)
+                n[k] /= len;
+    };
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint32_t> kept;
+    std::vector<float> normalSum;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const float* p = &verts[v * 3];
+        int64_t cx = static_cast<int64_t>(std::floor(static_cast<double>(p[0]) / cell));
+        int64_t cy = static_cast<int64_t>(std::floor(static_cast<double>(p[1]) / cell));
+        int64_t cz = static_cast<int64_t>(std::floor(static_cast<double>(p[2]) / cell));
+        float n[3] = {};
+        if (hasNormals)
+            unitNormal(v, n);
+
+        uint32_t match = ~0u;
+        for (int dx = -reach; dx <= reach && match == ~0u; dx++)
+        for (int dy = -reach; dy <= reach && match == ~0u; dy++)
+        for (int dz = -reach; dz <= reach && match == ~0u; dz++)
+        {
+            auto found = grid.find(cellKey(cx + dx, cy + dy, cz + dz));
+            if (found == grid.end())
+                continue;
+            for (uint32_t k : found->second)
+            {
+                size_t r = kept[k];
+                const float* q = &verts[r * 3];
+                float ex = p[0] - q[0], ey = p[1] - q[1], ez = p[2] - q[2];
+                if (ex * ex + ey * ey + ez * ez > toleranceSquared)
+                    continue;
+                if (hasNormals)
+                {
+                    float m[3];
+                    unitNormal(r, m);
+                    if (n[0] * m[0] + n[1] * m[1] + n[2] * m[2] < minCos)
+                        continue;
+                }
+                bool same = true;
+                for (const VertexStream& stream : others)
+                {
+                    if (!stream.data)
+                        continue;
+                    const float* a = stream.data->data() + v * stream.components;
+                    const float* b = stream.data->data() + r * stream.components;
+                    for (int c = 0; c < stream.components && same; c++)
+                        same = std::fabs(a[c] - b[c]) <= positionTolerance;
+                }
+                if (same)
+                {
+                    match = k;
+                    break;
+                }
+            }
+        }
+
+        if (match == ~0u)
+        {
+            match = static_cast<uint32_t>(kept.size());
+            kept.push_back(static_cast<uint32_t>(v));
+            normalSum.insert(normalSum.end(), n, n + 3);
+            grid[cellKey(cx, cy, cz)].push_back(match);
+        }
+        else
+        {
+            for (int k = 0; k < 3; k++)
+                normalSum[match * 3 + k] += n[k];
+        }
+        remap[v] = match;
+    }
+
+    // The kept vertices are in their old order, so compacting works in place
+    for (size_t k = 0; k < kept.size(); k++)
+    {
+        size_t v = kept[k];
+        std::copy_n(&verts[v * 3], 3, &verts[k * 3]);
+        for (const VertexStream& stream : others)
+            if (stream.data)
+                std::copy_n(stream.data->data() + v * stream.components, stream.components,
+                    stream.data->data() + k * stream.components);
+        if (hasNormals)
+        {
+            float* s = &normalSum[k * 3];
+            float len = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+            for (int c = 0; c < 3; c++)
+                norms[k * 3 + c] = len > 0.0f ? s[c] / len : 0.0f;
+        }
+    }
+    verts.resize(kept.size() * 3);
+    if (hasNormals)
+        norms.resize(kept.size() * 3);
+    for (const VertexStream& stream : others)
+        if (stream.data)
+            stream.data->resize(kept.size() * stream.components);
+
+    // Triangles collapsed by the tolerance are dropped
+    size_t out = 0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        uint32_t a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        indices[out++] = a;
+        indices[out++] = b;
+        indices[out++] = c;
+    }
+    indices.resize(out);
+    return kept.size();
+}
+
+// ============================================================================
+// ALL PASSES
+// ============================================================================
+
+MeshStats optimizeMesh(std::vector<float>& verts, std::vector<float>& norms, std::vector<uint32_t>& indices,
+    float normalAngle, float positionTolerance, const std::vector<VertexStream>& others)
+{
+    MeshStats stats;
+    stats.verticesBefore = verts.size() / 3;
+    stats.acmrBefore = acmr(indices, stats.verticesBefore);
+
+    stats.verticesAfter = weldVertices(verts, norms, indices, normalAngle, positionTolerance, others);
+    optimizeVertexCache(indices, stats.verticesAfter);
+
+    std::vector<VertexStream> streams = others;
+    streams.push_back({&verts, 3});
+    if (!norms.empty())
+        streams.push_back({&norms, 3});
+    optimizeVertexFetch(indices.data(), indices.size(), 0, stats.verticesAfter, streams);
+
+    stats.acmrAfter = acmr(indices, stats.verticesAfter);
+    return stats;
+}
+
+} // namespace dynamit::meshopt
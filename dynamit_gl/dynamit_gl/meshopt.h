@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Post-build passes over indexed triangle lists: welding of duplicated vertices,
+// triangle order for the post-transform vertex cache and vertex order for fetch.
+// Triangles keep their winding, only their order and vertex numbers change.
+namespace dynamit::meshopt
+{
+
+// One per-vertex array the passes keep in step with the indices:
+// components floats a vertex (an interleaved record is one stream of stride floats)
+struct VertexStream
+{
+    std::vector<float>* data = nullptr;
+    int components = 3;
+};
+
+// Vertices and ACMR (average cache miss ratio: vertices a FIFO cache of cacheSize
+// entries transforms per triangle, 3 at worst, about 0.5 at best on large grids)
+struct MeshStats
+{
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    float acmrBefore = 0.0f;
+    float acmrAfter = 0.0f;
+};
+
+const int defaultCacheSize = 16;
+
+float acmr(const uint32_t* indices, size_t indexCount, size_t vertexCount, int cacheSize = defaultCacheSize);
+float acmr(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = defaultCacheSize);
+
+// Triangles reordered in place for the vertex cache (Tom Forsyth's linear-speed
+// vertex cache optimisation); indices are below vertexCount
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Vertices firstVertex .. firstVertex + vertexCount renumbered in the order the indices
+// first use them, so fetching walks the streams forward. Unused vertices follow in
+// their old order, the vertex count does not change. Indices outside the range are kept.
+void optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t firstVertex, size_t vertexCount,
+    const std::vector<VertexStream>& streams);
+
+// Vertices whose positions are within positionTolerance, whose normals are within
+// normalAngle radians and whose other streams are within positionTolerance become one:
+// the first of them, its normal the normalized sum of theirs. Indices are remapped,
+// the streams compacted; returns the new vertex count. norms may be empty.
+size_t weldVertices(std::vector<float>& verts, std::vector<float>& norms, std::vector<uint32_t>& indices,
+    float normalAngle = 0.0f, float positionTolerance = 0.0f, const std::vector<VertexStream>& others = {});
+
+// Weld, vertex cache and vertex fetch in that order, with the counts before and after
+MeshStats optimizeMesh(std::vector<float>& verts, std::vector<float>& norms, std::vector<uint32_t>& indices,
+    float normalAngle = 0.0f, float positionTolerance = 0.0f, const std::vector<VertexStream>& others = {});
+
+} // namespace dynamit::meshopt
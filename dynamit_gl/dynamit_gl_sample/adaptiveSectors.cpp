@@ -0,0 +1,115 @@
+#include "enabler.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <builders.h>
+
+using namespace dynamit::builders;
+
+// Uniform against adaptive sectors on the sample formulas: for one tolerance,
+// the fewest uniform sectors meeting it, the sectors adaptive(tolerance) keeps,
+// and the vertices a smooth double coated cylinder needs with each.
+struct AdaptiveOutline
+{
+    std::vector<float> x, y, u;
+};
+
+// The base ring of a one slice cylinder: the outline the builder draws
+static AdaptiveOutline buildOutline(const std::wstring& formula, float domain, int sectors, float tolerance)
+{
+    std::vector<float> verts, norms, texCoords;
+    std::vector<uint32_t> indices;
+    Builder::polar()
+        .formula(formula).domain(domain)
+        .sectors_slices(sectors, 1)
+        .adaptive(tolerance)
+        .buildCylinderIndexed(verts, norms, texCoords, indices);
+
+    AdaptiveOutline outline;
+    size_t ring = texCoords.size() / 4;
+    for (size_t i = 0; i < ring; i++)
+    {
+        outline.x.push_back(verts[i * 3]);
+        outline.y.push_back(verts[i * 3 + 1]);
+        outline.u.push_back(texCoords[i * 2]);
+    }
+    return outline;
+}
+
+// Largest distance of the reference curve from the outline's polyline
+static double outlineError(const AdaptiveOutline& outline, const AdaptiveOutline& reference)
+{
+    double worst = 0;
+    for (size_t k = 0; k < reference.u.size(); k++)
+    {
+        size_t i = std::upper_bound(outline.u.begin(), outline.u.end(), reference.u[k]) - outline.u.begin();
+        i = std::min(std::max(i, size_t(1)), outline.u.size() - 1);
+        double ax = outline.x[i - 1], ay = outline.y[i - 1];
+        double dx = outline.x[i] - ax, dy = outline.y[i] - ay;
+        double px = reference.x[k] - ax, py = reference.y[k] - ay;
+        double len2 = dx * dx + dy * dy;
+        double t = len2 > 0 ? std::min(1.0, std::max(0.0, (px * dx + py * dy) / len2)) : 0.0;
+        worst = std::max(worst, std::hypot(px - t * dx, py - t * dy));
+    }
+    return worst;
+}
+
+int main_adaptiveSectors()
+{
+    struct Sample { const wchar_t* formula; float domain; };
+    const Sample samples[] = {
+        { L"theta / PI", static_cast<float>(M_PI) },
+        { L"cos(5 * theta)", static_cast<float>(M_PI) },
+        { L"sqrt(abs(cos(2 * theta)))", static_cast<float>(2 * M_PI) },
+        { L"2 / sqrt(4 * sin(theta)**2 + cos(theta)**2) / 2", static_cast<float>(2 * M_PI) },
+        { L"(1 - cos(theta)) / (PI / 1.55)", static_cast<float>(2 * M_PI) },
+        { L"(1 + 0.5 * cos(5 * theta)) / 1.5", static_cast<float>(2 * M_PI) },
+        { L"1 + 0.3 * sin(7 * theta) * cos(3 * theta)", static_cast<float>(2 * M_PI) },
+    };
+    const float tolerance = 0.002f;
+    const int finest = 4096;
+    const int slices = 16;
+
+    std::cout << "Tolerance " << tolerance << ", smooth double coated cylinder of " << slices << " slices" << std::endl;
+    for (const Sample& sample : samples)
+    {
+        AdaptiveOutline reference = buildOutline(sample.formula, sample.domain, 1 << 16, 0.0f);
+
+        AdaptiveOutline adaptive = buildOutline(sample.formula, sample.domain, finest, tolerance);
+        int adaptiveSectors = static_cast<int>(adaptive.u.size()) - 1;
+        double adaptiveError = outlineError(adaptive, reference);
+
+        // fewest uniform sectors with no more error than the adaptive ring
+        int lo = 1, hi = finest;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (outlineError(buildOutline(sample.formula, sample.domain, mid, 0.0f), reference) <= adaptiveError)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        int uniformSectors = lo;
+
+        PolarBuilder cylinder = Builder::polar();
+        cylinder.formula(sample.formula).domain(sample.domain).sectors_slices(uniformSectors, slices).doubleCoated(true);
+        size_t uniformVertices = cylinder.planCylinder().vertices;
+        size_t adaptiveVertices = cylinder.sectors(finest).adaptive(tolerance).planCylinder().vertices;
+
+        std::wstring name(sample.formula);
+        std::cout << std::string(name.begin(), name.end()) << std::endl
+                  << "  uniform " << std::setw(5) << uniformSectors << " sectors, adaptive " << std::setw(4) << adaptiveSectors
+                  << " (error " << std::setprecision(3) << adaptiveError << "): " << uniformVertices << " -> " << adaptiveVertices
+                  << " vertices, " << std::fixed << std::setprecision(1)
+                  << 100.0 * (1.0 - static_cast<double>(adaptiveVertices) / uniformVertices) << "% saved" << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
+#include "enabler.h"
+#ifdef __ADAPTIVE_SECTORS_CPP__
+int main() { return main_adaptiveSectors(); }
+#endif
@@ -0,0 +1,76 @@
+#include "enabler.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <builders.h>
+
+using namespace dynamit::builders;
+
+// Builds the same large shapes on 1..N threads, checks the output does not
+// change with the thread count and prints the time and speedup of each.
+struct ScalingMesh
+{
+    std::vector<float> verts, norms, colors;
+    std::vector<uint32_t> indices;
+
+    bool operator==(const ScalingMesh& other) const
+    {
+        return verts == other.verts && norms == other.norms && colors == other.colors && indices == other.indices;
+    }
+};
+
+static ScalingMesh buildScalingMesh(bool cone, bool smooth, int threads)
+{
+    ScalingMesh mesh;
+    PolarBuilder builder = Builder::polar();
+    builder.formula(L"1 + 0.3 * sin(7 * theta) * cos(3 * theta)")
+        .sectors_slices(2048, 512)
+        .smooth(smooth)
+        .doubleCoated(true)
+        .threads(threads);
+    if (cone)
+        builder.buildConeIndexedWithColor(mesh.verts, mesh.norms, mesh.colors, mesh.indices);
+    else
+        builder.buildCylinderIndexedWithColor(mesh.verts, mesh.norms, mesh.colors, mesh.indices);
+    return mesh;
+}
+
+int main_builderScaling()
+{
+    const int repeats = 5;
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (maxThreads < 1)
+        maxThreads = 1;
+
+    for (int shape = 0; shape < 4; shape++)
+    {
+        bool cone = shape < 2;
+        bool smooth = (shape % 2) == 0;
+        ScalingMesh reference = buildScalingMesh(cone, smooth, 1);
+        std::cout << (cone ? "Cone" : "Cylinder") << (smooth ? " smooth" : " edged") << ": "
+                  << reference.verts.size() / 3 << " vertices, " << reference.indices.size() / 3 << " triangles" << std::endl;
+
+        double serial = 0;
+        for (int threads = 1; threads <= maxThreads; threads++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            ScalingMesh mesh;
+            for (int r = 0; r < repeats; r++)
+                mesh = buildScalingMesh(cone, smooth, threads);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+            if (threads == 1)
+                serial = ms;
+
+            std::cout << "  " << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(2)
+                      << std::setw(8) << ms << " ms, speedup " << serial / ms << "x"
+                      << (mesh == reference ? "" : "  OUTPUT DIFFERS") << std::endl;
+        }
+    }
+    return 0;
+}
+#include "enabler.h"
+#ifdef __BUILDER_SCALING_CPP__
+int main() { return main_builderScaling(); }
+#endif
@@ -28,4 +28,12 @@
 //#define __POLAR_COMBINE_WITH_TRANSFORM_CPP__
 //#define __POLAR_WITH_TRANSFORM_CPP__
 //#define __POLAR_ARROW_PARAMETRIC_CPP__
+//#define __BUILDER_SCALING_CPP__
+//#define __POLAR_LODS_CPP__
+//#define __ADAPTIVE_SECTORS_CPP__
+//#define __TRANSFORM_BENCHMARK_CPP__
+//#define __MESH_OPTIMIZATION_CPP__
+//#define __QUANTIZED_VERTICES_CPP__
+//#define __TRIANGLE_STRIPS_CPP__
+//#define __TWO_SIDED_COATS_CPP__
 #define __POLAR_ARROW_WITH_COLOR_PARAMETRIC_CPP__
\ No newline at end of file
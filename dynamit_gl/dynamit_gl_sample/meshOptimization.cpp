@@ -0,0 +1,80 @@
+#include "enabler.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <builders.h>
+#include <meshopt.h>
+
+using namespace dynamit::builders;
+namespace meshopt = dynamit::meshopt;
+
+// Vertex cache misses per triangle (ACMR, FIFO of 16) of builder output and of a
+// terrain grid in row order, before and after the meshopt passes. The welded
+// dodecahedron sphere is in sphereDodecahedron.cpp.
+static void printStats(const char* name, const meshopt::MeshStats& stats, size_t triangles, double ms)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setw(8) << stats.verticesBefore << " -> " << std::setw(8) << stats.verticesAfter << " vertices "
+              << std::setw(8) << triangles << " triangles  ACMR " << std::setprecision(3)
+              << stats.acmrBefore << " -> " << stats.acmrAfter
+              << std::setprecision(2) << "  " << ms << " ms" << std::endl;
+}
+
+static void builderStats(const char* name, bool cone, bool smooth)
+{
+    std::vector<float> verts, norms, colors;
+    std::vector<uint32_t> indices;
+    PolarBuilder builder = Builder::polar();
+    builder.formula(L"1 + 0.3 * sin(7 * theta) * cos(3 * theta)")
+        .sectors_slices(256, 64)
+        .smooth(smooth)
+        .doubleCoated(true)
+        .optimized(true);
+
+    auto start = std::chrono::steady_clock::now();
+    if (cone)
+        builder.buildConeIndexedWithColor(verts, norms, colors, indices);
+    else
+        builder.buildCylinderIndexedWithColor(verts, norms, colors, indices);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printStats(name, builder.optimizationStats(), indices.size() / 3, ms);
+}
+
+// The index order of GoogleMapTerrainIndexed: rows of quads, two triangles each
+static void terrainStats(int length, int width)
+{
+    std::vector<float> verts, norms;
+    for (int i = 0; i < length; i++)
+        for (int j = 0; j < width; j++)
+        {
+            verts.insert(verts.end(), { static_cast<float>(i), 0.0f, static_cast<float>(j) });
+            norms.insert(norms.end(), { 0.0f, 1.0f, 0.0f });
+        }
+    std::vector<uint32_t> indices;
+    for (int i = 0; i < length - 1; i++)
+        for (int j = 0; j < width - 1; j++)
+        {
+            uint32_t v00 = i * width + j, v01 = v00 + 1, v10 = v00 + width, v11 = v10 + 1;
+            indices.insert(indices.end(), { v00, v01, v11, v00, v11, v10 });
+        }
+
+    auto start = std::chrono::steady_clock::now();
+    meshopt::MeshStats stats = meshopt::optimizeMesh(verts, norms, indices);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printStats("Terrain grid rows", stats, indices.size() / 3, ms);
+}
+
+int main_meshOptimization()
+{
+    builderStats("Cone smooth", true, true);
+    builderStats("Cylinder smooth", false, true);
+    // every triangle has its own vertices: nothing to reuse, ACMR stays 3
+    builderStats("Cone edged", true, false);
+    terrainStats(512, 512);
+    return 0;
+}
+#include "enabler.h"
+#ifdef __MESH_OPTIMIZATION_CPP__
+int main() { return main_meshOptimization(); }
+#endif
@@ -0,0 +1,90 @@
+#include "enabler.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <string>
+#include <Dynamit.h>
+#include <geometry.h>
+#include <config.h>
+#include <callbacks.h>
+#include <builders.h>
+
+using namespace dynamit;
+using namespace dynamit::builders;
+
+// One smooth build, five levels of detail sharing its vertices. The shape shrinks
+// and grows on screen; the level drawn follows its size (window title).
+// F11 shows the wireframe.
+int main_polarLods()
+{
+    const int windowSize = 720;
+    GLFWwindow* window = openglWindowInit(windowSize, windowSize);
+    if (!window)
+        return -1;
+
+    std::cout << glGetString(GL_VERSION) << std::endl;
+
+    InterleavedGeometry geometry;
+    geometry.layout = InterleavedLayout::of(true, false, true);
+    std::vector<LodRange> lods;
+    Builder::polar()
+        .formula(L"1 + 0.25 * sin(6 * theta)")
+        .sectors_slices(256, 64)
+        .smooth(true).doubleCoated(true)
+        .color({ 0.0f, 1.0f, 0.5f, 1.0f }, { 1.0f, 0.5f, 0.0f, 1.0f })
+        .buildCylinderLods(geometry, lods, 5);
+
+    std::cout << "Shared vertices: " << geometry.vertexCount() << std::endl;
+    for (size_t i = 0; i < lods.size(); i++)
+        std::cout << "  level " << i << ": " << lods[i].sectors << " x " << lods[i].slices
+                  << ", " << lods[i].indexCount / 3 << " triangles" << std::endl;
+
+    Dynamit shape;
+    shape.withInterleaved(geometry)
+        .withLods(lods)
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    shape.buildProgram();
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.0f, 0.0f, 1.f, 0.9f);
+
+    // The shape is 2 * 1.25 across (formula maximum), one NDC unit is windowSize / 2 pixels
+    const float shapeSize = 2.5f;
+    mat4<float> mat4Transform = {};
+    int shownLevel = -2;
+    while (!glfwWindowShouldClose(window))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS ? GL_LINE : GL_FILL);
+        processInputs(window);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        float time = static_cast<float>(glfwGetTime());
+        float scale = 0.02f + 0.3f * (1.0f + std::sin(time * 0.5f));
+        rotation_x_mat4(0.7f, mat4Transform);
+        multiply_mat4(scaleMatrix(scale, scale, scale), mat4Transform);
+
+        shape.transformMatrix4f(mat4Transform);
+        int level = shape.drawTrianglesLod(shapeSize * scale * windowSize / 2);
+        if (level != shownLevel)
+        {
+            shownLevel = level;
+            glfwSetWindowTitle(window, ("Level of detail " + std::to_string(level)).c_str());
+        }
+
+        glfwPollEvents();
+        glfwSwapBuffers(window);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+#include "enabler.h"
+#ifdef __POLAR_LODS_CPP__
+int main() { return main_polarLods(); }
+#endif
@@ -0,0 +1,94 @@
+#include "enabler.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <Dynamit.h>
+#include <geometry.h>
+#include <config.h>
+#include <callbacks.h>
+#include <builders.h>
+
+using namespace dynamit;
+using namespace dynamit::builders;
+
+// The same shape as floats (left) and packed (right): snorm16 positions in the
+// shape's box, octahedral snorm16 normals and RGBA8 colours, decoded in the
+// generated vertex shader. Prints the bytes of both. F11 shows the wireframe.
+int main_quantizedVertices()
+{
+    GLFWwindow* window = openglWindowInit(1080, 540);
+    if (!window)
+        return -1;
+
+    std::cout << glGetString(GL_VERSION) << std::endl;
+
+    PolarBuilder builder = Builder::polar();
+    builder.formula(L"1 + 0.25 * sin(6 * theta)")
+        .sectors_slices(512, 128)
+        .smooth(true).doubleCoated(true)
+        .color({ 0.0f, 1.0f, 0.5f, 1.0f }, { 1.0f, 0.5f, 0.0f, 1.0f });
+
+    InterleavedGeometry floats;
+    floats.layout = InterleavedLayout::of(true, false, true);
+    builder.buildCylinderInterleaved(floats);
+
+    QuantizedGeometry packed;
+    packed.layout.position = VertexFormat::Snorm16;
+    packed.layout.normal = VertexFormat::Octahedral16;
+    packed.layout.color = VertexFormat::Unorm8;
+    builder.buildCylinderQuantized(packed);
+
+    std::cout << floats.vertexCount() << " vertices: " << floats.layout.stride * sizeof(float) << " bytes each as floats, "
+              << packed.layout.stride << " packed; " << floats.data.size() * sizeof(float) / 1024 << " KB -> "
+              << packed.data.size() / 1024 << " KB" << std::endl;
+
+    Dynamit floatShape;
+    floatShape.withInterleaved(floats)
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    floatShape.buildProgram();
+
+    Dynamit packedShape;
+    packedShape.withQuantized(packed)
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    packedShape.buildProgram();
+    packedShape.logGeneratedShaders();
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.0f, 0.0f, 1.f, 0.9f);
+
+    mat4<float> mat4Transform = {};
+    while (!glfwWindowShouldClose(window))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS ? GL_LINE : GL_FILL);
+        processInputs(window);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        float time = static_cast<float>(glfwGetTime());
+        for (int side = 0; side < 2; side++)
+        {
+            rotation_x_mat4(0.7f + 0.3f * std::sin(time), mat4Transform);
+            multiply_mat4(scaleMatrix(0.2f, 0.4f, 0.4f), mat4Transform);
+            multiply_mat4(translation_mat4(side ? 0.5f : -0.5f, 0.0f, 0.0f), mat4Transform);
+            Dynamit& shape = side ? packedShape : floatShape;
+            shape.transformMatrix4f(mat4Transform);
+            shape.drawTrianglesIndexed();
+        }
+
+        glfwPollEvents();
+        glfwSwapBuffers(window);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+#include "enabler.h"
+#ifdef __QUANTIZED_VERTICES_CPP__
+int main() { return main_quantizedVertices(); }
+#endif
@@ -5,6 +5,8 @@ in vec3 terrainNormal;
 in vec3 lightDirection;
 void main()
 {
-    float strength =  dot(normalize(-lightDirection), normalize(terrainNormal));
+    // a back face is the underside of a two sided terrain's one coat
+    vec3 normal = gl_FrontFacing ? terrainNormal : -terrainNormal;
+    float strength =  dot(normalize(-lightDirection), normalize(normal));
     FragColor = vec4( terrainColor.rgb * strength, terrainColor.a);
 }
@@ -7,6 +7,8 @@ in vec3 lightDirection;
 
 void main()
 {
-    float strength  =  dot(-lightDirection, terrainNormal);
+    // a back face is the underside of a two sided terrain's one coat
+    vec3 normal = gl_FrontFacing ? terrainNormal : -terrainNormal;
+    float strength  =  dot(-lightDirection, normal);
 	color = vec4(terrainColor.rgb * strength, terrainColor.a);
 }
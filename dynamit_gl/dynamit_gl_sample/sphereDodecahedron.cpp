@@ -13,6 +13,7 @@
 #include <cassert>
 #include <algorithm>
 #include <Dynamit.h>
+#include <meshopt.h>
 #include <config.h>
 #include <callbacks.h>
 
@@ -396,6 +397,17 @@ void meshToIndexedArrays(const Mesh& mesh,
     meshToIndexedArrays(mesh, verts, norms, texCoords, indices);
 }
 
+// Indexed arrays with the vertices the pentagons duplicate on their shared edges
+// welded (positions agree to rounding, normals within about a degree), then in
+// vertex cache and fetch order
+meshopt::MeshStats meshToWeldedArrays(const Mesh& mesh,
+                                      std::vector<float>& verts,
+                                      std::vector<float>& norms,
+                                      std::vector<uint32_t>& indices) {
+    meshToIndexedArrays(mesh, verts, norms, indices);
+    return meshopt::optimizeMesh(verts, norms, indices, 0.02f, 1e-5f);
+}
+
 // Generate sphere mesh with specified subdivision level
 Mesh generateSphereMesh(int subdivisionLevel = 3, WindingOrder order = WindingOrder::CCW) {
     return generateSubdividedMeshExternal(subdivisionLevel, order);
@@ -423,12 +435,14 @@ int main_sphereDodecahedron() {
     //std::cout << "Low poly sphere: " << vertsLow.size() / 3 
     //          << " vertices, " << vertsLow.size() / 9 << " triangles\n";
     
-    //// Sphere 2: Medium poly (subdivision level 3)
+    //// Sphere 2: Medium poly (subdivision level 3), welded and indexed
     Mesh meshMed = generateSphereMesh(3, WindingOrder::CCW);
     std::vector<float> vertsMed, normsMed;
-    meshToFlatArrays(meshMed, vertsMed, normsMed);
-    //std::cout << "Medium poly sphere: " << vertsMed.size() / 3 
-    //          << " vertices, " << vertsMed.size() / 9 << " triangles\n";
+    std::vector<uint32_t> indicesMed;
+    meshopt::MeshStats statsMed = meshToWeldedArrays(meshMed, vertsMed, normsMed, indicesMed);
+    std::cout << "Medium poly sphere: " << statsMed.verticesBefore << " -> " << statsMed.verticesAfter
+              << " vertices welded, " << indicesMed.size() / 3 << " triangles, ACMR "
+              << statsMed.acmrBefore << " -> " << statsMed.acmrAfter << "\n";
     ////
     ////// Sphere 3: High poly (subdivision level 5)
     Mesh meshHigh = generateSphereMesh(5, WindingOrder::CCW);
@@ -459,6 +473,7 @@ int main_sphereDodecahedron() {
     Dynamit sphereMed;
     sphereMed.withVertices3d(vertsMed)
              .withNormals3d(normsMed)
+             .withIndices(indicesMed)
              .withConstColor(0.2f, 1.0f, 0.2f, 1.0f)  // Green
              .withConstTranslation(0.0f, 0.0f, 0.5f, 0.0f)
              .withConstLightDirection(-1.0f, -1.0f, 1.0f);
@@ -494,7 +509,7 @@ int main_sphereDodecahedron() {
         
         // Draw all three spheres
         //sphereLow.drawTriangles();
-        sphereMed.drawTriangles();
+        sphereMed.drawTrianglesIndexed();
         //sphereHigh.drawTriangles();
         
         glfwPollEvents();
@@ -0,0 +1,150 @@
+#include "enabler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <geometry.h>
+
+using namespace dynamit::geo;
+
+// One pass per transform (applyTransformToRange each, the former applyTransformsToRange)
+// against the composed single pass over packed, SoA and interleaved vertices.
+// 1M vertices and normals, a rotation, scale, rotation and translation.
+static double bestOf(int repeats, const std::function<void()>& reset, const std::function<void()>& run)
+{
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++)
+    {
+        reset();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static double maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+    double worst = 0;
+    for (size_t i = 0; i < a.size(); i++)
+        worst = std::max(worst, static_cast<double>(std::fabs(a[i] - b[i])));
+    return worst;
+}
+
+int main_transformBenchmark()
+{
+    const size_t count = 1000000;
+    const int repeats = 10;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+    std::vector<float> verts(count * 3), norms(count * 3);
+    for (float& v : verts) v = coordinate(random);
+    for (float& n : norms) n = coordinate(random);
+
+    const mat4<float> rotateX = rotation_x_mat4<float>(0.7f);
+    const mat4<float> scale = scaleMatrix<float>(2.0f, 0.5f, 1.5f);
+    const mat4<float> rotateY = rotation_y_mat4<float>(-1.1f);
+    const mat4<float> translate = translation_mat4<float>(0.5f, -0.25f, 1.0f);
+
+    std::vector<float> v, n;
+    auto reset = [&] { v = verts; n = norms; };
+
+    double perTransform = bestOf(repeats, reset, [&] {
+        applyTransformToRange(rotateX, v, n, 0);
+        applyTransformToRange(scale, v, n, 0);
+        applyTransformToRange(rotateY, v, n, 0);
+        applyTransformToRange(translate, v, n, 0);
+    });
+    std::vector<float> expectedVerts = v, expectedNorms = n;
+
+    double fused = bestOf(repeats, reset, [&] { applyTransformsToRange(v, n, 0, rotateX, scale, rotateY, translate); });
+    double fusedError = std::max(maxDifference(v, expectedVerts), maxDifference(n, expectedNorms));
+
+    // the same data as separate x, y, z arrays
+    std::vector<float> soa[6];
+    auto resetSoA = [&] {
+        for (int k = 0; k < 6; k++)
+            soa[k].resize(count);
+        for (size_t i = 0; i < count; i++)
+            for (int k = 0; k < 3; k++)
+            {
+                soa[k][i] = verts[i * 3 + k];
+                soa[3 + k][i] = norms[i * 3 + k];
+            }
+    };
+    const mat4<float> composed = composeTransforms(rotateX, scale, rotateY, translate);
+    const mat3<float> normal = normalMatrix(composed);
+    double soaMs = bestOf(repeats, resetSoA, [&] {
+        transformVerticesSoA(composed, normal, soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(), count);
+    });
+    double soaError = 0;
+    for (size_t i = 0; i < count; i++)
+        for (int k = 0; k < 3; k++)
+            soaError = std::max(soaError, static_cast<double>(std::max(std::fabs(soa[k][i] - expectedVerts[i * 3 + k]),
+                std::fabs(soa[3 + k][i] - expectedNorms[i * 3 + k]))));
+
+    // interleaved position, normal records as withInterleaved uploads them
+    std::vector<float> records;
+    auto resetRecords = [&] {
+        records.resize(count * 6);
+        for (size_t i = 0; i < count; i++)
+            for (int k = 0; k < 3; k++)
+            {
+                records[i * 6 + k] = verts[i * 3 + k];
+                records[i * 6 + 3 + k] = norms[i * 3 + k];
+            }
+    };
+    double stridedMs = bestOf(repeats, resetRecords, [&] { transformVerticesStrided(composed, normal, records.data(), count, 6, 0, 3); });
+    double stridedError = 0;
+    for (size_t i = 0; i < count; i++)
+        for (int k = 0; k < 3; k++)
+            stridedError = std::max(stridedError, static_cast<double>(std::max(std::fabs(records[i * 6 + k] - expectedVerts[i * 3 + k]),
+                std::fabs(records[i * 6 + 3 + k] - expectedNorms[i * 3 + k]))));
+
+#if defined(GEOMETRY_SIMD_AVX)
+    const char* kernel = "AVX, 8 vertices a step";
+#elif defined(GEOMETRY_SIMD_SSE)
+    const char* kernel = "SSE, 4 vertices a step";
+#else
+    const char* kernel = "scalar";
+#endif
+    std::cout << count << " vertices and normals, 4 transforms, kernel " << kernel << std::endl << std::fixed;
+    auto line = [&](const char* name, double ms, double error) {
+        std::cout << "  " << std::left << std::setw(24) << name << std::right << std::setprecision(2) << std::setw(8) << ms
+                  << " ms  " << std::setw(6) << perTransform / ms << "x";
+        if (error >= 0)
+            std::cout << "  max difference " << std::scientific << std::setprecision(1) << error << std::fixed;
+        std::cout << std::endl;
+    };
+    line("pass per transform", perTransform, -1);
+    line("composed, packed xyz", fused, fusedError);
+    line("composed, SoA", soaMs, soaError);
+    line("composed, interleaved", stridedMs, stridedError);
+
+    // small uniform scales: the composed normals stay unit length as the per transform ones do
+    for (float s : { 0.01f, 0.005f, 1e-4f })
+    {
+        std::vector<float> nv = verts, nn = norms, ev = verts, en = norms;
+        const mat4<float> small = scaleMatrix<float>(s, s, s);
+        applyTransformToRange(rotateX, ev, en, 0);
+        applyTransformToRange(small, ev, en, 0);
+        applyTransformsToRange(nv, nn, 0, rotateX, small);
+        double lengthError = 0;
+        for (size_t i = 0; i < count; i++)
+            lengthError = std::max(lengthError, std::fabs(std::sqrt(static_cast<double>(nn[i * 3] * nn[i * 3] + nn[i * 3 + 1] * nn[i * 3 + 1]
+                + nn[i * 3 + 2] * nn[i * 3 + 2])) - 1.0));
+        std::cout << "  scale " << std::scientific << std::setprecision(0) << s << ": normal length off by " << std::setprecision(1)
+                  << lengthError << ", max difference " << maxDifference(nn, en) << std::fixed << std::endl;
+    }
+    return 0;
+}
+#include "enabler.h"
+#ifdef __TRANSFORM_BENCHMARK_CPP__
+int main() { return main_transformBenchmark(); }
+#endif
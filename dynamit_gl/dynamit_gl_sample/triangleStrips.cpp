@@ -0,0 +1,96 @@
+#include "enabler.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <Dynamit.h>
+#include <geometry.h>
+#include <config.h>
+#include <callbacks.h>
+#include <builders.h>
+
+using namespace dynamit;
+using namespace dynamit::builders;
+
+// The same cone as triangle lists (left) and as one triangle strip per slice
+// (right), strips ended by RestartIndex. Prints the indices of both. F11 shows
+// the wireframe: the triangles are the same.
+int main_triangleStrips()
+{
+    GLFWwindow* window = openglWindowInit(1080, 540);
+    if (!window)
+        return -1;
+
+    std::cout << glGetString(GL_VERSION) << std::endl;
+
+    PolarBuilder builder = Builder::polar();
+    builder.formula(L"1 + 0.25 * sin(6 * theta)")
+        .sectors_slices(256, 32)
+        .smooth(true).doubleCoated(true)
+        .color({ 0.0f, 1.0f, 0.5f, 1.0f }, { 1.0f, 0.5f, 0.0f, 1.0f });
+
+    std::vector<float> verts, norms, colors;
+    std::vector<uint32_t> lists, strips;
+    builder.buildConeIndexedWithColor(verts, norms, colors, lists);
+    verts.clear(); norms.clear(); colors.clear();
+    builder.strips(true).buildConeIndexedWithColor(verts, norms, colors, strips);
+
+    std::cout << verts.size() / 3 << " vertices: " << lists.size() << " indices as triangles, "
+              << strips.size() << " as strips; " << lists.size() * sizeof(uint32_t) / 1024 << " KB -> "
+              << strips.size() * sizeof(uint32_t) / 1024 << " KB" << std::endl;
+
+    Dynamit listShape;
+    listShape.withVertices3d(verts)
+        .withNormals3d(norms)
+        .withColors4d(colors)
+        .withIndices(lists)
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    listShape.buildProgram();
+
+    Dynamit stripShape;
+    stripShape.withPrimitive(GL_TRIANGLE_STRIP)
+        .withVertices3d(verts)
+        .withNormals3d(norms)
+        .withColors4d(colors)
+        .withIndices(strips)
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    stripShape.buildProgram();
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.0f, 0.0f, 1.f, 0.9f);
+
+    mat4<float> mat4Transform = {};
+    while (!glfwWindowShouldClose(window))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS ? GL_LINE : GL_FILL);
+        processInputs(window);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        float time = static_cast<float>(glfwGetTime());
+        for (int side = 0; side < 2; side++)
+        {
+            rotation_x_mat4(0.7f + 0.3f * std::sin(time), mat4Transform);
+            multiply_mat4(scaleMatrix(0.2f, 0.4f, 0.4f), mat4Transform);
+            multiply_mat4(translation_mat4(side ? 0.5f : -0.5f, 0.0f, 0.0f), mat4Transform);
+            Dynamit& shape = side ? stripShape : listShape;
+            shape.transformMatrix4f(mat4Transform);
+            shape.drawTrianglesIndexed();
+        }
+
+        glfwPollEvents();
+        glfwSwapBuffers(window);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+#include "enabler.h"
+#ifdef __TRIANGLE_STRIPS_CPP__
+int main() { return main_triangleStrips(); }
+#endif
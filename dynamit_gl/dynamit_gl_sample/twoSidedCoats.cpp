@@ -0,0 +1,98 @@
+#include "enabler.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <Dynamit.h>
+#include <geometry.h>
+#include <config.h>
+#include <callbacks.h>
+#include <builders.h>
+
+using namespace dynamit;
+using namespace dynamit::builders;
+
+// A double coated cone with both coats built (left) and with one coat whose back
+// faces are the inner coat (right): normals flipped and the inner colour chosen by
+// gl_FrontFacing in the fragment shader. Prints the vertices of both.
+int main_twoSidedCoats()
+{
+    GLFWwindow* window = openglWindowInit(1080, 540);
+    if (!window)
+        return -1;
+
+    std::cout << glGetString(GL_VERSION) << std::endl;
+
+    PolarBuilder builder = Builder::polar();
+    builder.formula(L"1 + 0.25 * sin(6 * theta)")
+        .domain(static_cast<float>(1.5 * M_PI))
+        .sectors_slices(256, 32)
+        .smooth(true).doubleCoated(true)
+        .color({ 0.0f, 1.0f, 0.5f, 1.0f }, { 1.0f, 0.5f, 0.0f, 1.0f });
+
+    std::vector<float> verts, norms, colors;
+    std::vector<uint32_t> indices;
+    builder.buildConeIndexedWithColor(verts, norms, colors, indices);
+
+    std::vector<float> vertsOne, normsOne, colorsOne;
+    std::vector<uint32_t> indicesOne;
+    builder.twoSided(true).buildConeIndexedWithColor(vertsOne, normsOne, colorsOne, indicesOne);
+
+    std::cout << "Two coats: " << verts.size() / 3 << " vertices, " << indices.size() << " indices; "
+              << "one coat two sided: " << vertsOne.size() / 3 << " vertices, " << indicesOne.size() << " indices" << std::endl;
+
+    Dynamit coats;
+    coats.withVertices3d(verts)
+        .withNormals3d(norms)
+        .withColors4d(colors)
+        .withIndices(indices)
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    coats.buildProgram();
+
+    Dynamit twoSided;
+    twoSided.withVertices3d(vertsOne)
+        .withNormals3d(normsOne)
+        .withColors4d(colorsOne)
+        .withIndices(indicesOne)
+        .withTwoSided(builder.innerColor())
+        .withConstLightDirection({ -0.577f, -0.577f, 0.577f })
+        .withTransformMatrix4f();
+    twoSided.buildProgram();
+    twoSided.logGeneratedShaders();
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.0f, 0.0f, 1.f, 0.9f);
+
+    mat4<float> mat4Transform = {};
+    while (!glfwWindowShouldClose(window))
+    {
+        processInputs(window);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        float time = static_cast<float>(glfwGetTime());
+        for (int side = 0; side < 2; side++)
+        {
+            rotation_x_mat4(time, mat4Transform);
+            multiply_mat4(scaleMatrix(0.2f, 0.4f, 0.4f), mat4Transform);
+            multiply_mat4(translation_mat4(side ? 0.5f : -0.5f, 0.0f, 0.0f), mat4Transform);
+            Dynamit& shape = side ? twoSided : coats;
+            shape.transformMatrix4f(mat4Transform);
+            shape.drawTrianglesIndexed();
+        }
+
+        glfwPollEvents();
+        glfwSwapBuffers(window);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+#include "enabler.h"
+#ifdef __TWO_SIDED_COATS_CPP__
+int main() { return main_twoSidedCoats(); }
+#endif
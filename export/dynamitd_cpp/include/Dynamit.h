@@ -9,6 +9,13 @@
 #include <array>
 #include "NormalsHighlighter.h"
 
+namespace dynamit::builders
+{
+    struct InterleavedGeometry;
+    struct QuantizedGeometry;
+    struct LodRange;
+}
+
 namespace dynamit
 {
 
@@ -75,6 +82,14 @@ namespace dynamit
     //========================================
     // StrideAttribute - Describes one attribute in interleaved data
     //========================================
+    // How the generated vertex shader turns a packed attribute into its value
+    enum class StrideDecode
+    {
+        None,         // used as read (floats, half floats, normalized integers)
+        ScaleOffset,  // value * scale + offset, e.g. snorm16 positions in a box
+        Octahedral    // two components on the octahedron to a unit vec3
+    };
+
     struct StrideAttribute
     {
         std::string name;
@@ -83,6 +98,9 @@ namespace dynamit
         GLenum type;          // GL_FLOAT, GL_INT, etc.
         GLboolean normalized;
         GLsizei offset;       // Byte offset within stride
+        StrideDecode decode = StrideDecode::None;
+        std::array<float, 3> decodeScale = { 1.0f, 1.0f, 1.0f };
+        std::array<float, 3> decodeOffset = { 0.0f, 0.0f, 0.0f };
     };
 
     //========================================
@@ -98,6 +116,9 @@ namespace dynamit
     public:
         void addAttribute(const std::string& name, GLuint location, GLint size,
             GLenum type = GL_FLOAT, GLboolean normalized = GL_FALSE);
+        void setDecode(const std::string& name, StrideDecode decode,
+            const std::array<float, 3>& scale = { 1.0f, 1.0f, 1.0f },
+            const std::array<float, 3>& offset = { 0.0f, 0.0f, 0.0f });
         void setOffset(GLsizei offset);
         void setStride(GLsizei stride);
         void finalize();
@@ -133,6 +154,17 @@ namespace dynamit
         std::string toGLSL() const;
     };
 
+    // One coat seen from both sides: back faces flip their normal and, when
+    // hasInnerColor, take innerColor (gl_FrontFacing); culling is off while it draws
+    struct TwoSided
+    {
+        std::string name;
+        std::array<float, 4> innerColor;
+        bool hasInnerColor = false;
+
+        std::string toGLSL() const;
+    };
+
     struct Translation
     {
         std::string name;
@@ -184,6 +216,26 @@ namespace dynamit
         }
     };
 
+    //========================================
+    // GeneratedVertex - position and normal computed in the vertex shader
+    // source defines void generateVertex(vec2 grid, out vec3 position, out vec3 normal),
+    // the vertex buffer only holds the grid; each variable is a uniform float
+    //========================================
+    struct VertexVariable
+    {
+        std::string name;
+        float value = 0.0f;
+        GLint location = -1;
+    };
+
+    struct GeneratedVertex
+    {
+        std::string source;
+        std::vector<VertexVariable> variables;
+
+        std::string toGLSLUniforms() const;
+    };
+
     //========================================
     // GlSet - Holds all rendering state
     //========================================
@@ -200,6 +252,8 @@ namespace dynamit
         std::optional<ConstTranslation> constTranslation;
         std::optional<TransformMatrix3> transformMatrix3;
         std::optional<TransformMatrix4> transformMatrix4;
+        std::optional<GeneratedVertex> generatedVertex;
+        std::optional<TwoSided> twoSided;
 
     public:
         // Getters
@@ -213,6 +267,9 @@ namespace dynamit
         const std::optional<ConstTranslation>& getConstTranslation() const;
         const std::optional<TransformMatrix3>& getTransformMatrix3() const;
         const std::optional<TransformMatrix4>& getTransformMatrix4() const;
+        const std::optional<GeneratedVertex>& getGeneratedVertex() const;
+        std::optional<GeneratedVertex>& getGeneratedVertex(); // variable1f caches uniform locations in it
+        const std::optional<TwoSided>& getTwoSided() const;
 
         // Setters
         void setPrecision(const std::string& p);
@@ -231,6 +288,8 @@ namespace dynamit
         {
             transformMatrix4 = matrix;
         }
+        void setGeneratedVertex(const GeneratedVertex& generated);
+        void setTwoSided(const TwoSided& sides);
 
         void requireColor(const std::array<float, 4>& defaultValue = { 0.7f, 0.7f, 0.7f, 1.0f },
             const std::string& name = "constColor");
@@ -299,8 +358,11 @@ namespace dynamit
         ShaderSources buildCompositional();
         void addDeclarations();
         void addStrideDeclarations();
+        std::string strideValue(const StrideAttribute& attr) const;
+        void addGeneratedVertexDeclarations();
         std::string buildPositionExpression();
         std::string buildColorExpression();
+        std::string buildFrontColorExpression();
         std::string buildLightingFactor();
         void composeVertexMain();
         void composeFragmentMain();
@@ -312,6 +374,14 @@ namespace dynamit
     class Dynamit : public Shape
     {
     public:
+        // One level of detail: a range of the index buffer and the sectors it draws
+        struct LodLevel
+        {
+            size_t firstIndex = 0;
+            size_t indexCount = 0;
+            int sectors = 0;
+        };
+
         // Per-VAO data container
         struct VAOData
         {
@@ -319,10 +389,14 @@ namespace dynamit
             GlSet glSet;
             size_t vertexCount = 0;
             GLuint strideBuffer = 0;  // Buffer ID for interleaved data
+            size_t strideBytes = 0;   // Size of the interleaved data
             GLuint indexBuffer = 0;   // Buffer ID for element indices
             size_t indexCount = 0;    // Number of indices
             GLenum indexType = GL_UNSIGNED_INT;  // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT
             GLenum primitiveType = GL_TRIANGLES; // GL_TRIANGLES, GL_TRIANGLE_FAN, GL_TRIANGLE_STRIP, etc.
+            bool vertexCacheOrder = false;       // withIndices reorders GL_TRIANGLES for the vertex cache
+            std::vector<LodLevel> lods;          // Index ranges of withLods, finest first
+            std::vector<uint8_t> unorderedIndices; // vertexCacheOrder indices as given, until withLods orders its ranges
         };
 
     private:
@@ -355,11 +429,19 @@ namespace dynamit
         size_t vaoCount() const { return vaoList.size(); }
 
         // Fluent API - Index buffer
+        // GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN and line strips draw with
+        // GL_PRIMITIVE_RESTART: the largest index of the index type,
+        // builders::RestartIndex for uint32_t, starts the next strip
         Dynamit& withPrimitive(GLenum primitive);
         Dynamit& withIndices(const std::vector<uint32_t>& indices);
         Dynamit& withIndices(const std::vector<uint16_t>& indices);
         Dynamit& withIndices(const std::vector<uint8_t>& indices);
         Dynamit& withIndices(const void* data, size_t count, GLenum type);
+        // GL_TRIANGLES indices given after this are uploaded in vertex cache order
+        // (meshopt::optimizeVertexCache), same triangles and winding. The vertex
+        // buffers are not touched. withLods orders each of its ranges on its own, so no
+        // triangle moves to another level.
+        Dynamit& withVertexCacheOrder(bool enabled = true);
 
         // Fluent API - Interleaved/Stride mode
         Dynamit& withStride(const std::vector<float>& data, GLsizei strideBytes);
@@ -369,6 +451,25 @@ namespace dynamit
         Dynamit& withStrideNormals(GLint size = 3, GLboolean normalized = GL_FALSE, GLenum type = GL_FLOAT);
         Dynamit& withStrideTexCoords(GLint size = 2, GLboolean normalized = GL_FALSE, GLenum type = GL_FLOAT);
         Dynamit& withStrideColors(GLint size = 4, GLboolean normalized = GL_FALSE, GLenum type = GL_FLOAT);
+        // Packed attributes: the vertex shader decodes the vertex attribute as
+        // vertex * scale + offset (snorm16 positions in a box), and octahedral normals
+        // from two normalized components (GL_SHORT or GL_BYTE)
+        Dynamit& withStrideVertexDecode(const std::array<float, 3>& scale, const std::array<float, 3>& offset);
+        Dynamit& withStrideOctahedralNormals(GLenum type = GL_SHORT);
+        // A builder's interleaved output as one VBO: withStride, the stride
+        // attributes of its layout and withIndices in one call
+        Dynamit& withInterleaved(const builders::InterleavedGeometry& geometry);
+        // The same for a quantized stream, with the decode of its formats
+        Dynamit& withQuantized(const builders::QuantizedGeometry& geometry);
+        // Refill the buffers of a shape already set up, keeping its VAO, layout and
+        // program: glBufferSubData when the size is unchanged, glBufferData otherwise
+        Dynamit& updateStride(const void* data, size_t sizeBytes);
+        Dynamit& updateIndices(const void* data, size_t count, GLenum type);
+        Dynamit& updateInterleaved(const builders::InterleavedGeometry& geometry, bool indices = true);
+        Dynamit& updateQuantized(const builders::QuantizedGeometry& geometry, bool indices = true);
+        // Levels of detail of PolarBuilder::buildConeLods / buildCylinderLods, ranges of
+        // the index buffer given to withInterleaved; drawn with drawTrianglesLod
+        Dynamit& withLods(const std::vector<builders::LodRange>& lods);
 
         // Fluent API - Vertices (separate buffers)
         Dynamit& withVertices2d(const std::vector<float>& data);
@@ -377,6 +478,11 @@ namespace dynamit
         Dynamit& withVertices3d(const float* data, size_t count);
         Dynamit& withVertices3d();
 
+        // Fluent API - Vertices generated in the vertex shader from a static grid,
+        // e.g. PolarBuilder::buildConeGrid + coneShader(); variables are set with variable1f
+        Dynamit& withGeneratedVertices(const std::vector<float>& grid, const std::string& source,
+            const std::vector<std::string>& variables = {});
+
         // Fluent API - Normals (separate buffers)
         Dynamit& withNormals3d(const std::vector<float>& data);
         Dynamit& withNormals3d(const float* data, size_t count);
@@ -394,6 +500,10 @@ namespace dynamit
             const std::string& name = "lightDirection");
         Dynamit& withConstTranslation(const std::array<float, 4>& trans, const std::string& name = "Translation");
         Dynamit& withConstTranslation(float x, float y, float z, float w, const std::string& name = "Translation");
+        // Draw the back faces too, lit by the flipped normal: a double coat from one
+        // coat (PolarBuilder::twoSided). innerColor replaces the color on the back
+        Dynamit& withTwoSided(const std::string& name = "innerColor");
+        Dynamit& withTwoSided(const std::array<float, 4>& innerColor, const std::string& name = "innerColor");
 
         // Fluent API - Uniforms (for animation)
         Dynamit& withTranslation4f(const std::string& name = "translation");
@@ -426,6 +536,12 @@ namespace dynamit
         // Drawing
         void drawTriangles(GLint start = 0);
         void drawTrianglesIndexed();
+        // Draws every VAO, each at the coarsest of its own levels whose sector edges stay
+        // within pixelsPerSector on a shape screenPixels across; VAOs without levels are
+        // drawn whole. Returns the level of the first VAO with levels (0 finest, -1 none)
+        int drawTrianglesLod(float screenPixels, float pixelsPerSector = 8.0f);
+        // Screen size in pixels of a sphere of radius at distance, perspective fovY in radians
+        static float projectedPixels(float radius, float distance, float fovY, int viewportHeight);
         void drawTriangleFan(GLint start = 0);
         void drawArrays(GLenum mode, GLint start, GLsizei count);
         void drawElements(GLenum mode, GLsizei count, GLenum type, const void* offset = nullptr);
@@ -434,6 +550,7 @@ namespace dynamit
         void translate4f(const std::array<float, 4>& trans);
         void lightDirection3f(float x, float y, float z);
         void lightDirection3f(const std::array<float, 3>& dir);
+        void variable1f(const std::string& name, float value);
         void updateVertices(const std::vector<float>& newData);
         void updateVertices(const float* data, size_t count);
 
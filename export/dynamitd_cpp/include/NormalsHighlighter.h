@@ -48,9 +48,12 @@ class NormalsHighlighter : public Shape
     std::array<float, 3> colorEnd = { 1.0f, 1.0f, 0.0f };
 
     void generateLinesFromVertsNorms(
-        const std::vector<float>& verts,
-        const std::vector<float>& norms,
+        const float* verts,
+        const float* norms,
+        size_t count,
+        size_t stride,
         float length);
+    void upload();
 
 public:
     NormalsHighlighter(float length = 0.1f);
@@ -66,6 +69,9 @@ public:
 
     // Build from vertex/normal data
     void build(const std::vector<float>& verts, const std::vector<float>& norms);
+    // Build from interleaved data: count records of stride floats,
+    // position and normal at the given float offsets
+    void build(const float* data, size_t count, size_t stride, size_t vertexOffset, size_t normalOffset);
 
     // Draw with transform matrix
     void draw(const float* transform);
@@ -6,9 +6,13 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <array>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
 #include <iostream>
 
 #include "geometry.h"
+#include "meshopt.h"
 namespace dynamit::builders
 {
 using namespace dynamit::geo;
@@ -30,6 +34,171 @@ struct GeometryBuffers
         : verts(v), norms(n), texCoords(t), colors(c), indices(i) {}
 };
 
+// Index that ends a triangle strip of strips() output: Dynamit draws strips with
+// GL_PRIMITIVE_RESTART and this restart index for GL_UNSIGNED_INT
+constexpr uint32_t RestartIndex = 0xFFFFFFFFu;
+
+// Exact output size of an indexed build for the current settings, both coats
+// included: vertices * 3 floats of positions and of normals, * 2 of texCoords,
+// * 4 of colors, and indices uint32_t
+struct BuildPlan
+{
+    size_t vertices = 0;
+    size_t indices = 0;
+};
+
+// Caller owned output of an indexed build, such as a buffer mapped with
+// glMapBufferRange: each array has room for vertexCapacity vertices (indexCapacity
+// indices) and is only written, never read. A null vertex array is not written.
+// Indices count from baseVertex, for shapes packed after others in one buffer.
+// stride 0 packs each array (3, 3, 2, 4 floats a vertex); otherwise every array
+// steps stride floats a vertex, the arrays pointing into one interleaved record.
+struct GeometrySpans
+{
+    float* verts = nullptr;
+    float* norms = nullptr;
+    float* texCoords = nullptr;
+    float* colors = nullptr;
+    uint32_t* indices = nullptr;
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
+    uint32_t baseVertex = 0;
+    size_t stride = 0;
+};
+
+// Axis-aligned box in the builder's local space, before any transform
+struct AABB
+{
+    std::array<float, 3> min = { 0.0f, 0.0f, 0.0f };
+    std::array<float, 3> max = { 0.0f, 0.0f, 0.0f };
+};
+
+// One interleaved vertex record: position (3 floats), then normal (3), texCoord (2)
+// and color (4) when present, the order and sizes of Dynamit's withStrideVertices /
+// Normals / TexCoords / Colors. Offsets and stride in floats, -1 for left out.
+struct InterleavedLayout
+{
+    int stride = 6;
+    int vertex = 0;
+    int normal = 3;
+    int texCoord = -1;
+    int color = -1;
+
+    static InterleavedLayout of(bool normals, bool texCoords, bool colors)
+    {
+        InterleavedLayout layout;
+        layout.stride = 3;
+        layout.normal = normals ? layout.stride : -1;
+        layout.stride += normals ? 3 : 0;
+        layout.texCoord = texCoords ? layout.stride : -1;
+        layout.stride += texCoords ? 2 : 0;
+        layout.color = colors ? layout.stride : -1;
+        layout.stride += colors ? 4 : 0;
+        return layout;
+    }
+};
+
+// Output of the interleaved builds, one vertex stream and its indices;
+// Dynamit::withInterleaved takes it as one VBO
+struct InterleavedGeometry
+{
+    InterleavedLayout layout;
+    std::vector<float> data;
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const { return data.size() / layout.stride; }
+};
+
+// Packed attribute formats of quantize(): Float32 keeps the attribute as built,
+// None leaves it out. Positions: Half (GL_HALF_FLOAT) or Snorm16 (GL_SHORT normalized,
+// in the layout's box). Normals: Octahedral16, two snorm16. TexCoords: Half.
+// Colors: Unorm8 (GL_UNSIGNED_BYTE normalized).
+enum class VertexFormat
+{
+    None,
+    Float32,
+    Half,
+    Snorm16,
+    Octahedral16,
+    Unorm8
+};
+
+// Formats, then the byte offsets (-1 for left out) and stride quantize() writes.
+// Every attribute starts on 4 bytes: a three component half or snorm16 position
+// takes 8. Snorm16 positions decode as stored * box half size + box center; the box
+// is taken from the first geometry quantized unless fixedBox is set (several shapes
+// in one stream need one box, e.g. PolarBuilder::bounds() of the largest).
+struct QuantizedLayout
+{
+    VertexFormat position = VertexFormat::Snorm16;
+    VertexFormat normal = VertexFormat::Octahedral16;
+    VertexFormat texCoord = VertexFormat::None;
+    VertexFormat color = VertexFormat::None;
+    AABB box;
+    bool fixedBox = false;
+
+    int vertexOffset = 0;
+    int normalOffset = -1;
+    int texCoordOffset = -1;
+    int colorOffset = -1;
+    int stride = 0;
+
+    // shader decode of Snorm16 positions: position = stored * scale + offset
+    std::array<float, 3> scale() const;
+    std::array<float, 3> offset() const;
+};
+
+// Packed vertex stream and its indices; Dynamit::withQuantized takes it as one VBO
+// and generates the decode in the vertex shader
+struct QuantizedGeometry
+{
+    QuantizedLayout layout;
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const { return layout.stride ? data.size() / layout.stride : 0; }
+};
+
+// Appends geometry to out in out.layout's formats, its indices moved past the
+// vertices out already has. Attributes the layout wants must be in geometry; the
+// first call fixes the offsets and stride. Throws on positions outside the box.
+void quantize(const InterleavedGeometry& geometry, QuantizedGeometry& out);
+
+// One level of detail of a multi-LOD build: a range of the shared index buffer
+// (in indices, not bytes) and the sectors and slices it draws. Level 0 is finest.
+struct LodRange
+{
+    size_t firstIndex = 0;
+    size_t indexCount = 0;
+    int sectors = 0;
+    int slices = 0;
+};
+
+class BuildSink;
+struct RingSamples;
+
+// Counters of the process-wide compiled formula cache shared by all builders
+struct FormulaCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+};
+
+// Vertex shader half of a GPU generated polar shape, see Dynamit::withGeneratedVertices
+// glsl defines void generateVertex(vec2 grid, out vec3 position, out vec3 normal),
+// grid is (sector, ring) as written by buildConeGrid / buildCylinderGrid
+struct PolarShaderSource
+{
+    std::string glsl;
+    std::vector<std::string> variables;  // formula variables besides theta, uniform float in the shader
+};
+
+// Formula compiled ahead of time by the C++ compiler instead of parsed at run time
+// (Dynamit Designer exports it): fills r[i] = r(theta[i]), and dr[i] = dr/dtheta
+// unless dr is null, for n samples. Called once per ring, not once per vertex.
+using CompiledFormula = std::function<void(const double* theta, double* r, double* dr, size_t n)>;
+
 //// 4x4 transformation matrix (column-major, like GLM)
 //using Matrix4 = std::array<float, 16>;
 //template<typename T = float> using mat4 = std::array<T, 16>;
@@ -42,6 +211,14 @@ public:
 
     PolarBuilder& formula(const std::wstring& formula);
     PolarBuilder& formula(const std::string& formula);
+    // r(theta), and dr/dtheta for smooth builds, as callables (double -> double):
+    // nothing is parsed and the calls inline into the ring loop. bounds() and the
+    // shader sources still need a formula string.
+    template<typename R, typename = std::enable_if_t<std::is_invocable_r_v<double, R, double>>>
+    PolarBuilder& formula(R r);
+    template<typename R, typename DR, typename = std::enable_if_t<std::is_invocable_r_v<double, R, double>>>
+    PolarBuilder& formula(R r, DR dr);
+    PolarBuilder& compiledFormula(CompiledFormula compiled);
     PolarBuilder& domain(float start, float end);
     PolarBuilder& domain(float end);
     PolarBuilder& domain_shift(float new_end);
@@ -56,11 +233,39 @@ public:
     PolarBuilder& singleCoated(bool enabled = true);
     PolarBuilder& reversed(bool enabled = true);
     PolarBuilder& nonreversed(bool enabled = true);
+    // Indexed builds split their slices over this many threads, 1 (default) builds
+    // on the calling thread, 0 uses every hardware thread. The output is the same
+    // for any count.
+    PolarBuilder& threads(int count);
+    // Adaptive sectors: of the sectors() grid keep only the samples the outline needs
+    // to stay within tolerance (formula units, at the widest ring) of the true curve.
+    // Samples gather where the curve bends, from r, dr/dtheta and d2r/dtheta2. 0 (the
+    // default) keeps every sector. GPU grids (buildConeGrid, ...) stay uniform.
+    PolarBuilder& adaptive(float tolerance);
+    // Sectors the builds make: sectors(), or the samples adaptive() kept less one
+    int sectorCount() const;
+    // Indexed builds into vectors and interleaved streams reorder their triangles for
+    // the vertex cache and then their vertices for fetch (meshopt.h), same triangles
+    // and winding. Span builds are left as built: mapped memory is not read back.
+    PolarBuilder& optimized(bool enabled = true);
+    // Smooth indexed builds emit one GL_TRIANGLE_STRIP per slice, the cone's tip fan
+    // as one more, each ended by RestartIndex: the same triangles and winding in about
+    // a third of the indices. Draw with withPrimitive(GL_TRIANGLE_STRIP). Applies to
+    // the grids and levels of detail too; optimized() leaves strips in ring order.
+    // Edged indexed builds throw, their triangles share no vertices.
+    PolarBuilder& strips(bool enabled = true);
+    // Double coated builds emit the outer coat alone and the inner one is its back
+    // faces: draw with Dynamit::withTwoSided(innerColor()), which flips their normals
+    // and colours them in the fragment shader. Half the vertices and build time.
+    PolarBuilder& twoSided(bool enabled = true);
+    // Vertices and ACMR of the last optimized build, before and after
+    const meshopt::MeshStats& optimizationStats() const { return m_optimizationStats; }
     //PolarBuilder& color(float r, float g, float b, float a = 1.0f) { m_color_outer = { r, g, b, a }; return *this; }
 	PolarBuilder& color(const std::array<float, 4>& rgba) { m_color_outer = rgba; m_color_inner = rgba; return *this; }
     PolarBuilder& color(const std::array<float, 3>& rgb) { m_color_outer = { rgb[0], rgb[1], rgb[2], 1.0f }; m_color_inner = { rgb[0], rgb[1], rgb[2], 1.0f }; return *this; }
     PolarBuilder& color(const std::array<float, 4>& rgbao, const std::array<float, 4>& rgbai) { m_color_outer = rgbao; m_color_inner = rgbai; return *this; }
     PolarBuilder& color(const std::array<float, 3>& rgbo, const std::array<float, 3>& rgbi) { m_color_outer = { rgbo[0], rgbo[1], rgbo[2], 1.0f }; m_color_inner = { rgbi[0], rgbi[1], rgbi[2], 1.0f }; return *this; }
+    const std::array<float, 4>& innerColor() const { return m_color_inner; }
 
     // Cone - base (no transform)
     PolarBuilder& buildCone(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& texCoords);
@@ -123,17 +328,68 @@ public:
     PolarBuilder& buildCylinderIndexedWithColor(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& colors, std::vector<uint32_t>& indices, const Transforms & ...transforms);
     PolarBuilder& buildConeIndexedWithColor(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& colors, std::vector<uint32_t>& indices);
     PolarBuilder& buildCylinderIndexedWithColor(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& colors, std::vector<uint32_t>& indices);
+
+    // Exact size of buildConeIndexedWithColor / buildCylinderIndexedWithColor and
+    // of the span builds below (smooth or edged as set), before building anything
+    BuildPlan planCone() const;
+    BuildPlan planCylinder() const;
+    // Build into caller owned arrays of at least plan size, throws when they are
+    // smaller; the vectors of the other overloads are reserved from the same plan
+    PolarBuilder& buildConeIndexed(const GeometrySpans& out);
+    PolarBuilder& buildCylinderIndexed(const GeometrySpans& out);
+    // Append to one interleaved stream, writing the attributes out.layout has
+    PolarBuilder& buildConeInterleaved(InterleavedGeometry& out);
+    PolarBuilder& buildCylinderInterleaved(InterleavedGeometry& out);
+    // Built as the interleaved stream, then packed into out.layout's formats (quantize)
+    PolarBuilder& buildConeQuantized(QuantizedGeometry& out);
+    PolarBuilder& buildCylinderQuantized(QuantizedGeometry& out);
+    // Multi-LOD: the smooth grid is evaluated and appended once, then up to levels
+    // index ranges into it, level k drawing every 2^k-th sector and slice. Levels
+    // stop where sectors or slices no longer halve evenly, or under 3 sectors.
+    // Ranges are appended to lods; edged builds throw, they share no vertices.
+    PolarBuilder& buildConeLods(InterleavedGeometry& out, std::vector<LodRange>& lods, int levels);
+    PolarBuilder& buildCylinderLods(InterleavedGeometry& out, std::vector<LodRange>& lods, int levels);
+
+    // A rebuild that changes only colour, transform or tessellation is a hit
+    static FormulaCacheStats formulaCacheStats();
+
+    // Guaranteed box of the generated mesh from interval evaluation of the formula
+    // over the domain, no geometry is built. bounds() holds the cone or the cylinder
+    // (the cone tip sits at the origin), cylinderBounds() is tighter for cylinders.
+    // Unbounded formulas (a pole inside the domain) give infinite sides.
+    AABB bounds() const;
+    AABB cylinderBounds() const;
+
+    // GPU generation: a static (sector, ring) grid with the index order of
+    // buildConeIndexed / buildCylinderIndexed, and the shader source computing
+    // the same positions and smooth normals from the formula and its derivative.
+    // Formula variables besides theta (time, ...) become uniforms. Single coat.
+    PolarBuilder& buildConeGrid(std::vector<float>& grid, std::vector<uint32_t>& indices);
+    PolarBuilder& buildCylinderGrid(std::vector<float>& grid, std::vector<uint32_t>& indices);
+    PolarShaderSource coneShader() const;
+    PolarShaderSource cylinderShader() const;
 private:
-    PolarBuilder& buildConeIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat);
+    PolarShaderSource shaderSource(bool cone) const;
+    int threadCount() const;
+    void sampleSectors(RingSamples& ring, bool withDerivative) const;
+    BuildPlan planIndexed(bool cone, bool smooth, bool strips, int sectors) const;
+    PolarBuilder& buildIndexed(bool cone, const GeometrySpans& out, const RingSamples& ring);
+    PolarBuilder& buildLods(bool cone, InterleavedGeometry& out, std::vector<LodRange>& lods, int levels);
+    PolarBuilder& buildConeIndexedInternal(BuildSink& sink, const RingSamples& ring, bool strips, bool isSecondCoat);
     PolarBuilder& buildConeDiscrete(GeometryBuffers& buffers);
-    PolarBuilder& buildConeDiscreteInternal(GeometryBuffers& buffers, bool isSecondCoat);
-    PolarBuilder& buildCylinderIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat);
+    PolarBuilder& buildConeDiscreteInternal(GeometryBuffers& buffers, const RingSamples& ring, bool isSecondCoat);
+    PolarBuilder& buildCylinderIndexedInternal(BuildSink& sink, const RingSamples& ring, bool strips, bool isSecondCoat);
     PolarBuilder& buildCylinderDiscrete(GeometryBuffers& buffers);
-    PolarBuilder& buildCylinderDiscreteInternal(GeometryBuffers& buffers, bool isSecondCoat);
-    PolarBuilder& buildCylinderDiscreteIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat);
-    PolarBuilder& buildConeDiscreteIndexedInternal(GeometryBuffers& buffers, bool isSecondCoat);
+    PolarBuilder& buildCylinderDiscreteInternal(GeometryBuffers& buffers, const RingSamples& ring, bool isSecondCoat);
+    PolarBuilder& buildCylinderDiscreteIndexedInternal(BuildSink& sink, const RingSamples& ring, bool isSecondCoat);
+    PolarBuilder& buildConeDiscreteIndexedInternal(BuildSink& sink, const RingSamples& ring, bool isSecondCoat);
+    PolarBuilder& finishIndexed(GeometryBuffers& buffers, size_t firstVertex, size_t firstIndex);
+    PolarBuilder& finishInterleaved(InterleavedGeometry& out, size_t firstVertex, size_t firstIndex);
+    // The inner coat is built as geometry: doubleCoated and not twoSided
+    bool secondCoat() const { return m_doubleCoated && !m_twoSided; }
 
     std::wstring m_formula;
+    CompiledFormula m_compiledFormula;  // replaces m_formula when set
     float m_domainStart;
     float m_domainEnd;
     int m_sectors;
@@ -142,6 +398,12 @@ private:
     bool m_smooth;
     bool m_doubleCoated;
     bool m_reversed;
+    int m_threads;
+    float m_tolerance;
+    bool m_optimized;
+    bool m_strips;
+    bool m_twoSided;
+    meshopt::MeshStats m_optimizationStats;
     std::array<float, 4> m_color_outer = { 1.0f, 1.0f, 1.0f, 1.0f };
     std::array<float, 4> m_color_inner = { 1.0f, 1.0f, 1.0f, 1.0f };
 };
@@ -150,6 +412,30 @@ private:
 // VARIADIC TEMPLATE IMPLEMENTATIONS (must be in header)
 // ============================================================================
 
+// Compiled formulas
+template<typename R, typename>
+PolarBuilder& PolarBuilder::formula(R r)
+{
+    return compiledFormula([r](const double* theta, double* out_r, double* out_dr, size_t n) {
+        if (out_dr)
+            throw std::runtime_error("Compiled formula has no derivative, smooth shapes need formula(r, dr)");
+        for (size_t i = 0; i < n; i++)
+            out_r[i] = r(theta[i]);
+    });
+}
+
+template<typename R, typename DR, typename>
+PolarBuilder& PolarBuilder::formula(R r, DR dr)
+{
+    return compiledFormula([r, dr](const double* theta, double* out_r, double* out_dr, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            out_r[i] = r(theta[i]);
+        if (out_dr)
+            for (size_t i = 0; i < n; i++)
+                out_dr[i] = dr(theta[i]);
+    });
+}
+
 // Cone with transforms
 template<typename... Transforms>
 PolarBuilder& PolarBuilder::buildCone(std::vector<float>& verts, std::vector<float>& norms, std::vector<float>& texCoords, const Transforms&... transforms)
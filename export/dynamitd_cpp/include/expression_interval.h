@@ -0,0 +1,310 @@
+#pragma once
+#ifndef __EXPRESSION_INTERVAL_H__
+#define __EXPRESSION_INTERVAL_H__
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace expresie_tokenizer
+{
+//========================================
+// Interval - closed range [lo, hi] of values an expression can take
+// Used for conservative bounds: every value eval() can return for inputs
+// inside the argument intervals lies inside the result interval
+//========================================
+template <typename T>
+struct basic_interval
+{
+	T lo = 0;
+	T hi = 0;
+
+	basic_interval() {}
+	basic_interval(T value) : lo(value), hi(value) {}
+	basic_interval(T low, T high) : lo(low), hi(high) {}
+
+	bool contains(T x) const { return lo <= x && x <= hi; }
+	bool is_point() const { return lo == hi; }
+	T width() const { return hi - lo; }
+
+	static basic_interval whole()
+	{
+		return basic_interval(-std::numeric_limits<T>::infinity(), std::numeric_limits<T>::infinity());
+	}
+	static basic_interval empty()
+	{
+		return basic_interval(std::numeric_limits<T>::quiet_NaN(), std::numeric_limits<T>::quiet_NaN());
+	}
+};
+
+namespace intervals
+{
+//========================================
+// Rounding - results are pushed one ulp outwards, so the float
+// rounding of +, -, *, / and of the libm functions stays inside
+//========================================
+template <typename T>
+inline basic_interval<T> outward(basic_interval<T> a)
+{
+	return basic_interval<T>(
+		std::nextafter(a.lo, -std::numeric_limits<T>::infinity()),
+		std::nextafter(a.hi, std::numeric_limits<T>::infinity()));
+}
+
+template <typename T>
+inline basic_interval<T> hull(basic_interval<T> a, basic_interval<T> b)
+{
+	return basic_interval<T>(std::min(a.lo, b.lo), std::max(a.hi, b.hi));
+}
+
+template <typename T>
+inline basic_interval<T> clamp(basic_interval<T> a, T low, T high)
+{
+	return basic_interval<T>(std::max(a.lo, low), std::min(a.hi, high));
+}
+
+template <typename T>
+inline basic_interval<T> sorted(T a, T b)
+{
+	return (a <= b) ? basic_interval<T>(a, b) : basic_interval<T>(b, a);
+}
+
+// Does [lo, hi] hold phase + k * period for some integer k
+template <typename T>
+inline bool hits_phase(basic_interval<T> a, T phase, T period)
+{
+	T k = std::ceil((a.lo - phase) / period);
+	T p = phase + k * period;
+	// leaning inclusive: a peak counted by mistake only loosens the bound
+	T slack = std::numeric_limits<T>::epsilon() * T(8) * std::max(T(1), std::fabs(p));
+	return p <= a.hi + slack || phase + (k - 1) * period >= a.lo - slack;
+}
+
+template <typename T> inline T pi() { return T(3.141592653589793238462643383279502884L); }
+
+//========================================
+// Arithmetic
+//========================================
+template <typename T>
+inline basic_interval<T> neg(basic_interval<T> a)
+{
+	return basic_interval<T>(-a.hi, -a.lo);
+}
+
+template <typename T>
+inline basic_interval<T> add(basic_interval<T> a, basic_interval<T> b)
+{
+	return outward(basic_interval<T>(a.lo + b.lo, a.hi + b.hi));
+}
+
+template <typename T>
+inline basic_interval<T> sub(basic_interval<T> a, basic_interval<T> b)
+{
+	return outward(basic_interval<T>(a.lo - b.hi, a.hi - b.lo));
+}
+
+// 0 * inf is 0 here, an end point at infinity is a limit, not a value
+template <typename T>
+inline T mul_bound(T x, T y)
+{
+	return (x == 0 || y == 0) ? T(0) : x * y;
+}
+
+template <typename T>
+inline basic_interval<T> mul(basic_interval<T> a, basic_interval<T> b)
+{
+	T p1 = mul_bound(a.lo, b.lo), p2 = mul_bound(a.lo, b.hi);
+	T p3 = mul_bound(a.hi, b.lo), p4 = mul_bound(a.hi, b.hi);
+	return outward(basic_interval<T>(std::min(std::min(p1, p2), std::min(p3, p4)), std::max(std::max(p1, p2), std::max(p3, p4))));
+}
+
+template <typename T>
+inline basic_interval<T> div(basic_interval<T> a, basic_interval<T> b)
+{
+	if (b.contains(T(0))) return basic_interval<T>::whole();
+	return mul(a, outward(basic_interval<T>(T(1) / b.hi, T(1) / b.lo)));
+}
+
+// Integer exponent: even powers fold the negative side over
+template <typename T>
+inline basic_interval<T> powi(basic_interval<T> a, long long n)
+{
+	if (n == 0) return basic_interval<T>(T(1));
+	if (n < 0) return div(basic_interval<T>(T(1)), powi(a, -n));
+	T l = std::pow(a.lo, static_cast<T>(n)), h = std::pow(a.hi, static_cast<T>(n));
+	if (n % 2 != 0) return outward(basic_interval<T>(l, h));
+	if (a.lo >= 0) return outward(basic_interval<T>(l, h));
+	if (a.hi <= 0) return outward(basic_interval<T>(h, l));
+	return outward(basic_interval<T>(T(0), std::max(l, h)));
+}
+
+// a ** b = exp(b * ln a): b * ln a is bilinear, so for a >= 0 the extremes sit on the corners
+template <typename T>
+inline basic_interval<T> pow(basic_interval<T> a, basic_interval<T> b)
+{
+	if (b.is_point() && std::floor(b.lo) == b.lo && std::fabs(b.lo) < T(1 << 30))
+		return powi(a, static_cast<long long>(b.lo));
+	if (a.lo < 0 || (a.lo == 0 && b.lo <= 0)) return basic_interval<T>::whole();
+	T p1 = std::pow(a.lo, b.lo), p2 = std::pow(a.lo, b.hi);
+	T p3 = std::pow(a.hi, b.lo), p4 = std::pow(a.hi, b.hi);
+	basic_interval<T> r(std::min(std::min(p1, p2), std::min(p3, p4)), std::max(std::max(p1, p2), std::max(p3, p4)));
+	return clamp(outward(r), T(0), std::numeric_limits<T>::infinity());
+}
+
+//========================================
+// Functions - one per function_registry entry
+//========================================
+template <typename T>
+inline basic_interval<T> sin(basic_interval<T> a)
+{
+	if (!(a.width() < 2 * pi<T>())) return basic_interval<T>(T(-1), T(1));
+	basic_interval<T> r = outward(sorted(std::sin(a.lo), std::sin(a.hi)));
+	if (hits_phase(a, pi<T>() / 2, 2 * pi<T>())) r.hi = T(1);
+	if (hits_phase(a, -pi<T>() / 2, 2 * pi<T>())) r.lo = T(-1);
+	return clamp(r, T(-1), T(1));
+}
+
+template <typename T>
+inline basic_interval<T> cos(basic_interval<T> a)
+{
+	if (!(a.width() < 2 * pi<T>())) return basic_interval<T>(T(-1), T(1));
+	basic_interval<T> r = outward(sorted(std::cos(a.lo), std::cos(a.hi)));
+	if (hits_phase(a, T(0), 2 * pi<T>())) r.hi = T(1);
+	if (hits_phase(a, pi<T>(), 2 * pi<T>())) r.lo = T(-1);
+	return clamp(r, T(-1), T(1));
+}
+
+template <typename T>
+inline basic_interval<T> tan(basic_interval<T> a)
+{
+	if (!(a.width() < pi<T>()) || hits_phase(a, pi<T>() / 2, pi<T>())) return basic_interval<T>::whole();
+	return outward(basic_interval<T>(std::tan(a.lo), std::tan(a.hi)));
+}
+
+template <typename T>
+inline basic_interval<T> sqrt(basic_interval<T> a)
+{
+	if (a.hi < 0) return basic_interval<T>::empty();
+	basic_interval<T> r = outward(basic_interval<T>(std::sqrt(std::max(a.lo, T(0))), std::sqrt(a.hi)));
+	return clamp(r, T(0), std::numeric_limits<T>::infinity());
+}
+
+template <typename T>
+inline basic_interval<T> exp(basic_interval<T> a)
+{
+	basic_interval<T> r = outward(basic_interval<T>(std::exp(a.lo), std::exp(a.hi)));
+	return clamp(r, T(0), std::numeric_limits<T>::infinity());
+}
+
+template <typename T>
+inline basic_interval<T> log(basic_interval<T> a)
+{
+	if (a.hi < 0) return basic_interval<T>::empty();
+	T low = (a.lo > 0) ? std::log(a.lo) : -std::numeric_limits<T>::infinity();
+	return outward(basic_interval<T>(low, std::log(a.hi)));
+}
+
+template <typename T>
+inline basic_interval<T> abs(basic_interval<T> a)
+{
+	if (a.lo >= 0) return a;
+	if (a.hi <= 0) return neg(a);
+	return basic_interval<T>(T(0), std::max(-a.lo, a.hi));
+}
+
+template <typename T>
+inline basic_interval<T> asin(basic_interval<T> a)
+{
+	if (a.hi < -1 || a.lo > 1) return basic_interval<T>::empty();
+	a = clamp(a, T(-1), T(1));
+	return clamp(outward(basic_interval<T>(std::asin(a.lo), std::asin(a.hi))), -pi<T>() / 2, pi<T>() / 2);
+}
+
+template <typename T>
+inline basic_interval<T> acos(basic_interval<T> a)
+{
+	if (a.hi < -1 || a.lo > 1) return basic_interval<T>::empty();
+	a = clamp(a, T(-1), T(1));
+	return clamp(outward(basic_interval<T>(std::acos(a.hi), std::acos(a.lo))), T(0), pi<T>());
+}
+
+template <typename T>
+inline basic_interval<T> atan(basic_interval<T> a)
+{
+	return clamp(outward(basic_interval<T>(std::atan(a.lo), std::atan(a.hi))), -pi<T>() / 2, pi<T>() / 2);
+}
+
+template <typename T>
+inline basic_interval<T> sinh(basic_interval<T> a)
+{
+	return outward(basic_interval<T>(std::sinh(a.lo), std::sinh(a.hi)));
+}
+
+template <typename T>
+inline basic_interval<T> cosh(basic_interval<T> a)
+{
+	basic_interval<T> m = abs(a);
+	return clamp(outward(basic_interval<T>(std::cosh(m.lo), std::cosh(m.hi))), T(1), std::numeric_limits<T>::infinity());
+}
+
+template <typename T>
+inline basic_interval<T> tanh(basic_interval<T> a)
+{
+	return clamp(outward(basic_interval<T>(std::tanh(a.lo), std::tanh(a.hi))), T(-1), T(1));
+}
+
+// floor, ceil and round are exact and non-decreasing, no widening needed
+template <typename T>
+inline basic_interval<T> floor(basic_interval<T> a)
+{
+	return basic_interval<T>(std::floor(a.lo), std::floor(a.hi));
+}
+
+template <typename T>
+inline basic_interval<T> ceil(basic_interval<T> a)
+{
+	return basic_interval<T>(std::ceil(a.lo), std::ceil(a.hi));
+}
+
+template <typename T>
+inline basic_interval<T> round(basic_interval<T> a)
+{
+	return basic_interval<T>(std::round(a.lo), std::round(a.hi));
+}
+
+// atan2(y, x) is atan(y / x) on the right half plane, otherwise anything in [-pi, pi]
+template <typename T>
+inline basic_interval<T> atan2(basic_interval<T> y, basic_interval<T> x)
+{
+	if (x.lo > 0) return atan(div(y, x));
+	return outward(basic_interval<T>(-pi<T>(), pi<T>()));
+}
+
+// |fmod(a, b)| < |b| and <= |a|, with the sign of a
+template <typename T>
+inline basic_interval<T> fmod(basic_interval<T> a, basic_interval<T> b)
+{
+	if (b.contains(T(0))) return basic_interval<T>::whole();
+	basic_interval<T> m = abs(b);
+	if (a.lo >= 0 && a.hi < m.lo) return a;
+	if (a.hi <= 0 && -a.lo < m.lo) return a;
+	T low = (a.lo >= 0) ? T(0) : std::max(a.lo, -m.hi);
+	T high = (a.hi <= 0) ? T(0) : std::min(a.hi, m.hi);
+	return basic_interval<T>(low, high);
+}
+
+template <typename T>
+inline basic_interval<T> min(basic_interval<T> a, basic_interval<T> b)
+{
+	return basic_interval<T>(std::min(a.lo, b.lo), std::min(a.hi, b.hi));
+}
+
+template <typename T>
+inline basic_interval<T> max(basic_interval<T> a, basic_interval<T> b)
+{
+	return basic_interval<T>(std::max(a.lo, b.lo), std::max(a.hi, b.hi));
+}
+
+} // namespace intervals
+} // namespace expresie_tokenizer
+#endif
@@ -1,9 +1,11 @@
 #pragma once
 #ifndef __SYNTAX_TREE_H__
 #define __SYNTAX_TREE_H__
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 namespace expresie_tokenizer
 {
 
@@ -113,5 +115,125 @@ public:
 		return alphabet_starts.count(c)  > 0;
 	}
 };
+
+//========================================
+// syntax_automaton - frozen, array based syntax_tree
+//========================================
+// Built once from a syntax_tree::merge(...) result and read only afterwards.
+// States are numbered breadth first, the root is state 0. ASCII transitions
+// live in a dense [state][character class] table, where the classes are the
+// distinct ASCII characters of the alphabet and class 0 means "no edge".
+// Other characters go through a sorted per state edge list.
+class syntax_automaton
+{
+public:
+	using search_result = syntax_tree::search_result;
+	static constexpr unsigned int none = 0xFFFFFFFFu;  // no transition
+
+private:
+	struct sparse_edge { wchar_t c; unsigned int target; };
+
+	unsigned char ascii_class_[128] = {};
+	unsigned int class_count_ = 1;
+	std::vector<unsigned int> dense_;         // state * class_count_ + class -> state
+	std::vector<unsigned int> sparse_begin_;  // state -> first edge in sparse_, state + 1 -> end
+	std::vector<sparse_edge> sparse_;
+	std::vector<unsigned char> final_;
+	std::vector<wchar_t> wide_alphabet_;      // sorted non ASCII alphabet
+
+	static bool is_ascii(wchar_t c) { return static_cast<unsigned int>(c) < 128u; }
+
+public:
+	static syntax_automaton freeze(const syntax_tree& tree)
+	{
+		struct edge { unsigned int from; wchar_t c; unsigned int to; };
+		syntax_automaton a;
+		std::vector<const syntax_tree*> nodes(1, &tree);
+		std::vector<edge> edges;
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			for (const std::pair<const wchar_t, syntax_tree>& child : nodes[i]->children)
+			{
+				wchar_t c = child.first;
+				edges.push_back({ static_cast<unsigned int>(i), c, static_cast<unsigned int>(nodes.size()) });
+				nodes.push_back(&child.second);
+				if (!is_ascii(c))
+					a.wide_alphabet_.push_back(c);
+				else if (a.ascii_class_[c] == 0)
+					a.ascii_class_[c] = static_cast<unsigned char>(a.class_count_++);
+			}
+		}
+		std::sort(a.wide_alphabet_.begin(), a.wide_alphabet_.end());
+		a.wide_alphabet_.erase(std::unique(a.wide_alphabet_.begin(), a.wide_alphabet_.end()), a.wide_alphabet_.end());
+
+		a.final_.resize(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++) a.final_[i] = nodes[i]->final;
+
+		// Edges come out grouped by state and sorted by character (std::map order)
+		a.dense_.assign(nodes.size() * a.class_count_, none);
+		a.sparse_begin_.assign(nodes.size() + 1, 0);
+		for (const edge& e : edges)
+		{
+			if (is_ascii(e.c))
+				a.dense_[e.from * a.class_count_ + a.ascii_class_[e.c]] = e.to;
+			else
+			{
+				a.sparse_.push_back({ e.c, e.to });
+				a.sparse_begin_[e.from + 1]++;
+			}
+		}
+		for (size_t i = 1; i < a.sparse_begin_.size(); i++) a.sparse_begin_[i] += a.sparse_begin_[i - 1];
+		return a;
+	}
+
+	unsigned int root() const { return 0; }
+	unsigned int step(unsigned int state, wchar_t c) const
+	{
+		if (is_ascii(c)) return dense_[state * class_count_ + ascii_class_[c]];
+		const sparse_edge* first = sparse_.data() + sparse_begin_[state];
+		const sparse_edge* last = sparse_.data() + sparse_begin_[state + 1];
+		const sparse_edge* it = std::lower_bound(first, last, c, [](const sparse_edge& e, wchar_t x) { return e.c < x; });
+		return (it != last && it->c == c) ? it->target : none;
+	}
+	bool is_final(unsigned int state) const { return final_[state] != 0; }
+	size_t state_count() const { return final_.size(); }
+	size_t memory_bytes() const
+	{
+		return sizeof(*this) + dense_.size() * sizeof(unsigned int) + sparse_begin_.size() * sizeof(unsigned int)
+			+ sparse_.size() * sizeof(sparse_edge) + final_.size() + wide_alphabet_.size() * sizeof(wchar_t);
+	}
+
+	// Same walk and result as syntax_tree::find
+	search_result find(const wchar_t* str, size_t length, size_t start = 0) const
+	{
+		search_result sr = {};
+		unsigned int state = root();
+		for (size_t i = start; i < length; i++)
+		{
+			state = step(state, str[i]);
+			if (state == none) return sr;
+			sr.iterated++;
+			sr.final = is_final(state);
+			if (sr.final) sr.partial_finish = sr.final;
+			if (sr.iterated == length)
+				sr.found = true;
+		}
+		return sr;
+	}
+	search_result find(const std::wstring& str, size_t start = 0) const
+	{
+		return find(str.c_str(), str.length(), start);
+	}
+
+	bool in_alphabet(wchar_t c) const
+	{
+		if (is_ascii(c)) return ascii_class_[c] != 0;
+		return std::binary_search(wide_alphabet_.begin(), wide_alphabet_.end(), c);
+	}
+	bool can_start(wchar_t c) const
+	{
+		return step(root(), c) != none;
+	}
+};
 }
 #endif
\ No newline at end of file